@@ -132,6 +132,8 @@ typedef struct rnp_key_store_t {
     pgp_key_store_format_t format;
     bool                   disable_validation =
       false; /* do not automatically validate keys, added to this key store */
+    size_t validation_threads =
+      1; /* threads to validate signatures of the loaded keys, 0 means all hardware threads */
 
     std::list<pgp_key_t> keys;
     pgp_key_fp_map_t     keybyfp;
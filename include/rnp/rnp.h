@@ -71,6 +71,12 @@ typedef uint32_t rnp_result_t;
 #define RNP_DUMP_RAW (1U << 1)
 #define RNP_DUMP_GRIP (1U << 2)
 
+/**
+ * Flags for the key list export function.
+ */
+#define RNP_KEY_LIST_JSON (1U << 0)
+#define RNP_KEY_LIST_NO_HEADER (1U << 1)
+
 /**
  * Flags for the key loading/saving functions.
  */
@@ -95,6 +101,12 @@ typedef uint32_t rnp_result_t;
  */
 #define RNP_OUTPUT_FILE_OVERWRITE (1U << 0)
 #define RNP_OUTPUT_FILE_RANDOM (1U << 1)
+#define RNP_OUTPUT_FILE_WRITE_BEHIND (1U << 2)
+
+/**
+ * Flags for input structure creation.
+ */
+#define RNP_INPUT_FILE_READ_AHEAD (1U << 0)
 
 /**
  * User id type
@@ -192,6 +204,9 @@ typedef struct rnp_uid_handle_st *         rnp_uid_handle_t;
 typedef struct rnp_signature_handle_st *   rnp_signature_handle_t;
 typedef struct rnp_recipient_handle_st *   rnp_recipient_handle_t;
 typedef struct rnp_symenc_handle_st *      rnp_symenc_handle_t;
+typedef struct rnp_recipient_set_st *      rnp_recipient_set_t;
+typedef struct rnp_signer_st *             rnp_signer_t;
+typedef struct rnp_digest_st *             rnp_digest_t;
 
 /* Callbacks */
 /**
@@ -340,6 +355,120 @@ RNP_API rnp_result_t rnp_ffi_set_pass_provider(rnp_ffi_t       ffi,
                                                rnp_password_cb getpasscb,
                                                void *          getpasscb_ctx);
 
+/** enable or disable buffering of the ffi's random number generator. When enabled, small
+ *  random data requests (session keys, IVs, salts and so on) are served from the buffer,
+ *  filled by the HMAC_DRBG in large blocks, instead of calling the DRBG each time. Used
+ *  bytes are securely wiped, DRBG is periodically reseeded from the system generator, and
+ *  buffer is dropped in the forked process. Buffering is disabled by default.
+ *
+ *  @param ffi the ffi object
+ *  @param buffered true to enable buffering, false to disable it.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_set_rng_buffered(rnp_ffi_t ffi, bool buffered);
+
+/** set the number of threads, used to validate self-signatures of the keys which are loaded
+ *  or imported via rnp_load_keys() and rnp_import_keys(). Each signature is still checked
+ *  separately, threads only share the work. By default keys are validated on the calling
+ *  thread.
+ *
+ *  @param ffi the ffi object
+ *  @param threads maximum number of threads, including the calling one. 0 means the number of
+ *         hardware threads. Less threads are used for the small keyrings.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_set_validation_threads(rnp_ffi_t ffi, size_t threads);
+
+/** enable or disable collection of the per-layer stream counters. When enabled, operations
+ *  created afterwards account the number of read/write calls, bytes passed, bytes copied via
+ *  the stream caches and time spent for each stream layer (file, memory, armored, encrypted,
+ *  compressed, literal, signed and so on). Time of the layer includes the time spent in the
+ *  layers below it. Counters are accumulated over all operations of the ffi object.
+ *  Collection is disabled by default.
+ *
+ *  @param ffi the ffi object
+ *  @param enabled true to enable collection, false to disable it.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_set_stream_stats(rnp_ffi_t ffi, bool enabled);
+
+/** get the per-layer stream counters, collected after the rnp_ffi_set_stream_stats() call.
+ *  JSON object has "read" and "write" fields, each of them lists stream layers which were
+ *  used, with fields "calls", "bytes", "copied" and "ns". I.e.:
+ *  {"read":{"file":{"calls":3,"bytes":131072,"copied":0,"ns":51230}, ...},"write":{...}}
+ *
+ *  @param ffi the ffi object
+ *  @param reset true to reset the counters after they are retrieved.
+ *  @param json on success JSON string will be stored here. It must be deallocated via
+ *         rnp_buffer_destroy() call.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_get_stream_stats(rnp_ffi_t ffi, bool reset, char **json);
+
+/** setup cache of the decrypted secret keys. Once protected key is unlocked to sign or
+ *  decrypt data, decrypted key material is kept in memory, so subsequent operations with
+ *  this key do not ask for the password and do not run the password derivation again.
+ *  Cache is disabled by default. Cached keys are securely wiped once they expire, run out of
+ *  uses, are flushed, or the key is removed, locked or unloaded from the keyring.
+ *
+ *  Note: expiration is lazy, there is no background timer. Expired keys are wiped on the
+ *  next cache access, i.e. when a protected key is unlocked or used for signing or decryption,
+ *  or when the cache is flushed or ffi is destroyed.
+ *
+ *  Note: changing cache parameters flushes all the cached keys.
+ *
+ *  @param ffi the ffi object
+ *  @param ttl number of seconds since the key unlock during which decrypted key is kept.
+ *         0 disables the cache.
+ *  @param max_uses number of operations for which cached key may be used, including the
+ *         one which unlocked the key. 0 means no limit.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_set_key_cache(rnp_ffi_t ffi, uint32_t ttl, uint32_t max_uses);
+
+/** remove the decrypted secret key(s) from the cache, set up via rnp_ffi_set_key_cache().
+ *
+ *  @param ffi the ffi object
+ *  @param key key to remove from the cache, for primary key its subkeys are removed as well.
+ *         If NULL then all keys are removed.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_flush_key_cache(rnp_ffi_t ffi, rnp_key_handle_t key);
+
+/** setup pool of the pre-generated keys for the algorithm and key size. Background thread
+ *  keeps the pool filled, so key generation with matching parameters takes already generated
+ *  key material and only needs to create the self-signatures. Each pre-generated key is used
+ *  only once, and is securely wiped if not used until the pool is shrunk or ffi is destroyed.
+ *  Pool is disabled by default.
+ *
+ *  Note: destroying ffi object waits for the key generation which is in progress.
+ *
+ *  @param ffi the ffi object
+ *  @param alg key algorithm. Only RSA, DSA and ElGamal are supported since generation of the
+ *         other ones is fast enough.
+ *  @param bits key size in bits.
+ *  @param size number of keys which are kept ready. 0 removes the pool for these parameters.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_set_key_pool(rnp_ffi_t   ffi,
+                                          const char *alg,
+                                          uint32_t    bits,
+                                          size_t      size);
+
+/** get number of the pre-generated keys, available in the pool set up via
+ *  rnp_ffi_set_key_pool().
+ *
+ *  @param ffi the ffi object
+ *  @param alg key algorithm.
+ *  @param bits key size in bits.
+ *  @param count number of available keys will be stored here. 0 if there is no such pool.
+ *  @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_ffi_get_key_pool_size(rnp_ffi_t   ffi,
+                                               const char *alg,
+                                               uint32_t    bits,
+                                               size_t *    count);
+
 /* Operations on key rings */
 
 /** retrieve the default homedir (example: /home/user/.rnp)
@@ -541,6 +670,35 @@ RNP_API rnp_result_t rnp_key_handle_destroy(rnp_key_handle_t key);
  */
 RNP_API rnp_result_t rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results);
 
+/** generate a number of keys, using JSON descriptions, on the pool of threads.
+ *
+ *  Notes:
+ *  - Each description must be in the format of rnp_generate_key_json(), and must contain
+ *    primary key, optionally with subkey. Subkey for the existing primary key may not be
+ *    generated in batch, use rnp_generate_key_json() instead.
+ *  - Keys are generated concurrently, while password provider is called and keys are added to
+ *    the keyrings on the calling thread, in the order of descriptions.
+ *
+ *  @param ffi
+ *  @param jsons array of count JSON key descriptions. Must not be NULL.
+ *  @param count number of descriptions.
+ *  @param threads maximum number of threads used, including the calling one. If 0 then number
+ *         of available CPU cores will be used.
+ *  @param keys array of count key handles, may be NULL. On success handle of the primary key
+ *         will be stored here, otherwise NULL. Caller must destroy non-NULL handles with
+ *         rnp_key_handle_destroy().
+ *  @param results array of count values, each one will be set to the result of the
+ *         corresponding key generation. Must not be NULL.
+ *  @return RNP_SUCCESS if batch was processed (see results for the per-key status), or any
+ *          other value on error.
+ */
+RNP_API rnp_result_t rnp_generate_keys_json(rnp_ffi_t         ffi,
+                                            const char **     jsons,
+                                            size_t            count,
+                                            size_t            threads,
+                                            rnp_key_handle_t *keys,
+                                            rnp_result_t *    results);
+
 /* Key operations */
 
 /** Shortcut function for rsa key-subkey pair generation. See rnp_generate_key_ex() for the
@@ -1673,6 +1831,8 @@ RNP_API rnp_result_t rnp_key_get_protection_iterations(rnp_key_handle_t key,
  *  performing any operations involving the secret key material.
  *
  *  Generally lock/unlock are not useful for unencrypted (not protected) keys.
+ *  Locking the key also removes it from the decrypted keys cache, see
+ *  rnp_ffi_set_key_cache().
  *
  *  @param key
  *  @return RNP_SUCCESS on success, or any other value on error
@@ -1808,6 +1968,21 @@ RNP_API rnp_result_t rnp_dump_packets_to_json(rnp_input_t input,
                                               uint32_t    flags,
                                               char **     result);
 
+/** Dump OpenPGP packets stream information as JSON directly to the output. Unlike the
+ *  rnp_dump_packets_to_json(), packets are written one by one as they are processed, so
+ *  memory usage does not depend on the number of packets. Resulting JSON is equivalent to the
+ *  one of rnp_dump_packets_to_json(), while whitespaces may differ.
+ *  Note: on failure output may contain partially written JSON.
+ * @param input source with OpenPGP data
+ * @param output JSON array with packets information will be written here
+ * @param flags include additional fields in JSON (see RNP_JSON_DUMP_MPI and other
+ *              RNP_JSON_DUMP_* flags)
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_dump_packets_to_json_output(rnp_input_t  input,
+                                                     rnp_output_t output,
+                                                     uint32_t     flags);
+
 /** Dump OpenPGP packets stream information to output in humand-readable format.
  * @param input source with OpenPGP data
  * @param output text, describing packet sequence, will be written here
@@ -1825,7 +2000,8 @@ RNP_API rnp_result_t rnp_dump_packets_to_output(rnp_input_t  input,
  *         function should be used.
  *  @param op pointer to opaque signing context
  *  @param ffi
- *  @param input stream with data to be signed. Could not be NULL.
+ *  @param input stream with data to be signed. May be NULL if data is pushed via
+ *         rnp_op_sign_feed() instead of rnp_op_sign_execute() call.
  *  @param output stream to write results to. Could not be NULL.
  *  @return RNP_SUCCESS or error code if failed
  */
@@ -1838,7 +2014,8 @@ RNP_API rnp_result_t rnp_op_sign_create(rnp_op_sign_t *op,
  *         contain source data with additional headers and armored signature.
  *  @param op pointer to opaque signing context
  *  @param ffi
- *  @param input stream with data to be signed. Could not be NULL.
+ *  @param input stream with data to be signed. May be NULL if data is pushed via
+ *         rnp_op_sign_feed() instead of rnp_op_sign_execute() call.
  *  @param output stream to write results to. Could not be NULL.
  *  @return RNP_SUCCESS or error code if failed
  */
@@ -1851,7 +2028,8 @@ RNP_API rnp_result_t rnp_op_sign_cleartext_create(rnp_op_sign_t *op,
  *         source data.
  *  @param op pointer to opaque signing context
  *  @param ffi
- *  @param input stream with data to be signed. Could not be NULL.
+ *  @param input stream with data to be signed. May be NULL if data is pushed via
+ *         rnp_op_sign_feed() instead of rnp_op_sign_execute() call.
  *  @param output stream to write results to. Could not be NULL.
  *  @return RNP_SUCCESS or error code if failed
  */
@@ -1873,6 +2051,98 @@ RNP_API rnp_result_t rnp_op_sign_add_signature(rnp_op_sign_t            op,
                                                rnp_key_handle_t         key,
                                                rnp_op_sign_signature_t *sig);
 
+/** @brief Create a long-lived signer object, which holds the unlocked secret signing key.
+ *         Signing key is looked up and the secret key is decrypted only once, here, so
+ *         signatures made via rnp_op_sign_add_signer() do not need key lookup, password
+ *         request or secret key decryption.
+ *         Unlocked key material stays in memory until signer is destroyed.
+ *         Signer refers to the key by fingerprint, so keys may be unloaded or reloaded while
+ *         signer exists.
+ *  @param ffi initialized FFI object, could not be NULL.
+ *  @param key handle of the key, capable for signing or having a signing subkey. Secret key
+ *         must be available. If it is protected then password provider is used to obtain the
+ *         password. Key must belong to the same FFI object, otherwise
+ *         RNP_ERROR_BAD_PARAMETERS is returned.
+ *  @param signer on success signer object will be stored here. It must be destroyed via
+ *         rnp_signer_destroy() function call, after all of the operations which use it.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_signer_create(rnp_ffi_t        ffi,
+                                       rnp_key_handle_t key,
+                                       rnp_signer_t *   signer);
+
+/** @brief Destroy the signer object, wiping the unlocked secret key.
+ *  @param signer signer object, may be NULL.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_signer_destroy(rnp_signer_t signer);
+
+/** @brief Add signature, made by the signer object. It is the same as
+ *         rnp_op_sign_add_signature(), except that the already unlocked key of the signer is
+ *         used. Signer must not be destroyed before the operation is executed.
+ *  @param op opaque signing context. Must be successfully initialized with one of the
+ *         rnp_op_sign_*_create functions.
+ *  @param signer signer object, created with the same FFI object as the operation.
+ *  @param sig pointer to opaque structure holding the signature information. May be NULL.
+ *  @return RNP_SUCCESS or error code if failed. RNP_ERROR_KEY_NOT_FOUND is returned if the
+ *          signer's secret key is not loaded anymore.
+ */
+RNP_API rnp_result_t rnp_op_sign_add_signer(rnp_op_sign_t            op,
+                                            rnp_signer_t             signer,
+                                            rnp_op_sign_signature_t *sig);
+
+/** @brief Create a digest context, which is used to hash data for the detached signature,
+ *         made later by the signer via rnp_signer_sign_digests(). This allows to hash data
+ *         separately from the signing, i.e. on the other threads or while data is received.
+ *         Digest context is bound to the signer since some algorithms (SM2) need the
+ *         key-specific prefix.
+ *  @param signer signer object, could not be NULL.
+ *  @param hash hash algorithm name. It may be adjusted to the stronger one if this is
+ *         required by the signing key.
+ *  @param digest on success digest context will be stored here. It must be destroyed via
+ *         rnp_digest_destroy() function call, before the signer.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_signer_digest_create(rnp_signer_t  signer,
+                                              const char *  hash,
+                                              rnp_digest_t *digest);
+
+/** @brief Add data to the digest context. Could be called multiple times.
+ *  @param digest digest context, could not be NULL.
+ *  @param data data to hash. May be NULL if len is 0.
+ *  @param len length of the data.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_digest_update(rnp_digest_t digest, const uint8_t *data, size_t len);
+
+/** @brief Destroy the digest context.
+ *  @param digest digest context, may be NULL.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_digest_destroy(rnp_digest_t digest);
+
+/** @brief Make binary detached signatures over the hashed data, on the pool of threads.
+ *         Digest contexts are not finalized, so more data may be added to them afterwards.
+ *         Signature creation time is set to the current time.
+ *  @param signer signer object, could not be NULL.
+ *  @param digests array of count digest contexts, created by the same signer.
+ *  @param count number of digests.
+ *  @param threads maximum number of threads used, including the calling one. If 0 then number
+ *         of available CPU cores will be used.
+ *  @param outputs array of count distinct outputs, signature for each digest is written to
+ *         the corresponding output.
+ *  @param results array of count values, each one will be set to the result of the
+ *         corresponding signing. Must not be NULL.
+ *  @return RNP_SUCCESS if batch was processed (see results for the per-digest status), or any
+ *          other value on error.
+ */
+RNP_API rnp_result_t rnp_signer_sign_digests(rnp_signer_t  signer,
+                                             rnp_digest_t *digests,
+                                             size_t        count,
+                                             size_t        threads,
+                                             rnp_output_t *outputs,
+                                             rnp_result_t *results);
+
 /** @brief Set hash algorithm used during signature calculation instead of default one, or one
  *         set by rnp_op_encrypt_set_hash/rnp_op_sign_set_hash
  *  @param sig opaque signature context, returned via rnp_op_sign_add_signature
@@ -1911,6 +2181,36 @@ RNP_API rnp_result_t rnp_op_sign_set_compression(rnp_op_sign_t op,
                                                  const char *  compression,
                                                  int           level);
 
+/** @brief Set number of threads used for ZIP/ZLIB compression. Data is split into blocks
+ *         which are compressed concurrently and then concatenated into the single deflate
+ *         stream. Makes sense only for embedded signatures.
+ *  @param op opaque signing context. Must be initialized with rnp_op_sign_create function
+ *  @param threads number of compression threads. 0 or 1 means compression on the calling
+ *         thread (default). Value is limited to 4 times the number of hardware threads.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_sign_set_compression_threads(rnp_op_sign_t op, size_t threads);
+
+/** @brief Enable or disable automatic compression bypass: beginning of the data is sampled
+ *         and, if it looks incompressible (i.e. already compressed or encrypted), compression
+ *         is not used. Makes sense only for embedded signatures.
+ *  @param op opaque signing context. Must be initialized with rnp_op_sign_create function
+ *  @param enable true to enable, false to always compress data (default).
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_sign_set_compression_auto(rnp_op_sign_t op, bool enable);
+
+/** @brief Get the compression algorithm which was actually used by the operation.
+ *  @param op opaque signing context. Must be executed with rnp_op_sign_execute function, or
+ *         started via rnp_op_sign_feed().
+ *  @param compression on success compression algorithm name will be stored here, or
+ *         "Uncompressed" if compression was disabled or skipped, as well as for detached and
+ *         cleartext signatures. You must free it using the rnp_buffer_destroy() function.
+ *  @return RNP_SUCCESS or error code if failed. RNP_ERROR_BAD_STATE is returned if
+ *          operation was not executed yet.
+ */
+RNP_API rnp_result_t rnp_op_sign_get_used_compression(rnp_op_sign_t op, char **compression);
+
 /** @brief Enabled or disable armored (textual) output. Doesn't make sense for cleartext sign.
  *  @param op opaque signing context. Must be initialized with rnp_op_sign_create or
  *         rnp_op_sign_detached_create function.
@@ -1970,6 +2270,28 @@ RNP_API rnp_result_t rnp_op_sign_set_file_mtime(rnp_op_sign_t op, uint32_t mtime
  */
 RNP_API rnp_result_t rnp_op_sign_execute(rnp_op_sign_t op);
 
+/** @brief Push the next portion of data to the signing operation. This allows to process data
+ *         incrementally, as it arrives, instead of using the blocking rnp_op_sign_execute().
+ *         Signed data (if any) is written to the output as soon as it is produced, so may
+ *         be taken from the memory output via rnp_output_memory_drain() or received via
+ *         the output's writer callback. Settings of the operation cannot be changed after
+ *         the first call, RNP_ERROR_BAD_STATE is returned by the setters. Operation must be
+ *         finished with rnp_op_sign_finish().
+ *  @param op opaque signing context. Must be successfully initialized with one of the
+ *         rnp_op_sign_*_create functions. At least one signing key should be added.
+ *  @param buf data to sign. May be NULL only if len is 0.
+ *  @param len number of bytes in buf.
+ *  @return RNP_SUCCESS or error code if failed. On failure operation cannot be continued.
+ */
+RNP_API rnp_result_t rnp_op_sign_feed(rnp_op_sign_t op, const uint8_t *buf, size_t len);
+
+/** @brief Finish signing of the data, pushed via rnp_op_sign_feed(): signatures and all the
+ *         remaining data are written to the output.
+ *  @param op opaque signing context.
+ *  @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_op_sign_finish(rnp_op_sign_t op);
+
 /** @brief Free resources associated with signing operation.
  *  @param op opaque signing context. Must be successfully initialized with one of the
  *         rnp_op_sign_*_create functions.
@@ -2006,7 +2328,24 @@ RNP_API rnp_result_t rnp_op_verify_detached_create(rnp_op_verify_t *op,
                                                    rnp_input_t      input,
                                                    rnp_input_t      signature);
 
+/** @brief Add one more detached signature input to the verification operation, created via
+ *         rnp_op_verify_detached_create(). Signatures from all of the inputs are checked
+ *         against the same data, which is read and hashed only once, so this is much faster
+ *         than separate verification of the large data for each signature file.
+ *         Use rnp_op_verify_signature_get_input_index() to find out input of each signature.
+ *         If any of the signature inputs is malformed then the whole operation fails.
+ *  @param op verification context, created via rnp_op_verify_detached_create().
+ *  @param signature stream with detached signature(s). Must be kept until the operation is
+ *         executed.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_verify_add_detached_signature(rnp_op_verify_t op,
+                                                          rnp_input_t     signature);
+
 /** @brief Execute previously initialized verification operation.
+ *         Unlike encryption and signing there is no incremental (push-based) variant of this
+ *         call: the whole input is read by the packet parser, so it must be available via
+ *         the rnp_input_t, i.e. from the callback which may block until more data arrives.
  *  @param op opaque verification context. Must be successfully initialized.
  *  @return RNP_SUCCESS if data was processed successfully and all signatures are valid.
  *          Otherwise error code is returned. After rnp_op_verify_execute()
@@ -2015,6 +2354,31 @@ RNP_API rnp_result_t rnp_op_verify_detached_create(rnp_op_verify_t *op,
  */
 RNP_API rnp_result_t rnp_op_verify_execute(rnp_op_verify_t op);
 
+/** @brief Execute a batch of previously initialized verification operations concurrently,
+ *         using the internal pool of worker threads. This is mostly useful for the large
+ *         number of detached signatures, created via rnp_op_verify_detached_create().
+ *         Signing keys are looked up in the loaded keyrings only, key provider callback is
+ *         not called, so all the needed keys must be loaded in advance. Password provider
+ *         calls, if any, are serialized. Ffi object must not be used by other threads
+ *         until the function returns.
+ *  @param ops array of opaque verification contexts, created for the same ffi object. Each
+ *         context must be listed once and use its own inputs and outputs, otherwise
+ *         RNP_ERROR_BAD_PARAMETERS is returned and nothing is processed.
+ *  @param count number of contexts in ops array.
+ *  @param threads maximum number of threads to use, including the calling one. If 0 then
+ *         number of available CPU cores is used.
+ *  @param results array of count elements, where result of each verification will be
+ *         stored, like if rnp_op_verify_execute() was called. Afterwards rnp_op_verify_get_*
+ *         functions may be used to query information about the signature(s) of each
+ *         operation.
+ *  @return RNP_SUCCESS if batch was processed, or error code if parameters are invalid.
+ *          Per-operation verification results are stored in results array.
+ */
+RNP_API rnp_result_t rnp_op_verify_execute_batch(rnp_op_verify_t *ops,
+                                                 size_t           count,
+                                                 size_t           threads,
+                                                 rnp_result_t *   results);
+
 /** @brief Get number of the signatures for verified data.
  *  @param op opaque verification context. Must be initialized and have execute() called on it.
  *  @param count result will be stored here on success.
@@ -2229,6 +2593,16 @@ RNP_API rnp_result_t rnp_op_verify_destroy(rnp_op_verify_t op);
  */
 RNP_API rnp_result_t rnp_op_verify_signature_get_status(rnp_op_verify_signature_t sig);
 
+/** @brief Get index of the signature input, from which signature was read.
+ *  @param sig opaque signature context obtained via rnp_op_verify_get_signature_at call.
+ *  @param index 0 for the signature input, passed to rnp_op_verify_detached_create(), or
+ *         1-based index of rnp_op_verify_add_detached_signature() call. Always 0 for
+ *         operations without additional signature inputs.
+ *  @return RNP_SUCCESS or error code if failed
+ */
+RNP_API rnp_result_t rnp_op_verify_signature_get_input_index(rnp_op_verify_signature_t sig,
+                                                             size_t *                  index);
+
 /** Get the signature handle from the verified signature. This would allow to query extended
  * information on the signature.
  *
@@ -2295,6 +2669,21 @@ RNP_API void rnp_buffer_clear(void *ptr, size_t size);
  */
 RNP_API rnp_result_t rnp_input_from_path(rnp_input_t *input, const char *path);
 
+/**
+ * @brief Initialize input struct to read from a file.
+ *        Note: it doesn't allow input from directory like rnp_input_from_path does, but
+ *        allows additional options to be specified.
+ *        When RNP_INPUT_FILE_READ_AHEAD flag is included then file is read on the background
+ *        thread, so reading from the slow storage overlaps with the data processing.
+ *
+ * @param input pointer to the input opaque structure
+ * @param path path of the file to read from
+ * @param flags additional flags, see RNP_INPUT_* flags.
+ * @return RNP_SUCCESS if operation succeeded and input struct is ready to read, or error code
+ * otherwise
+ */
+RNP_API rnp_result_t rnp_input_from_file(rnp_input_t *input, const char *path, uint32_t flags);
+
 /**
  * @brief Initialize input struct to read from memory
  *
@@ -2350,6 +2739,9 @@ RNP_API rnp_result_t rnp_output_to_path(rnp_output_t *output, const char *path);
  *        allows additional options to be specified.
  *        When RNP_OUTPUT_FILE_RANDOM flag is included then you may want to call
  *        rnp_output_finish() to make sure that final rename succeeded.
+ *        When RNP_OUTPUT_FILE_WRITE_BEHIND flag is included then data is written on the
+ *        background thread, so writing to the slow storage overlaps with the data
+ *        processing. Call rnp_output_finish() to make sure that all data was written.
  * @param output pointer to the opaque output structure. After use you must free it using the
  *               rnp_output_destroy() function.
  * @param path path to the file.
@@ -2401,6 +2793,20 @@ RNP_API rnp_result_t rnp_output_memory_get_buf(rnp_output_t output,
                                                size_t *     len,
                                                bool         do_copy);
 
+/**
+ * @brief Take the data, written to the memory output so far, and reset the output so
+ *        subsequent writes will start from the beginning of the buffer. This is useful to
+ *        consume output of the incremental operations, see rnp_op_encrypt_feed() and
+ *        rnp_op_sign_feed().
+ *
+ * @param output output structure, initialized by rnp_output_to_memory
+ * @param buf newly-allocated buffer with data will be stored here, application is responsible
+ *        for freeing it with rnp_buffer_destroy. NULL will be stored if there is no data.
+ * @param len number of bytes in buffer will be stored here
+ * @return RNP_SUCCESS if operation succeeded or error code otherwise.
+ */
+RNP_API rnp_result_t rnp_output_memory_drain(rnp_output_t output, uint8_t **buf, size_t *len);
+
 /**
  * @brief Initialize output structure to write to callbacks.
  *
@@ -2457,6 +2863,17 @@ RNP_API rnp_result_t rnp_output_finish(rnp_output_t output);
 RNP_API rnp_result_t rnp_output_destroy(rnp_output_t output);
 
 /* encrypt */
+
+/**
+ * @brief Create encryption operation context.
+ *
+ * @param op pointer to opaque encryption context
+ * @param ffi
+ * @param input stream with data to be encrypted. May be NULL if data is pushed via
+ *        rnp_op_encrypt_feed() instead of rnp_op_encrypt_execute() call.
+ * @param output stream to write results to. Could not be NULL.
+ * @return RNP_SUCCESS or error code if failed
+ */
 RNP_API rnp_result_t rnp_op_encrypt_create(rnp_op_encrypt_t *op,
                                            rnp_ffi_t         ffi,
                                            rnp_input_t       input,
@@ -2472,6 +2889,79 @@ RNP_API rnp_result_t rnp_op_encrypt_create(rnp_op_encrypt_t *op,
  */
 RNP_API rnp_result_t rnp_op_encrypt_add_recipient(rnp_op_encrypt_t op, rnp_key_handle_t key);
 
+/**
+ * @brief Create a reusable set of recipients. Encryption keys of the recipients are looked up
+ *        and checked once, when they are added to the set, and then the set may be attached to
+ *        any number of encrypting operations. This saves the key lookup and subkey selection
+ *        when messages are encrypted to the same recipients over and over.
+ *        Set also keeps the public keys, loaded to the crypto backend, and the symmetric
+ *        cipher preferred by all of the recipients.
+ *        Keys are referenced by fingerprints, so set remains usable after keys are reloaded.
+ *        Set must be destroyed before the FFI object is destroyed.
+ *
+ * @param ffi initialized FFI object, could not be NULL.
+ * @param set on success newly created set will be stored here. It must be destroyed via
+ *        rnp_recipient_set_destroy() function call.
+ * @return RNP_SUCCESS if operation succeeds or error code otherwise.
+ */
+RNP_API rnp_result_t rnp_recipient_set_create(rnp_ffi_t ffi, rnp_recipient_set_t *set);
+
+/**
+ * @brief Add recipient's key to the set. Key or one of its subkeys must be valid and usable
+ *        for encryption, otherwise RNP_ERROR_NO_SUITABLE_KEY is returned.
+ *
+ * @param set recipient set, could not be NULL.
+ * @param key recipient's key, could not be NULL.
+ * @return RNP_SUCCESS if operation succeeds or error code otherwise.
+ */
+RNP_API rnp_result_t rnp_recipient_set_add(rnp_recipient_set_t set, rnp_key_handle_t key);
+
+/**
+ * @brief Get the number of recipients in the set.
+ *
+ * @param set recipient set, could not be NULL.
+ * @param count number of recipients will be stored here.
+ * @return RNP_SUCCESS if operation succeeds or error code otherwise.
+ */
+RNP_API rnp_result_t rnp_recipient_set_get_count(rnp_recipient_set_t set, size_t *count);
+
+/**
+ * @brief Destroy the recipient set. Operations to which set was attached are not affected.
+ *
+ * @param set recipient set, may be NULL.
+ * @return RNP_SUCCESS if operation succeeds or error code otherwise.
+ */
+RNP_API rnp_result_t rnp_recipient_set_destroy(rnp_recipient_set_t set);
+
+/**
+ * @brief Add all recipients of the set to encrypting context. Session key is still generated
+ *        separately for each operation.
+ *        If cipher was not set via rnp_op_encrypt_set_cipher(), the first one from the
+ *        preferences of the first recipient, which is listed by all of the others as well, is
+ *        used. Only ciphers with 128-bit block are considered.
+ *
+ * @param op opaque encrypting context. Must be allocated and initialized.
+ * @param set recipient set, created with the same FFI object as the operation.
+ * @return RNP_SUCCESS if operation succeeds or error code otherwise.
+ *         RNP_ERROR_KEY_NOT_FOUND if any of the recipients' keys was removed or unloaded.
+ */
+RNP_API rnp_result_t rnp_op_encrypt_add_recipient_set(rnp_op_encrypt_t    op,
+                                                      rnp_recipient_set_t set);
+
+/**
+ * @brief set the number of threads used to encrypt the session key to the recipients. This
+ *        makes sense for messages with a lot of recipients, since public key encryption
+ *        is done separately for each of them. Key lookup is still done on the calling thread,
+ *        and session key packets are written in the order in which recipients were added.
+ *
+ * @param op opaque encrypting context. Must be allocated and initialized.
+ * @param threads number of threads. 0 or 1 means encryption on the calling thread, which is
+ *        the default.
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_op_encrypt_set_recipient_threads(rnp_op_encrypt_t op,
+                                                          size_t           threads);
+
 /**
  * @brief Add signature to encrypting context, so data will be encrypted and signed.
  *
@@ -2595,6 +3085,48 @@ RNP_API rnp_result_t rnp_op_encrypt_set_compression(rnp_op_encrypt_t op,
                                                     const char *     compression,
                                                     int              level);
 
+/**
+ * @brief set the number of threads used for ZIP/ZLIB compression. Data is split into blocks
+ *        which are compressed concurrently and then concatenated into the single deflate
+ *        stream, so output is still readable by any OpenPGP implementation. BZip2 is always
+ *        compressed on the calling thread.
+ *
+ * @param op opaque encrypted context. Must be allocated and initialized
+ * @param threads number of compression threads. 0 or 1 means compression on the calling
+ *        thread, which is the default. Value is limited to 4 times the number of hardware
+ *        threads.
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_op_encrypt_set_compression_threads(rnp_op_encrypt_t op,
+                                                            size_t           threads);
+
+/**
+ * @brief enable or disable automatic compression bypass. If enabled, first kilobytes of the
+ *        data are sampled, and if they look incompressible (i.e. already compressed media or
+ *        archives) then compression is not used, regardless of the algorithm and level set
+ *        via rnp_op_encrypt_set_compression(). Use rnp_op_encrypt_get_used_compression() to
+ *        check the decision.
+ *
+ * @param op opaque encrypted context. Must be allocated and initialized
+ * @param enable true to enable, false to always compress data (default).
+ * @return RNP_SUCCESS on success, or any other value on error
+ */
+RNP_API rnp_result_t rnp_op_encrypt_set_compression_auto(rnp_op_encrypt_t op, bool enable);
+
+/**
+ * @brief get the compression algorithm which was actually used for the inner raw data.
+ *
+ * @param op opaque encrypted context. Must be executed with rnp_op_encrypt_execute(), or
+ *        started via rnp_op_encrypt_feed().
+ * @param compression on success compression algorithm name will be stored here, or
+ *        "Uncompressed" if compression was disabled or skipped. You must free it using the
+ *        rnp_buffer_destroy() function.
+ * @return RNP_SUCCESS on success, RNP_ERROR_BAD_STATE if operation was not executed yet, or
+ *         any other value on error
+ */
+RNP_API rnp_result_t rnp_op_encrypt_get_used_compression(rnp_op_encrypt_t op,
+                                                         char **          compression);
+
 /**
  * @brief set the internally stored file name for the data being encrypted
  *
@@ -2615,10 +3147,62 @@ RNP_API rnp_result_t rnp_op_encrypt_set_file_name(rnp_op_encrypt_t op, const cha
 RNP_API rnp_result_t rnp_op_encrypt_set_file_mtime(rnp_op_encrypt_t op, uint32_t mtime);
 
 RNP_API rnp_result_t rnp_op_encrypt_execute(rnp_op_encrypt_t op);
+
+/**
+ * @brief Push the next portion of data to the encryption operation. This allows to process
+ *        data incrementally, as it arrives, instead of using the blocking
+ *        rnp_op_encrypt_execute(). Encrypted data is written to the output as soon as it is
+ *        produced, so may be taken from the memory output via rnp_output_memory_drain() or
+ *        received via the output's writer callback. Since data size is not known in advance,
+ *        partial-length packets are always used, and automatic compression bypass is not
+ *        applied. Settings of the operation cannot be changed after the first call,
+ *        RNP_ERROR_BAD_STATE is returned by the setters. Operation must be finished with
+ *        rnp_op_encrypt_finish().
+ *
+ * @param op opaque encryption context. Must be initialized, with recipients or passwords
+ *           added.
+ * @param buf data to encrypt. May be NULL only if len is 0.
+ * @param len number of bytes in buf.
+ * @return RNP_SUCCESS or error code if failed. On failure operation cannot be continued.
+ */
+RNP_API rnp_result_t rnp_op_encrypt_feed(rnp_op_encrypt_t op, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Finish encryption of the data, pushed via rnp_op_encrypt_feed(): all the remaining
+ *        data, signatures and authentication tags are written to the output.
+ *
+ * @param op opaque encryption context.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_op_encrypt_finish(rnp_op_encrypt_t op);
 RNP_API rnp_result_t rnp_op_encrypt_destroy(rnp_op_encrypt_t op);
 
 RNP_API rnp_result_t rnp_decrypt(rnp_ffi_t ffi, rnp_input_t input, rnp_output_t output);
 
+/**
+ * @brief Decrypt the byte range of the AEAD-encrypted message contents, without processing
+ *        the whole message. Only AEAD chunks which cover the requested range are read,
+ *        decrypted and authenticated, so this is much faster for large messages.
+ *        Message must be binary (not armored), encrypted with AEAD mode, using the
+ *        definite-length packets (this is done automatically by rnp_op_encrypt_execute() if
+ *        input size is known, and compression is not used), and must not be signed.
+ *        Keys and password are obtained via the ffi's key and password providers.
+ *
+ * @param ffi initialized FFI object
+ * @param input source with the encrypted message. Must be seekable, i.e. created via
+ *              rnp_input_from_path(), rnp_input_from_file() or rnp_input_from_memory().
+ * @param offset offset of the first byte of the range within the decrypted contents
+ * @param length number of bytes to decrypt. Range will be truncated to the end of data.
+ * @param output destination for the decrypted bytes
+ * @return RNP_SUCCESS on success, RNP_ERROR_NOT_SUPPORTED if message or input doesn't allow
+ *         random access, or any other value on error.
+ */
+RNP_API rnp_result_t rnp_decrypt_range(rnp_ffi_t    ffi,
+                                       rnp_input_t  input,
+                                       uint64_t     offset,
+                                       uint64_t     length,
+                                       rnp_output_t output);
+
 /** retrieve the raw data for a public key
  *
  *  This will always be PGP packets and will never include ASCII armor.
@@ -2658,6 +3242,43 @@ RNP_API rnp_result_t rnp_get_secret_key_data(rnp_key_handle_t handle,
  */
 RNP_API rnp_result_t rnp_key_to_json(rnp_key_handle_t handle, uint32_t flags, char **result);
 
+/** output key information to JSON structure and write it directly to the output, without
+ *  making the copy of the serialized string. Useful when dumping many keys in sequence.
+ *
+ * @param handle the key handle, could not be NULL
+ * @param output JSON will be written here, could not be NULL.
+ * @param flags controls which key data is printed, see RNP_JSON_* constants.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_key_to_json_output(rnp_key_handle_t handle,
+                                            rnp_output_t     output,
+                                            uint32_t         flags);
+
+/** write selected metadata of all the loaded keys to the output, one line per key.
+ *  Keyrings are walked only once, and no key handles or JSON objects are allocated, so this
+ *  is much faster than iterating keys and querying each one via the key handle functions.
+ *  Public keys are listed first, followed by secret keys which have no public counterpart.
+ *
+ * @param ffi initialized FFI object, could not be NULL.
+ * @param fields comma-separated list of fields to output, in the desired order. Supported
+ *               fields are: fingerprint, keyid, grip, primary_grip, alg, bits, curve,
+ *               created, expiration, primary, secret, valid, expired, revoked, uid.
+ *               The uid field contains the primary (or first valid) userid of the primary key,
+ *               and is empty for subkeys. If NULL then all fields are written.
+ * @param output output where lines are written, could not be NULL.
+ * @param flags by default fields are written tab-separated, preceded by the header line with
+ *              field names. Tab, newline, carriage return and backslash characters are
+ *              escaped with backslash.
+ *              Following flags are supported:
+ *              RNP_KEY_LIST_JSON: write each key as a JSON object on a separate line.
+ *              RNP_KEY_LIST_NO_HEADER: do not write the header line.
+ * @return RNP_SUCCESS or error code if failed.
+ */
+RNP_API rnp_result_t rnp_key_list_to_output(rnp_ffi_t    ffi,
+                                            const char * fields,
+                                            rnp_output_t output,
+                                            uint32_t     flags);
+
 /** create an identifier iterator
  *
  *  @param ffi
@@ -0,0 +1,156 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <crypto/hash.h>
+#include <crypto/symmetric.h>
+#include "bench.h"
+
+using namespace rnp_bench;
+
+static const struct {
+    pgp_hash_alg_t alg;
+    const char *   name;
+} hash_algs[] = {{PGP_HASH_MD5, "MD5"},
+                 {PGP_HASH_SHA1, "SHA1"},
+                 {PGP_HASH_SHA256, "SHA256"},
+                 {PGP_HASH_SHA512, "SHA512"},
+                 {PGP_HASH_SHA3_256, "SHA3-256"},
+                 {PGP_HASH_SM3, "SM3"}};
+
+static const struct {
+    pgp_symm_alg_t alg;
+    const char *   name;
+} symm_algs[] = {{PGP_SA_AES_128, "AES128"},
+                 {PGP_SA_AES_256, "AES256"},
+                 {PGP_SA_CAST5, "CAST5"},
+                 {PGP_SA_TWOFISH, "TWOFISH"},
+                 {PGP_SA_CAMELLIA_256, "CAMELLIA256"}};
+
+static void
+bench_hash(State &state, pgp_hash_alg_t alg)
+{
+    std::vector<uint8_t> data = bench_data(state.arg());
+    uint8_t              digest[PGP_MAX_HASH_SIZE];
+
+    while (state.keep_running()) {
+        pgp_hash_t hash = {};
+        if (!pgp_hash_create(&hash, alg)) {
+            state.skip_with_error("hash algorithm is not supported");
+            break;
+        }
+        pgp_hash_add(&hash, data.data(), data.size());
+        pgp_hash_finish(&hash, digest);
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+
+static void
+bench_cfb(State &state, pgp_symm_alg_t alg, bool decrypt)
+{
+    std::vector<uint8_t> data = bench_data(state.arg());
+    std::vector<uint8_t> out(data.size());
+    uint8_t              key[PGP_MAX_KEY_SIZE] = {0};
+    uint8_t              iv[PGP_MAX_BLOCK_SIZE] = {0};
+
+    while (state.keep_running()) {
+        pgp_crypt_t crypt = {};
+        if (!pgp_cipher_cfb_start(&crypt, alg, key, iv)) {
+            state.skip_with_error("cipher is not supported");
+            break;
+        }
+        if (decrypt) {
+            pgp_cipher_cfb_decrypt(&crypt, out.data(), data.data(), data.size());
+        } else {
+            pgp_cipher_cfb_encrypt(&crypt, out.data(), data.data(), data.size());
+        }
+        pgp_cipher_cfb_finish(&crypt);
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+
+static void
+bench_aead(State &state, pgp_symm_alg_t alg, pgp_aead_alg_t aalg)
+{
+    std::vector<uint8_t> data = bench_data(state.arg());
+    std::vector<uint8_t> out(data.size() + PGP_AEAD_MAX_TAG_LEN);
+    uint8_t              key[PGP_MAX_KEY_SIZE] = {0};
+    uint8_t              nonce[PGP_AEAD_MAX_NONCE_LEN] = {0};
+    uint8_t              ad[13] = {0};
+    pgp_crypt_t          crypt = {};
+
+    if (!pgp_cipher_aead_init(&crypt, alg, aalg, key, false)) {
+        state.skip_with_error("AEAD cipher is not supported");
+        return;
+    }
+    /* whole buffer is encrypted as a single AEAD chunk */
+    size_t gran = pgp_cipher_aead_granularity(&crypt);
+    size_t upd = gran ? data.size() - data.size() % gran : 0;
+    size_t nlen = pgp_cipher_aead_nonce_len(aalg);
+    while (state.keep_running()) {
+        if (!pgp_cipher_aead_set_ad(&crypt, ad, sizeof(ad)) ||
+            !pgp_cipher_aead_start(&crypt, nonce, nlen) ||
+            (upd && !pgp_cipher_aead_update(&crypt, out.data(), data.data(), upd)) ||
+            !pgp_cipher_aead_finish(
+              &crypt, out.data() + upd, data.data() + upd, data.size() - upd)) {
+            state.skip_with_error("AEAD encryption failed");
+            break;
+        }
+    }
+    pgp_cipher_aead_destroy(&crypt);
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+
+static bool
+register_crypto_benchmarks()
+{
+    for (auto &halg : hash_algs) {
+        pgp_hash_alg_t alg = halg.alg;
+        register_benchmark(std::string("hash/") + halg.name,
+                           [alg](State &state) { bench_hash(state, alg); },
+                           buffer_sizes);
+    }
+    for (auto &salg : symm_algs) {
+        pgp_symm_alg_t alg = salg.alg;
+        register_benchmark(std::string("cfb_encrypt/") + salg.name,
+                           [alg](State &state) { bench_cfb(state, alg, false); },
+                           buffer_sizes);
+        register_benchmark(std::string("cfb_decrypt/") + salg.name,
+                           [alg](State &state) { bench_cfb(state, alg, true); },
+                           buffer_sizes);
+    }
+    register_benchmark("aead_encrypt/EAX/AES128",
+                       [](State &state) { bench_aead(state, PGP_SA_AES_128, PGP_AEAD_EAX); },
+                       buffer_sizes);
+    register_benchmark("aead_encrypt/OCB/AES128",
+                       [](State &state) { bench_aead(state, PGP_SA_AES_128, PGP_AEAD_OCB); },
+                       buffer_sizes);
+    register_benchmark("aead_encrypt/OCB/AES256",
+                       [](State &state) { bench_aead(state, PGP_SA_AES_256, PGP_AEAD_OCB); },
+                       buffer_sizes);
+    return true;
+}
+
+static const bool crypto_registered = register_crypto_benchmarks();
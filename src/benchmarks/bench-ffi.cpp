@@ -0,0 +1,325 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <rnp/rnp.h>
+#include <rnp/rnp_err.h>
+#include "bench.h"
+
+using namespace rnp_bench;
+
+/* ffi object with generated keys, shared by the benchmarks */
+class BenchFFI {
+    std::map<std::string, rnp_key_handle_t> keys_;
+
+  public:
+    rnp_ffi_t ffi = NULL;
+
+    BenchFFI()
+    {
+        if (rnp_ffi_create(&ffi, "GPG", "GPG")) {
+            ffi = NULL;
+        }
+    }
+
+    ~BenchFFI()
+    {
+        for (auto &key : keys_) {
+            rnp_key_handle_destroy(key.second);
+        }
+        rnp_ffi_destroy(ffi);
+    }
+
+    /* generate key once, subsequent calls return the same key */
+    rnp_key_handle_t
+    key(const char *alg, uint32_t bits, const char *curve, bool encrypt = false)
+    {
+        std::string name = std::string(alg) + "/" + std::to_string(bits) + "/" +
+                           (curve ? curve : "") + (encrypt ? "/enc" : "");
+        auto it = keys_.find(name);
+        if (it != keys_.end()) {
+            return it->second;
+        }
+        rnp_key_handle_t handle = NULL;
+        if (!ffi || rnp_generate_key_ex(ffi,
+                                        alg,
+                                        encrypt ? "ECDH" : NULL,
+                                        bits,
+                                        0,
+                                        curve,
+                                        encrypt ? "Curve25519" : NULL,
+                                        name.c_str(),
+                                        NULL,
+                                        &handle)) {
+            return NULL;
+        }
+        keys_[name] = handle;
+        return handle;
+    }
+};
+
+static BenchFFI &
+bench_ffi()
+{
+    static BenchFFI ffi;
+    return ffi;
+}
+
+static const struct {
+    const char *name;
+    const char *alg;
+    uint32_t    bits;
+    const char *curve;
+} sign_algs[] = {{"RSA2048", "RSA", 2048, NULL},
+                 {"RSA3072", "RSA", 3072, NULL},
+                 {"DSA2048", "DSA", 2048, NULL},
+                 {"ECDSA-P256", "ECDSA", 0, "NIST P-256"},
+                 {"ECDSA-P384", "ECDSA", 0, "NIST P-384"},
+                 {"EdDSA", "EDDSA", 0, NULL},
+                 {"SM2", "SM2", 0, NULL}};
+
+static bool
+sign_detached(rnp_key_handle_t            key,
+              const std::vector<uint8_t> &data,
+              std::vector<uint8_t> &      sig)
+{
+    rnp_input_t   input = NULL;
+    rnp_output_t  output = NULL;
+    rnp_op_sign_t op = NULL;
+    uint8_t *     buf = NULL;
+    size_t        len = 0;
+    bool          res = false;
+
+    if (rnp_input_from_memory(&input, data.data(), data.size(), false) ||
+        rnp_output_to_memory(&output, 0) ||
+        rnp_op_sign_detached_create(&op, bench_ffi().ffi, input, output) ||
+        rnp_op_sign_add_signature(op, key, NULL) || rnp_op_sign_execute(op) ||
+        rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    sig.assign(buf, buf + len);
+    res = true;
+done:
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static rnp_result_t
+verify_detached(const std::vector<uint8_t> &data, const std::vector<uint8_t> &sig)
+{
+    rnp_input_t     input = NULL;
+    rnp_input_t     siginput = NULL;
+    rnp_op_verify_t op = NULL;
+    rnp_result_t    ret = rnp_input_from_memory(&input, data.data(), data.size(), false);
+    if (!ret) {
+        ret = rnp_input_from_memory(&siginput, sig.data(), sig.size(), false);
+    }
+    if (!ret) {
+        ret = rnp_op_verify_detached_create(&op, bench_ffi().ffi, input, siginput);
+    }
+    if (!ret) {
+        ret = rnp_op_verify_execute(op);
+    }
+    rnp_op_verify_destroy(op);
+    rnp_input_destroy(input);
+    rnp_input_destroy(siginput);
+    return ret;
+}
+
+static void
+bench_verify(State &state, const char *alg, uint32_t bits, const char *curve)
+{
+    rnp_key_handle_t key = bench_ffi().key(alg, bits, curve);
+    if (!key) {
+        state.skip_with_error("key generation failed");
+        return;
+    }
+    std::vector<uint8_t> data = bench_data(state.arg());
+    std::vector<uint8_t> sig;
+    if (!sign_detached(key, data, sig)) {
+        state.skip_with_error("signing failed");
+        return;
+    }
+
+    while (state.keep_running()) {
+        if (verify_detached(data, sig)) {
+            state.skip_with_error("verification failed");
+            break;
+        }
+    }
+    state.set_items_processed(state.iterations());
+}
+
+/* input of the given size with reproducible data, generated on the fly */
+typedef struct bench_reader_t {
+    uint64_t left;
+    uint64_t seed;
+} bench_reader_t;
+
+static bool
+bench_read(void *app_ctx, void *buf, size_t len, size_t *read)
+{
+    bench_reader_t *reader = (bench_reader_t *) app_ctx;
+    len = std::min((uint64_t) len, reader->left);
+    bench_fill((uint8_t *) buf, len, reader->seed);
+    reader->left -= len;
+    *read = len;
+    return true;
+}
+
+typedef struct bench_pipeline_t {
+    const char *name;
+    bool        armor;
+    const char *aead;
+    bool        sign;
+} bench_pipeline_t;
+
+static const bench_pipeline_t pipelines[] = {{"binary", false, NULL, false},
+                                             {"armor", true, NULL, false},
+                                             {"aead_ocb", false, "OCB", false},
+                                             {"sign", false, NULL, true}};
+
+static rnp_result_t
+encrypt_stream(const bench_pipeline_t &pipeline, uint64_t size, rnp_output_t output)
+{
+    rnp_key_handle_t key = bench_ffi().key("EDDSA", 0, NULL, true);
+    if (!key) {
+        return RNP_ERROR_KEY_GENERATION;
+    }
+    bench_reader_t   reader = {size, 0x5DEECE66DULL};
+    rnp_input_t      input = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_result_t     ret = rnp_input_from_callback(&input, bench_read, NULL, &reader);
+    if (!ret) {
+        ret = rnp_op_encrypt_create(&op, bench_ffi().ffi, input, output);
+    }
+    if (!ret) {
+        ret = rnp_op_encrypt_add_recipient(op, key);
+    }
+    if (!ret && pipeline.armor) {
+        ret = rnp_op_encrypt_set_armor(op, true);
+    }
+    if (!ret && pipeline.aead) {
+        ret = rnp_op_encrypt_set_aead(op, pipeline.aead);
+    }
+    if (!ret && pipeline.sign) {
+        ret = rnp_op_encrypt_add_signature(op, key, NULL);
+    }
+    if (!ret) {
+        ret = rnp_op_encrypt_execute(op);
+    }
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    return ret;
+}
+
+static void
+bench_encrypt(State &state, const bench_pipeline_t &pipeline)
+{
+    while (state.keep_running()) {
+        rnp_output_t output = NULL;
+        rnp_result_t ret = rnp_output_to_null(&output);
+        if (!ret) {
+            ret = encrypt_stream(pipeline, state.arg(), output);
+        }
+        rnp_output_destroy(output);
+        if (ret) {
+            state.skip_with_error("encryption failed");
+            break;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * state.arg());
+}
+
+static void
+bench_decrypt(State &state, const bench_pipeline_t &pipeline)
+{
+    /* large data doesn't fit in memory, so encrypted message is stored in file */
+    std::string  path = std::string("rnp_bench_") + pipeline.name + ".pgp";
+    rnp_output_t output = NULL;
+    rnp_result_t ret = rnp_output_to_path(&output, path.c_str());
+    if (!ret) {
+        ret = encrypt_stream(pipeline, state.arg(), output);
+    }
+    rnp_output_destroy(output);
+    if (ret) {
+        remove(path.c_str());
+        state.skip_with_error("encryption failed");
+        return;
+    }
+
+    while (state.keep_running()) {
+        rnp_input_t input = NULL;
+        output = NULL;
+        ret = rnp_input_from_path(&input, path.c_str());
+        if (!ret) {
+            ret = rnp_output_to_null(&output);
+        }
+        if (!ret) {
+            ret = rnp_decrypt(bench_ffi().ffi, input, output);
+        }
+        rnp_input_destroy(input);
+        rnp_output_destroy(output);
+        if (ret) {
+            state.skip_with_error("decryption failed");
+            break;
+        }
+    }
+    remove(path.c_str());
+    state.set_bytes_processed(state.iterations() * state.arg());
+}
+
+static bool
+register_ffi_benchmarks()
+{
+    for (auto &salg : sign_algs) {
+        const char *alg = salg.alg;
+        uint32_t    bits = salg.bits;
+        const char *curve = salg.curve;
+        register_benchmark(std::string("verify/") + salg.name,
+                           [alg, bits, curve](State &state) {
+                               bench_verify(state, alg, bits, curve);
+                           },
+                           {1024});
+    }
+    for (auto &pipeline : pipelines) {
+        const bench_pipeline_t *pl = &pipeline;
+        register_benchmark(std::string("encrypt/") + pipeline.name,
+                           [pl](State &state) { bench_encrypt(state, *pl); },
+                           stream_sizes);
+        register_benchmark(std::string("decrypt/") + pipeline.name,
+                           [pl](State &state) { bench_decrypt(state, *pl); },
+                           stream_sizes);
+    }
+    return true;
+}
+
+static const bool ffi_registered = register_ffi_benchmarks();
@@ -0,0 +1,253 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+#include <memory>
+#include <string>
+#include <rekey/rnp_key_store.h>
+#include <librekey/key_store_pgp.h>
+#include <librepgp/stream-armor.h>
+#include <librepgp/stream-common.h>
+#include <librepgp/stream-key.h>
+#include <librepgp/stream-packet.h>
+#include <librepgp/stream-sig.h>
+#include "bench.h"
+#include "keyring-gen.h"
+
+using namespace rnp_bench;
+
+static const std::vector<size_t> keyring_sizes = {10, 100, 1000};
+
+/* generate keyring with the given number of EdDSA keys with X25519 subkeys */
+static std::vector<uint8_t>
+generate_keyring(size_t count)
+{
+    keyring_gen_params_t params;
+    pgp_key_sequence_t   keys;
+    std::vector<uint8_t> res;
+
+    params.primaries = count;
+    params.fast = true;
+    if (!keyring_generate(params, keys)) {
+        return res;
+    }
+    pgp_dest_t dst = {};
+    if (init_mem_dest(&dst, NULL, 0)) {
+        return res;
+    }
+    try {
+        rnp_key_store_t store(PGP_KEY_STORE_GPG, "");
+        if (keyring_add_to_store(keys, store, false) &&
+            rnp_key_store_write_to_dst(&store, &dst)) {
+            uint8_t *mem = (uint8_t *) mem_dest_get_memory(&dst);
+            res.assign(mem, mem + dst.writeb);
+        }
+    } catch (const std::exception &e) {
+        res.clear();
+    }
+    dst_close(&dst, true);
+    return res;
+}
+
+static const std::vector<uint8_t> &
+bench_keyring(size_t count)
+{
+    /* key generation is slow comparing to loading, so do it once per size */
+    static std::map<size_t, std::vector<uint8_t>> keyrings;
+    auto                                           it = keyrings.find(count);
+    if (it == keyrings.end()) {
+        it = keyrings.emplace(count, generate_keyring(count)).first;
+    }
+    return it->second;
+}
+
+static void
+bench_armor(State &state)
+{
+    std::vector<uint8_t> data = bench_data(state.arg());
+
+    while (state.keep_running()) {
+        pgp_source_t src = {};
+        pgp_dest_t   dst = {};
+        if (init_mem_src(&src, data.data(), data.size(), false) || init_null_dest(&dst)) {
+            state.skip_with_error("failed to init streams");
+            src_close(&src);
+            break;
+        }
+        rnp_result_t ret = rnp_armor_source(&src, &dst, PGP_ARMORED_MESSAGE);
+        src_close(&src);
+        dst_close(&dst, ret);
+        if (ret) {
+            state.skip_with_error("armoring failed");
+            break;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * data.size());
+}
+
+static void
+bench_dearmor(State &state)
+{
+    std::vector<uint8_t> data = bench_data(state.arg());
+    std::vector<uint8_t> armored;
+
+    pgp_source_t src = {};
+    pgp_dest_t   dst = {};
+    if (init_mem_src(&src, data.data(), data.size(), false) || init_mem_dest(&dst, NULL, 0)) {
+        src_close(&src);
+        state.skip_with_error("failed to init streams");
+        return;
+    }
+    rnp_result_t ret = rnp_armor_source(&src, &dst, PGP_ARMORED_MESSAGE);
+    if (!ret) {
+        uint8_t *mem = (uint8_t *) mem_dest_get_memory(&dst);
+        armored.assign(mem, mem + dst.writeb);
+    }
+    src_close(&src);
+    dst_close(&dst, true);
+    if (ret) {
+        state.skip_with_error("armoring failed");
+        return;
+    }
+
+    while (state.keep_running()) {
+        if (init_mem_src(&src, armored.data(), armored.size(), false) ||
+            init_null_dest(&dst)) {
+            state.skip_with_error("failed to init streams");
+            src_close(&src);
+            break;
+        }
+        ret = rnp_dearmor_source(&src, &dst);
+        src_close(&src);
+        dst_close(&dst, ret);
+        if (ret) {
+            state.skip_with_error("dearmoring failed");
+            break;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * armored.size());
+}
+
+static rnp_result_t
+parse_packets(pgp_source_t &src, size_t &count)
+{
+    while (!src_eof(&src)) {
+        pgp_packet_hdr_t hdr = {};
+        rnp_result_t     ret = stream_peek_packet_hdr(&src, &hdr);
+        if (ret) {
+            return ret;
+        }
+        switch (hdr.tag) {
+        case PGP_PKT_PUBLIC_KEY:
+        case PGP_PKT_PUBLIC_SUBKEY: {
+            pgp_key_pkt_t key;
+            ret = key.parse(src);
+            break;
+        }
+        case PGP_PKT_SIGNATURE: {
+            pgp_signature_t sig;
+            ret = sig.parse(src);
+            break;
+        }
+        case PGP_PKT_USER_ID: {
+            pgp_userid_pkt_t uid;
+            ret = uid.parse(src);
+            break;
+        }
+        default:
+            ret = stream_skip_packet(&src);
+        }
+        if (ret) {
+            return ret;
+        }
+        count++;
+    }
+    return RNP_SUCCESS;
+}
+
+static void
+bench_parse_packets(State &state)
+{
+    const std::vector<uint8_t> &keyring = bench_keyring(state.arg());
+    size_t                      count = 0;
+    if (keyring.empty()) {
+        state.skip_with_error("failed to generate keyring");
+        return;
+    }
+
+    while (state.keep_running()) {
+        pgp_source_t src = {};
+        if (init_mem_src(&src, keyring.data(), keyring.size(), false)) {
+            state.skip_with_error("failed to init source");
+            break;
+        }
+        rnp_result_t ret = parse_packets(src, count);
+        src_close(&src);
+        if (ret) {
+            state.skip_with_error("failed to parse packets");
+            break;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * keyring.size());
+    state.set_items_processed(count);
+}
+
+static void
+bench_keystore_read(State &state)
+{
+    const std::vector<uint8_t> &keyring = bench_keyring(state.arg());
+    if (keyring.empty()) {
+        state.skip_with_error("failed to generate keyring");
+        return;
+    }
+
+    while (state.keep_running()) {
+        pgp_source_t src = {};
+        if (init_mem_src(&src, keyring.data(), keyring.size(), false)) {
+            state.skip_with_error("failed to init source");
+            break;
+        }
+        std::unique_ptr<rnp_key_store_t> store(new rnp_key_store_t(PGP_KEY_STORE_GPG, ""));
+        rnp_result_t ret = rnp_key_store_pgp_read_from_src(store.get(), &src);
+        src_close(&src);
+        /* do not measure key store destruction */
+        state.pause_timing();
+        store.reset();
+        state.resume_timing();
+        if (ret) {
+            state.skip_with_error("failed to read keyring");
+            break;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * keyring.size());
+    state.set_items_processed(state.iterations() * state.arg());
+}
+
+static const bool streams_registered =
+  register_benchmark("armor", bench_armor, buffer_sizes) &&
+  register_benchmark("dearmor", bench_dearmor, buffer_sizes) &&
+  register_benchmark("parse_packets", bench_parse_packets, keyring_sizes, ARG_COUNT) &&
+  register_benchmark("keystore_read", bench_keystore_read, keyring_sizes, ARG_COUNT);
@@ -0,0 +1,432 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Benchmarks of the hot paths: hashing, symmetric ciphers, armoring, packet parsing, key
+ * store loading, signature verification and the whole encryption/decryption pipelines.
+ * Command line options and JSON output follow Google Benchmark conventions, so results may be
+ * compared with the same tooling.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <json.h>
+#include <rnp/rnp.h>
+#include "bench.h"
+
+namespace rnp_bench {
+
+const std::vector<size_t> buffer_sizes = {1024, 64 * 1024, 1024 * 1024};
+const std::vector<size_t> stream_sizes = {
+  1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 256 * 1024 * 1024, 1024 * 1024 * 1024};
+
+static uint64_t
+now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool
+State::keep_running()
+{
+    if (!started_) {
+        started_ = true;
+        resume_timing();
+    } else {
+        done_++;
+    }
+    if (error_.empty() && (done_ < iterations_)) {
+        return true;
+    }
+    pause_timing();
+    return false;
+}
+
+void
+State::pause_timing()
+{
+    if (running_) {
+        elapsed_ += now_ns() - start_;
+        running_ = false;
+    }
+}
+
+void
+State::resume_timing()
+{
+    if (!running_) {
+        start_ = now_ns();
+        running_ = true;
+    }
+}
+
+void
+State::skip_with_error(const std::string &error)
+{
+    error_ = error;
+}
+
+typedef struct bench_entry_t {
+    std::string         name;
+    bench_func_t        func;
+    std::vector<size_t> args;
+    arg_kind_t          kind;
+} bench_entry_t;
+
+static std::vector<bench_entry_t> &
+benchmarks()
+{
+    /* function-local to not depend on the static initialization order */
+    static std::vector<bench_entry_t> list;
+    return list;
+}
+
+bool
+register_benchmark(const std::string &        name,
+                   bench_func_t               func,
+                   const std::vector<size_t> &args,
+                   arg_kind_t                 kind)
+{
+    benchmarks().push_back({name, func, args, kind});
+    return true;
+}
+
+void
+bench_fill(uint8_t *buf, size_t len, uint64_t &seed)
+{
+    /* xorshift64, so data is the same on each run and platform */
+    for (size_t i = 0; i < len; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        buf[i] = (uint8_t) seed;
+    }
+}
+
+std::vector<uint8_t>
+bench_data(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    uint64_t             seed = 0x5DEECE66DULL;
+    bench_fill(data.data(), len, seed);
+    return data;
+}
+
+typedef struct bench_options_t {
+    std::string filter;
+    double      min_time = 0.5;
+    size_t      repetitions = 1;
+    size_t      max_size = 16 * 1024 * 1024;
+    bool        json = false;
+    bool        list = false;
+    std::string out;
+} bench_options_t;
+
+typedef struct bench_result_t {
+    std::string name;
+    std::string run_name;
+    size_t      repetition;
+    uint64_t    iterations;
+    double      real_time; /* per iteration, ns */
+    double      bytes_per_second;
+    double      items_per_second;
+    std::string error;
+} bench_result_t;
+
+static bool
+parse_size(const char *str, size_t &size)
+{
+    char *             end = NULL;
+    unsigned long long val = strtoull(str, &end, 10);
+    if (end == str) {
+        return false;
+    }
+    switch (*end) {
+    case 'K':
+    case 'k':
+        val *= 1024;
+        end++;
+        break;
+    case 'M':
+    case 'm':
+        val *= 1024 * 1024;
+        end++;
+        break;
+    case 'G':
+    case 'g':
+        val *= 1024 * 1024 * 1024;
+        end++;
+        break;
+    default:
+        break;
+    }
+    if (*end) {
+        return false;
+    }
+    size = val;
+    return true;
+}
+
+static bool
+parse_options(int argc, char **argv, bench_options_t &opts)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = strchr(arg, '=');
+        std::string name = val ? std::string(arg, val - arg) : std::string(arg);
+        val = val ? val + 1 : "";
+
+        if (name == "--benchmark_filter") {
+            opts.filter = val;
+        } else if (name == "--benchmark_min_time") {
+            opts.min_time = atof(val);
+            if (opts.min_time <= 0) {
+                fprintf(stderr, "Invalid min time: %s\n", val);
+                return false;
+            }
+        } else if (name == "--benchmark_repetitions") {
+            opts.repetitions = std::max(atoi(val), 1);
+        } else if (name == "--benchmark_format") {
+            if (strcmp(val, "json") && strcmp(val, "console")) {
+                fprintf(stderr, "Unsupported format: %s\n", val);
+                return false;
+            }
+            opts.json = !strcmp(val, "json");
+        } else if (name == "--benchmark_out") {
+            opts.out = val;
+        } else if (name == "--benchmark_list_tests") {
+            opts.list = true;
+        } else if (name == "--max_size") {
+            if (!parse_size(val, opts.max_size)) {
+                fprintf(stderr, "Invalid size: %s\n", val);
+                return false;
+            }
+        } else {
+            fprintf(stderr,
+                    "Usage: %s [--benchmark_filter=<substring>] [--benchmark_min_time=<sec>]\n"
+                    "       [--benchmark_repetitions=<n>] [--benchmark_format=console|json]\n"
+                    "       [--benchmark_out=<file>] [--benchmark_list_tests]\n"
+                    "       [--max_size=<bytes>[K|M|G]]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bench_result_t
+run_benchmark(const bench_entry_t &  bench,
+              size_t                 arg,
+              size_t                 repetition,
+              const bench_options_t &opts)
+{
+    const uint64_t min_ns = opts.min_time * 1e9;
+    uint64_t       iterations = 1;
+
+    bench_result_t res = {};
+    res.name = bench.name + "/" + std::to_string(arg);
+    res.run_name = res.name;
+    res.repetition = repetition;
+    while (true) {
+        State state(arg, iterations);
+        try {
+            bench.func(state);
+        } catch (const std::exception &e) {
+            state.skip_with_error(e.what());
+        }
+        if (!state.error().empty()) {
+            res.error = state.error();
+            return res;
+        }
+        uint64_t elapsed = std::max(state.elapsed_ns(), (uint64_t) 1);
+        if ((elapsed >= min_ns) || (iterations >= 1000000000)) {
+            double sec = elapsed / 1e9;
+            res.iterations = iterations;
+            res.real_time = (double) elapsed / iterations;
+            res.bytes_per_second = state.bytes_processed() / sec;
+            res.items_per_second = state.items_processed() / sec;
+            return res;
+        }
+        /* same approach as Google Benchmark: predict with 40% margin, grow at most 10x */
+        double mult = std::min(10.0, std::max(1.4 * min_ns / elapsed, 2.0));
+        iterations = (uint64_t)(iterations * mult);
+    }
+}
+
+static void
+print_console(const bench_result_t &res)
+{
+    if (!res.error.empty()) {
+        printf("%-40s ERROR: %s\n", res.name.c_str(), res.error.c_str());
+        return;
+    }
+    printf("%-40s %15.0f ns %12llu",
+           res.name.c_str(),
+           res.real_time,
+           (unsigned long long) res.iterations);
+    if (res.bytes_per_second > 0) {
+        printf(" %10.2f MiB/s", res.bytes_per_second / (1024 * 1024));
+    }
+    if (res.items_per_second > 0) {
+        printf(" %12.2f items/s", res.items_per_second);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static json_object *
+result_to_json(const bench_result_t &res)
+{
+    json_object *jso = json_object_new_object();
+    if (!jso) {
+        return NULL;
+    }
+    json_object_object_add(jso, "name", json_object_new_string(res.name.c_str()));
+    json_object_object_add(jso, "run_name", json_object_new_string(res.run_name.c_str()));
+    json_object_object_add(jso, "run_type", json_object_new_string("iteration"));
+    json_object_object_add(jso, "repetition_index", json_object_new_int64(res.repetition));
+    if (!res.error.empty()) {
+        json_object_object_add(jso, "error_occurred", json_object_new_boolean(true));
+        json_object_object_add(
+          jso, "error_message", json_object_new_string(res.error.c_str()));
+        return jso;
+    }
+    json_object_object_add(jso, "iterations", json_object_new_int64(res.iterations));
+    json_object_object_add(jso, "real_time", json_object_new_double(res.real_time));
+    json_object_object_add(jso, "time_unit", json_object_new_string("ns"));
+    if (res.bytes_per_second > 0) {
+        json_object_object_add(
+          jso, "bytes_per_second", json_object_new_double(res.bytes_per_second));
+    }
+    if (res.items_per_second > 0) {
+        json_object_object_add(
+          jso, "items_per_second", json_object_new_double(res.items_per_second));
+    }
+    return jso;
+}
+
+static json_object *
+context_to_json(const char *executable)
+{
+    json_object *jso = json_object_new_object();
+    if (!jso) {
+        return NULL;
+    }
+    char      date[64] = {0};
+    time_t    now = time(NULL);
+    struct tm tm = {};
+#ifdef _WIN32
+    localtime_s(&tm, &now);
+#else
+    localtime_r(&now, &tm);
+#endif
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &tm);
+    json_object_object_add(jso, "date", json_object_new_string(date));
+    json_object_object_add(jso, "executable", json_object_new_string(executable));
+    json_object_object_add(
+      jso, "num_cpus", json_object_new_int64(std::thread::hardware_concurrency()));
+    json_object_object_add(
+      jso, "library_version", json_object_new_string(rnp_version_string_full()));
+#ifdef NDEBUG
+    json_object_object_add(jso, "library_build_type", json_object_new_string("release"));
+#else
+    json_object_object_add(jso, "library_build_type", json_object_new_string("debug"));
+#endif
+    return jso;
+}
+
+static int
+run_benchmarks(int argc, char **argv)
+{
+    bench_options_t opts;
+    if (!parse_options(argc, argv, opts)) {
+        return EXIT_FAILURE;
+    }
+
+    json_object *jsoresults = json_object_new_array();
+    if (!jsoresults) {
+        return EXIT_FAILURE;
+    }
+    bool console = !opts.json || !opts.out.empty();
+    for (auto &bench : benchmarks()) {
+        for (size_t arg : bench.args) {
+            if ((bench.kind == ARG_SIZE) && (arg > opts.max_size)) {
+                continue;
+            }
+            std::string name = bench.name + "/" + std::to_string(arg);
+            if (!opts.filter.empty() && (name.find(opts.filter) == std::string::npos)) {
+                continue;
+            }
+            if (opts.list) {
+                printf("%s\n", name.c_str());
+                continue;
+            }
+            for (size_t rep = 0; rep < opts.repetitions; rep++) {
+                /* errors are reported, but do not fail the run, like unsupported algorithm */
+                bench_result_t res = run_benchmark(bench, arg, rep, opts);
+                if (console) {
+                    print_console(res);
+                }
+                json_object_array_add(jsoresults, result_to_json(res));
+            }
+        }
+    }
+    if (opts.list || (!opts.json && opts.out.empty())) {
+        json_object_put(jsoresults);
+        return EXIT_SUCCESS;
+    }
+
+    json_object *jso = json_object_new_object();
+    json_object_object_add(jso, "context", context_to_json(argv[0]));
+    json_object_object_add(jso, "benchmarks", jsoresults);
+    const char *str = json_object_to_json_string_ext(jso, JSON_C_TO_STRING_PRETTY);
+    FILE *      out = opts.out.empty() ? stdout : fopen(opts.out.c_str(), "w");
+    bool        failed = !out;
+    if (!out) {
+        fprintf(stderr, "Failed to open %s\n", opts.out.c_str());
+    } else {
+        fprintf(out, "%s\n", str);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+    json_object_put(jso);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace rnp_bench
+
+int
+main(int argc, char **argv)
+{
+    return rnp_bench::run_benchmarks(argc, argv);
+}
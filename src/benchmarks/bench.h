@@ -0,0 +1,138 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_BENCH_H
+#define RNP_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rnp_bench {
+
+/** State of the single benchmark run. Benchmark function should do its setup, then run the
+ *  measured code in the `while (state.keep_running())` loop, and report the amount of
+ *  processed data afterwards. Only time spent inside of the loop is measured.
+ */
+class State {
+    size_t      arg_;
+    uint64_t    iterations_;
+    uint64_t    done_{};
+    uint64_t    start_{};
+    uint64_t    elapsed_{};
+    bool        started_{};
+    bool        running_{};
+    uint64_t    bytes_{};
+    uint64_t    items_{};
+    std::string error_{};
+
+  public:
+    State(size_t arg, uint64_t iterations) : arg_(arg), iterations_(iterations){};
+
+    /* returns true while there are iterations left */
+    bool keep_running();
+    /* exclude part of the iteration (i.e. per-iteration setup) from the measured time */
+    void pause_timing();
+    void resume_timing();
+    /* mark the run as failed, keep_running() would return false afterwards */
+    void skip_with_error(const std::string &error);
+
+    size_t
+    arg() const
+    {
+        return arg_;
+    }
+    uint64_t
+    iterations() const
+    {
+        return iterations_;
+    }
+    /* total number of bytes/items processed by all iterations, to report throughput */
+    void
+    set_bytes_processed(uint64_t bytes)
+    {
+        bytes_ = bytes;
+    }
+    void
+    set_items_processed(uint64_t items)
+    {
+        items_ = items;
+    }
+
+    uint64_t
+    elapsed_ns() const
+    {
+        return elapsed_;
+    }
+    uint64_t
+    bytes_processed() const
+    {
+        return bytes_;
+    }
+    uint64_t
+    items_processed() const
+    {
+        return items_;
+    }
+    const std::string &
+    error() const
+    {
+        return error_;
+    }
+};
+
+typedef std::function<void(State &)> bench_func_t;
+
+/* kind of the benchmark argument: data size is limited via the --max_size option */
+typedef enum { ARG_SIZE, ARG_COUNT } arg_kind_t;
+
+/** @brief register the benchmark, which would be run for each of the arguments
+ *  @param name benchmark name, argument value is appended to it in the results
+ *  @param func benchmark function
+ *  @param args list of the argument values
+ *  @param kind what the argument means
+ *  @return true, so function may be used to initialize static variable
+ */
+bool register_benchmark(const std::string &        name,
+                        bench_func_t               func,
+                        const std::vector<size_t> &args,
+                        arg_kind_t                 kind = ARG_SIZE);
+
+/* data sizes used by the benchmarks operating on buffers in memory */
+extern const std::vector<size_t> buffer_sizes;
+/* data sizes used by the full pipelines, larger ones are skipped unless enabled */
+extern const std::vector<size_t> stream_sizes;
+
+/* reproducible pseudo-random data of the given length */
+std::vector<uint8_t> bench_data(size_t len);
+/* fill the buffer with reproducible pseudo-random data, continuing from the seed */
+void bench_fill(uint8_t *buf, size_t len, uint64_t &seed);
+
+} // namespace rnp_bench
+
+#endif
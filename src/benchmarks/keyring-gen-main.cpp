@@ -0,0 +1,137 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "crypto/mpi.h"
+#include "keyring-gen.h"
+
+using namespace rnp_bench;
+
+static void
+print_usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s --output=<dir> [--format=GPG|KBX|G10] [--primaries=<n>]\n"
+            "       [--subkeys=<n>] [--userids=<n>] [--density=<0..1>]\n"
+            "       [--alg=eddsa|ecdsa|rsa] [--bits=<1024..16384>] [--seed=<n>] [--fast]\n",
+            name);
+}
+
+static bool
+parse_count(const char *str, size_t &val)
+{
+    char *             end = NULL;
+    unsigned long long res = strtoull(str, &end, 10);
+    if ((end == str) || *end) {
+        return false;
+    }
+    val = res;
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    keyring_gen_params_t   params;
+    pgp_key_store_format_t format = PGP_KEY_STORE_GPG;
+    std::string            output;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = strchr(arg, '=');
+        std::string name = val ? std::string(arg, val - arg) : std::string(arg);
+        val = val ? val + 1 : "";
+        bool ok = true;
+
+        if (name == "--output") {
+            output = val;
+        } else if (name == "--format") {
+            if (!strcmp(val, "GPG")) {
+                format = PGP_KEY_STORE_GPG;
+            } else if (!strcmp(val, "KBX")) {
+                format = PGP_KEY_STORE_KBX;
+            } else if (!strcmp(val, "G10")) {
+                format = PGP_KEY_STORE_G10;
+            } else {
+                ok = false;
+            }
+        } else if (name == "--primaries") {
+            ok = parse_count(val, params.primaries);
+        } else if (name == "--subkeys") {
+            ok = parse_count(val, params.subkeys);
+        } else if (name == "--userids") {
+            ok = parse_count(val, params.userids) && params.userids;
+        } else if (name == "--density") {
+            char *end = NULL;
+            params.density = strtod(val, &end);
+            ok = (end != val) && !*end && (params.density >= 0) && (params.density <= 1);
+        } else if (name == "--alg") {
+            if (!strcmp(val, "eddsa")) {
+                params.alg = KEYRING_GEN_EDDSA;
+            } else if (!strcmp(val, "ecdsa")) {
+                params.alg = KEYRING_GEN_ECDSA;
+            } else if (!strcmp(val, "rsa")) {
+                params.alg = KEYRING_GEN_RSA;
+            } else {
+                ok = false;
+            }
+        } else if (name == "--bits") {
+            ok = parse_count(val, params.bits) && (params.bits >= 1024) &&
+                 (params.bits <= PGP_MPINT_BITS);
+        } else if (name == "--seed") {
+            size_t seed = 0;
+            ok = parse_count(val, seed);
+            params.seed = seed;
+        } else if (name == "--fast") {
+            params.fast = true;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (!ok) {
+            fprintf(stderr, "Invalid value of %s: %s\n", name.c_str(), val);
+            return EXIT_FAILURE;
+        }
+    }
+    if (output.empty()) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    pgp_key_sequence_t keys;
+    if (!keyring_generate(params, keys)) {
+        fprintf(stderr, "Failed to generate keys\n");
+        return EXIT_FAILURE;
+    }
+    if (!keyring_write(keys, output, format)) {
+        fprintf(stderr, "Failed to write keyring to %s\n", output.c_str());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,374 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <vector>
+#include <librekey/key_store_pgp.h>
+#include <librekey/key_store_g10.h>
+#include <librepgp/stream-common.h>
+#include "crypto.h"
+#include "crypto/mpi.h"
+#include "crypto/rng.h"
+#include "file-utils.h"
+#include "logging.h"
+#include "utils.h"
+#include "keyring-gen.h"
+
+namespace rnp_bench {
+
+static uint64_t
+keyring_gen_next(uint64_t &state)
+{
+    /* splitmix64, so certification graph is the same on each platform */
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void
+keyring_gen_crypto(const keyring_gen_params_t &params,
+                   rng_t *                     rng,
+                   rnp_keygen_crypto_params_t &primary,
+                   rnp_keygen_crypto_params_t &sub)
+{
+    primary = {};
+    sub = {};
+    primary.hash_alg = sub.hash_alg = PGP_HASH_SHA256;
+    primary.rng = sub.rng = rng;
+    switch (params.alg) {
+    case KEYRING_GEN_ECDSA:
+        primary.key_alg = PGP_PKA_ECDSA;
+        primary.ecc.curve = PGP_CURVE_NIST_P_256;
+        sub.key_alg = PGP_PKA_ECDH;
+        sub.ecc.curve = PGP_CURVE_NIST_P_256;
+        break;
+    case KEYRING_GEN_RSA:
+        primary.key_alg = sub.key_alg = PGP_PKA_RSA;
+        primary.rsa.modulus_bit_len = sub.rsa.modulus_bit_len = params.bits;
+        break;
+    default:
+        primary.key_alg = PGP_PKA_EDDSA;
+        primary.ecc.curve = PGP_CURVE_ED25519;
+        sub.key_alg = PGP_PKA_ECDH;
+        sub.ecc.curve = PGP_CURVE_25519;
+        break;
+    }
+}
+
+/* generate new key or copy the template one, then set the deterministic creation time */
+static bool
+keyring_gen_key(const rnp_keygen_crypto_params_t &crypto,
+                pgp_key_pkt_t &                   key,
+                pgp_key_pkt_t &                   tmpl,
+                bool                              fast,
+                bool                              primary,
+                uint32_t                          creation)
+{
+    if (!fast || !tmpl.material.secret) {
+        if (!pgp_generate_seckey(&crypto, &key, primary)) {
+            RNP_LOG("failed to generate key");
+            return false;
+        }
+        if (fast) {
+            tmpl = key;
+        }
+    } else {
+        key = tmpl;
+    }
+    key.creation_time = creation;
+    /* hashed data includes creation time, so must be recalculated */
+    free(key.hashed_data);
+    key.hashed_data = NULL;
+    key.hashed_len = 0;
+    return true;
+}
+
+static std::string
+keyring_gen_userid(size_t key, size_t uid)
+{
+    std::string id = std::to_string(key) + "." + std::to_string(uid);
+    return "keyring-gen " + id + " <key" + id + "@example.com>";
+}
+
+static bool
+keyring_gen_transferable(const keyring_gen_params_t &      params,
+                         const rnp_keygen_crypto_params_t &pcrypto,
+                         const rnp_keygen_crypto_params_t &scrypto,
+                         pgp_key_pkt_t &                   ptmpl,
+                         pgp_key_pkt_t &                   stmpl,
+                         size_t                            idx,
+                         pgp_transferable_key_t &          tkey)
+{
+    uint32_t creation = params.base_time + idx * (params.subkeys + 1);
+    if (!keyring_gen_key(pcrypto, tkey.key, ptmpl, params.fast, true, creation)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < params.userids; i++) {
+        std::string                uidstr = keyring_gen_userid(idx, i);
+        pgp_transferable_userid_t *uid = transferable_key_add_userid(tkey, uidstr.c_str());
+        if (!uid) {
+            RNP_LOG("failed to add userid");
+            return false;
+        }
+        rnp_selfsig_cert_info_t cert = {};
+        cert.key_flags = PGP_KF_SIGN | PGP_KF_CERTIFY;
+        cert.primary = !i;
+        if (!transferable_userid_certify(tkey.key, *uid, tkey.key, pcrypto.hash_alg, cert)) {
+            RNP_LOG("failed to certify userid");
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < params.subkeys; i++) {
+        try {
+            tkey.subkeys.emplace_back();
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+            return false;
+        }
+        pgp_transferable_subkey_t &sub = tkey.subkeys.back();
+        uint32_t                   subcreation = creation + i + 1;
+        if (!keyring_gen_key(scrypto, sub.subkey, stmpl, params.fast, false, subcreation)) {
+            return false;
+        }
+        rnp_selfsig_binding_info_t binding = {};
+        binding.key_flags = PGP_KF_ENCRYPT_COMMS | PGP_KF_ENCRYPT_STORAGE;
+        if (!transferable_subkey_bind(tkey.key, sub, pcrypto.hash_alg, binding)) {
+            RNP_LOG("failed to bind subkey");
+            return false;
+        }
+    }
+    return true;
+}
+
+/* each userid is certified by the density share of the other primary keys */
+static bool
+keyring_gen_certify(const keyring_gen_params_t &params,
+                    pgp_transferable_key_t *    keys,
+                    size_t                      count)
+{
+    size_t certs = params.density * (count - 1) + 0.5;
+    if (!certs || (count < 2)) {
+        return true;
+    }
+    certs = std::min(certs, count - 1);
+
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    uint64_t                state = params.seed;
+    rnp_selfsig_cert_info_t cert = {};
+    for (size_t idx = 0; idx < count; idx++) {
+        for (auto &uid : keys[idx].userids) {
+            /* partial Fisher-Yates shuffle, skipping the key itself */
+            size_t picked = 0;
+            for (size_t i = 0; (picked < certs) && (i < count); i++) {
+                size_t j = i + keyring_gen_next(state) % (count - i);
+                std::swap(order[i], order[j]);
+                if (order[i] == idx) {
+                    continue;
+                }
+                const pgp_key_pkt_t &signer = keys[order[i]].key;
+                if (!transferable_userid_certify(
+                      keys[idx].key, uid, signer, PGP_HASH_SHA256, cert)) {
+                    RNP_LOG("failed to add certification");
+                    return false;
+                }
+                picked++;
+            }
+        }
+    }
+    return true;
+}
+
+bool
+keyring_generate(const keyring_gen_params_t &params, pgp_key_sequence_t &keys)
+{
+    if ((params.density < 0) || (params.density > 1)) {
+        RNP_LOG("invalid certification density");
+        return false;
+    }
+    if ((params.alg == KEYRING_GEN_RSA) &&
+        ((params.bits < 1024) || (params.bits > PGP_MPINT_BITS))) {
+        RNP_LOG("invalid RSA key size: %zu", params.bits);
+        return false;
+    }
+
+    rng_t rng = {};
+    if (!rng_init(&rng, RNG_DRBG)) {
+        RNP_LOG("failed to initialize rng");
+        return false;
+    }
+
+    rnp_keygen_crypto_params_t pcrypto = {};
+    rnp_keygen_crypto_params_t scrypto = {};
+    keyring_gen_crypto(params, &rng, pcrypto, scrypto);
+
+    pgp_key_pkt_t ptmpl;
+    pgp_key_pkt_t stmpl;
+    size_t        start = keys.keys.size();
+    bool          ok = false;
+    try {
+        keys.keys.resize(start + params.primaries);
+        size_t idx = 0;
+        for (; idx < params.primaries; idx++) {
+            if (!keyring_gen_transferable(
+                  params, pcrypto, scrypto, ptmpl, stmpl, idx, keys.keys[start + idx])) {
+                break;
+            }
+        }
+        ok = (idx == params.primaries) &&
+             keyring_gen_certify(params, keys.keys.data() + start, params.primaries);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        ok = false;
+    }
+    if (!ok) {
+        keys.keys.resize(start);
+    }
+    rng_destroy(&rng);
+    return ok;
+}
+
+bool
+keyring_add_to_store(const pgp_key_sequence_t &keys, rnp_key_store_t &store, bool secret)
+{
+    try {
+        for (auto &key : keys.keys) {
+            pgp_transferable_key_t tkey(key, !secret);
+            if (!rnp_key_store_add_transferable_key(&store, &tkey)) {
+                return false;
+            }
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+    return true;
+}
+
+static bool
+keyring_write_store(const pgp_key_sequence_t &keys,
+                    const std::string &       path,
+                    pgp_key_store_format_t    format,
+                    bool                      secret)
+{
+    try {
+        rnp_key_store_t store(format, path);
+        if (!keyring_add_to_store(keys, store, secret)) {
+            return false;
+        }
+        return rnp_key_store_write_to_path(&store);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+}
+
+static bool
+keyring_write_g10_key(const pgp_key_pkt_t &  key,
+                      const std::string &    dir,
+                      std::set<std::string> &written)
+{
+    pgp_key_grip_t grip = {};
+    char           grips[PGP_KEY_GRIP_SIZE * 2 + 1];
+    if (!rnp_key_store_get_key_grip(&key.material, grip)) {
+        return false;
+    }
+    rnp_strhexdump_upper(grips, grip.data(), grip.size(), "");
+    /* keys with reused material share the same grip and file */
+    if (!written.insert(grips).second) {
+        return true;
+    }
+
+    std::string path = dir + "/" + grips + ".key";
+    pgp_dest_t  dst = {};
+    if (init_tmpfile_dest(&dst, path.c_str(), true)) {
+        return false;
+    }
+    pgp_key_pkt_t seckey(key);
+    bool          ok = g10_write_seckey(&dst, &seckey, NULL) && !dst_finish(&dst);
+    dst_close(&dst, !ok);
+    return ok;
+}
+
+static bool
+keyring_write_g10(const pgp_key_sequence_t &keys, const std::string &dir)
+{
+    if (RNP_MKDIR(dir.c_str(), S_IRWXU) && (errno != EEXIST)) {
+        RNP_LOG("mkdir(%s): %s", dir.c_str(), strerror(errno));
+        return false;
+    }
+    try {
+        std::set<std::string> written;
+        for (auto &key : keys.keys) {
+            if (!keyring_write_g10_key(key.key, dir, written)) {
+                RNP_LOG("failed to write G10 key");
+                return false;
+            }
+            for (auto &sub : key.subkeys) {
+                if (!keyring_write_g10_key(sub.subkey, dir, written)) {
+                    RNP_LOG("failed to write G10 subkey");
+                    return false;
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool
+keyring_write(const pgp_key_sequence_t &keys,
+              const std::string &       dir,
+              pgp_key_store_format_t    format)
+{
+    switch (format) {
+    case PGP_KEY_STORE_GPG:
+        return keyring_write_store(keys, dir + "/pubring.gpg", format, false) &&
+               keyring_write_store(keys, dir + "/secring.gpg", format, true);
+    case PGP_KEY_STORE_KBX:
+        return keyring_write_store(keys, dir + "/pubring.kbx", format, false) &&
+               keyring_write_store(keys, dir + "/secring.kbx", format, true);
+    case PGP_KEY_STORE_G10:
+        return keyring_write_store(keys, dir + "/pubring.kbx", PGP_KEY_STORE_KBX, false) &&
+               keyring_write_g10(keys, dir + "/private-keys-v1.d");
+    default:
+        RNP_LOG("unsupported key store format: %d", (int) format);
+        return false;
+    }
+}
+
+} // namespace rnp_bench
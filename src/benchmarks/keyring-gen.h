@@ -0,0 +1,90 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_KEYRING_GEN_H
+#define RNP_KEYRING_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <rekey/rnp_key_store.h>
+#include <librepgp/stream-key.h>
+
+namespace rnp_bench {
+
+typedef enum { KEYRING_GEN_EDDSA, KEYRING_GEN_ECDSA, KEYRING_GEN_RSA } keyring_gen_alg_t;
+
+/** Parameters of the synthetic keyring. Keyring structure, userids, key creation times and
+ *  the certification graph depend only on these values, so the same parameters give the same
+ *  keyring layout on each run.
+ */
+typedef struct keyring_gen_params_t {
+    size_t            primaries{100};
+    size_t            subkeys{1};
+    size_t            userids{1};
+    /* fraction of the other primary keys, certifying each of the userids, 0..1 */
+    double            density{};
+    keyring_gen_alg_t alg{KEYRING_GEN_EDDSA};
+    /* RSA key size, 1024..16384, ignored for other algorithms */
+    size_t            bits{2048};
+    /* generate key material once and reuse it for all keys with different creation times */
+    bool              fast{};
+    uint64_t          seed{1};
+    /* creation time of the first key, following keys get the next seconds */
+    uint32_t          base_time{1577836800};
+} keyring_gen_params_t;
+
+/** @brief generate unprotected secret keys with self-signatures and third-party
+ *         certifications, as described by the params
+ *  @param params keyring parameters
+ *  @param keys generated keys will be appended here
+ *  @return true on success or false otherwise
+ */
+bool keyring_generate(const keyring_gen_params_t &params, pgp_key_sequence_t &keys);
+
+/** @brief add generated keys to the key store
+ *  @param keys keys, generated by keyring_generate()
+ *  @param store GPG or KBX key store
+ *  @param secret add secret keys if true or their public parts otherwise
+ *  @return true on success or false otherwise
+ */
+bool keyring_add_to_store(const pgp_key_sequence_t &keys, rnp_key_store_t &store, bool secret);
+
+/** @brief write generated keys to the directory, using GnuPG file names: pubring.gpg and
+ *         secring.gpg for GPG, pubring.kbx and secring.kbx for KBX, pubring.kbx and
+ *         private-keys-v1.d for G10.
+ *  @param keys keys, generated by keyring_generate()
+ *  @param dir existing directory
+ *  @param format key store format
+ *  @return true on success or false otherwise
+ */
+bool keyring_write(const pgp_key_sequence_t &keys,
+                   const std::string &       dir,
+                   pgp_key_store_format_t    format);
+
+} // namespace rnp_bench
+
+#endif
@@ -77,27 +77,13 @@ __RCSID("$NetBSD: crypto.c,v 1.36 2014/02/17 07:39:19 agc Exp $");
 #include "crypto/common.h"
 #include "crypto.h"
 #include "fingerprint.h"
+#include "key-pool.h"
 #include "pgp-key.h"
 #include "utils.h"
 
-bool
-pgp_generate_seckey(const rnp_keygen_crypto_params_t *crypto,
-                    pgp_key_pkt_t *                   seckey,
-                    bool                              primary)
+static bool
+pgp_generate_key_material(const rnp_keygen_crypto_params_t *crypto, pgp_key_pkt_t *seckey)
 {
-    if (!crypto || !seckey) {
-        RNP_LOG("NULL args");
-        return false;
-    }
-
-    /* populate pgp key structure */
-    *seckey = {};
-    seckey->version = PGP_V4;
-    seckey->creation_time = time(NULL);
-    seckey->alg = crypto->key_alg;
-    seckey->material.alg = crypto->key_alg;
-    seckey->tag = primary ? PGP_PKT_SECRET_KEY : PGP_PKT_SECRET_SUBKEY;
-
     switch (seckey->alg) {
     case PGP_PKA_RSA:
         if (rsa_generate(crypto->rng, &seckey->material.rsa, crypto->rsa.modulus_bit_len)) {
@@ -153,6 +139,37 @@ pgp_generate_seckey(const rnp_keygen_crypto_params_t *crypto,
         RNP_LOG("key generation not implemented for PK alg: %d", seckey->alg);
         return false;
     }
+    return true;
+}
+
+bool
+pgp_generate_seckey(const rnp_keygen_crypto_params_t *crypto,
+                    pgp_key_pkt_t *                   seckey,
+                    bool                              primary)
+{
+    if (!crypto || !seckey) {
+        RNP_LOG("NULL args");
+        return false;
+    }
+
+    /* populate pgp key structure */
+    *seckey = {};
+    seckey->version = PGP_V4;
+    seckey->creation_time = time(NULL);
+    seckey->alg = crypto->key_alg;
+    seckey->material.alg = crypto->key_alg;
+    seckey->tag = primary ? PGP_PKT_SECRET_KEY : PGP_PKT_SECRET_SUBKEY;
+
+    /* use pre-generated key material if there is one available */
+    bool pooled = false;
+    try {
+        pooled = crypto->pool && crypto->pool->take(*crypto, seckey->material);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+    }
+    if (!pooled && !pgp_generate_key_material(crypto, seckey)) {
+        return false;
+    }
     seckey->sec_protection.s2k.usage = PGP_S2KU_NONE;
     seckey->material.secret = true;
     /* fill the sec_data/sec_len */
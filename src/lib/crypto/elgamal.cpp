@@ -86,7 +86,7 @@
 // Max supported key byte size
 #define ELGAMAL_MAX_P_BYTELEN BITS_TO_BYTES(PGP_MPINT_BITS)
 
-static bool
+bool
 elgamal_load_public_key(botan_pubkey_t *pubkey, const pgp_eg_key_t *keydata)
 {
     bignum_t *p = NULL;
@@ -174,16 +174,17 @@ elgamal_encrypt_pkcs1(rng_t *             rng,
                       pgp_eg_encrypted_t *out,
                       const uint8_t *     in,
                       size_t              in_len,
-                      const pgp_eg_key_t *key)
+                      const pgp_eg_key_t *key,
+                      botan_pubkey_t      bkey)
 {
-    botan_pubkey_t        b_key = NULL;
+    botan_pubkey_t        b_key = bkey;
     botan_pk_op_encrypt_t op_ctx = NULL;
     rnp_result_t          ret = RNP_ERROR_BAD_PARAMETERS;
     /* Max size of an output len is twice an order of underlying group (p length) */
     uint8_t enc_buf[ELGAMAL_MAX_P_BYTELEN * 2] = {0};
     size_t  p_len;
 
-    if (!elgamal_load_public_key(&b_key, key)) {
+    if (!b_key && !elgamal_load_public_key(&b_key, key)) {
         RNP_LOG("Failed to load public key");
         goto end;
     }
@@ -219,7 +220,9 @@ elgamal_encrypt_pkcs1(rng_t *             rng,
     }
 end:
     botan_pk_op_encrypt_destroy(op_ctx);
-    botan_pubkey_destroy(b_key);
+    if (b_key != bkey) {
+        botan_pubkey_destroy(b_key);
+    }
     return ret;
 }
 
@@ -32,6 +32,7 @@
 #define RNP_ELG_H_
 
 #include <stdint.h>
+#include <botan/ffi.h>
 #include "crypto/rng.h"
 #include "crypto/mpi.h"
 
@@ -57,6 +58,8 @@ typedef struct pgp_eg_encrypted_t {
 
 rnp_result_t elgamal_validate_key(rng_t *rng, const pgp_eg_key_t *key, bool secret);
 
+bool elgamal_load_public_key(botan_pubkey_t *pubkey, const pgp_eg_key_t *keydata);
+
 /*
  * Performs ElGamal encryption
  * Result of an encryption is composed of two parts - g2k and encm
@@ -66,6 +69,7 @@ rnp_result_t elgamal_validate_key(rng_t *rng, const pgp_eg_key_t *key, bool secr
  * @param in plaintext to be encrypted
  * @param in_len length of the plaintext
  * @param key public key to be used for encryption
+ * @param bkey preloaded backend key for the key or NULL. It is not destroyed.
  *
  * @pre out: must be valid pointer to corresponding structure
  * @pre in_len: can't be bigger than byte size of `p'
@@ -78,7 +82,8 @@ rnp_result_t elgamal_encrypt_pkcs1(rng_t *             rng,
                                    pgp_eg_encrypted_t *out,
                                    const uint8_t *     in,
                                    size_t              in_len,
-                                   const pgp_eg_key_t *key);
+                                   const pgp_eg_key_t *key,
+                                   botan_pubkey_t      bkey = NULL);
 
 /*
  * Performs ElGamal decryption
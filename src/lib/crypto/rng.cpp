@@ -30,7 +30,15 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include <botan/ffi.h>
+#include "config.h"
+#ifndef _MSC_VER
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
 #include "rng.h"
 
 static inline bool
@@ -41,11 +49,59 @@ rng_ensure_initialized(rng_t *ctx)
         return true;
     }
 
+    if (ctx->rng_type == RNG_BUFFERED) {
+        if (!ctx->buffer && !(ctx->buffer = (uint8_t *) malloc(RNG_BUFFER_SIZE))) {
+            return false;
+        }
+        ctx->available = 0;
+        ctx->reseed = RNG_RESEED_BYTES;
+    }
     ctx->initialized =
-      !botan_rng_init(&ctx->botan_rng, ctx->rng_type == RNG_DRBG ? "user" : NULL);
+      !botan_rng_init(&ctx->botan_rng, ctx->rng_type != RNG_SYSTEM ? "user" : NULL);
     return ctx->initialized;
 }
 
+static bool
+rng_fill_buffer(rng_t *ctx)
+{
+    /* DRBG reseeds itself each 1024 requests, but requests are large here */
+    if (ctx->reseed < RNG_BUFFER_SIZE) {
+        if (botan_rng_reseed(ctx->botan_rng, 256)) {
+            return false;
+        }
+        ctx->reseed = RNG_RESEED_BYTES;
+    }
+    if (botan_rng_get(ctx->botan_rng, ctx->buffer, RNG_BUFFER_SIZE)) {
+        return false;
+    }
+    ctx->reseed -= RNG_BUFFER_SIZE;
+    ctx->available = RNG_BUFFER_SIZE;
+    ctx->pid = getpid();
+    return true;
+}
+
+static bool
+rng_get_buffered(rng_t *ctx, uint8_t *data, size_t len)
+{
+    /* buffer contents must not be reused by the forked process */
+    if (ctx->available && (ctx->pid != getpid())) {
+        botan_scrub_mem(ctx->buffer, RNG_BUFFER_SIZE);
+        ctx->available = 0;
+    }
+    /* large requests are not worth buffering */
+    if (len > RNG_BUFFER_SIZE / 4) {
+        return !botan_rng_get(ctx->botan_rng, data, len);
+    }
+    if ((ctx->available < len) && !rng_fill_buffer(ctx)) {
+        return false;
+    }
+    uint8_t *src = ctx->buffer + RNG_BUFFER_SIZE - ctx->available;
+    memcpy(data, src, len);
+    botan_scrub_mem(src, len);
+    ctx->available -= len;
+    return true;
+}
+
 bool
 rng_init(rng_t *ctx, rng_type_t rng_type)
 {
@@ -53,11 +109,15 @@ rng_init(rng_t *ctx, rng_type_t rng_type)
         return false;
     }
 
-    if ((rng_type != RNG_DRBG) && (rng_type != RNG_SYSTEM)) {
+    ctx->initialized = false;
+    ctx->buffer = NULL;
+    ctx->available = 0;
+    ctx->reseed = 0;
+    ctx->pid = 0;
+    if ((rng_type != RNG_DRBG) && (rng_type != RNG_SYSTEM) && (rng_type != RNG_BUFFERED)) {
         return false;
     }
 
-    ctx->initialized = false;
     ctx->rng_type = rng_type;
     return (rng_type == RNG_SYSTEM) ? rng_ensure_initialized(ctx) : true;
 }
@@ -65,7 +125,16 @@ rng_init(rng_t *ctx, rng_type_t rng_type)
 void
 rng_destroy(rng_t *ctx)
 {
-    if (!ctx || !ctx->initialized) {
+    if (!ctx) {
+        return;
+    }
+    if (ctx->buffer) {
+        botan_scrub_mem(ctx->buffer, RNG_BUFFER_SIZE);
+        free(ctx->buffer);
+        ctx->buffer = NULL;
+        ctx->available = 0;
+    }
+    if (!ctx->initialized) {
         return;
     }
 
@@ -85,6 +154,10 @@ rng_get_data(rng_t *ctx, uint8_t *data, size_t len)
         return false;
     }
 
+    if (ctx->rng_type == RNG_BUFFERED) {
+        return rng_get_buffered(ctx, data, len);
+    }
+
     if (botan_rng_get(ctx->botan_rng, data, len)) {
         // This should never happen
         return false;
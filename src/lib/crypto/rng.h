@@ -36,25 +36,41 @@
 #include <stdint.h>
 #include <stdlib.h>
 
-enum { RNG_DRBG, RNG_SYSTEM };
+enum { RNG_DRBG, RNG_SYSTEM, RNG_BUFFERED };
 typedef uint8_t                  rng_type_t;
 typedef struct botan_rng_struct *botan_rng_t;
 
+/* Size of the pre-generated random data buffer for RNG_BUFFERED */
+#define RNG_BUFFER_SIZE 4096
+/* Number of bytes, generated by RNG_BUFFERED between the explicit reseeds */
+#define RNG_RESEED_BYTES (1024 * 1024)
+
 typedef struct rng_st_t {
     bool        initialized;
     rng_type_t  rng_type;
     botan_rng_t botan_rng;
+    /* fields below are used by RNG_BUFFERED only */
+    uint8_t *buffer;    /* pre-generated random data */
+    size_t   available; /* number of not yet used bytes at the end of the buffer */
+    size_t   reseed;    /* number of bytes which may be generated before the reseed */
+    long     pid;       /* id of the process which filled the buffer */
 } rng_t;
 
 /*
  * @brief Initializes rng structure
  *
  * @param rng_type indicates which random generator to initialize.
- *        Two values possible
+ *        Three values possible
  *          RNG_DRBG - will initialize HMAC_DRBG, this generator
  *                     is initialized on-demand (when used for the
  *                     first time)
  *          RNG_SYSTEM will initialize /dev/(u)random
+ *          RNG_BUFFERED - HMAC_DRBG as for RNG_DRBG, but small requests
+ *                     to rng_get_data() are served from the buffer of
+ *                     RNG_BUFFER_SIZE pre-generated bytes. Used bytes
+ *                     are wiped, DRBG is reseeded each RNG_RESEED_BYTES
+ *                     bytes, and buffer is dropped after the fork().
+ *                     Object must not be shared between threads.
  * @returns false if lazy initialization wasn't requested
  *          and initialization failed, otherwise true
  */
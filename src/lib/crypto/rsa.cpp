@@ -140,7 +140,7 @@ done:
     return ret;
 }
 
-static bool
+bool
 rsa_load_public_key(botan_pubkey_t *bkey, const pgp_rsa_key_t *key)
 {
     bignum_t *n = NULL;
@@ -195,13 +195,14 @@ rsa_encrypt_pkcs1(rng_t *              rng,
                   pgp_rsa_encrypted_t *out,
                   const uint8_t *      in,
                   size_t               in_len,
-                  const pgp_rsa_key_t *key)
+                  const pgp_rsa_key_t *key,
+                  botan_pubkey_t       bkey)
 {
     rnp_result_t          ret = RNP_ERROR_GENERIC;
-    botan_pubkey_t        rsa_key = NULL;
+    botan_pubkey_t        rsa_key = bkey;
     botan_pk_op_encrypt_t enc_op = NULL;
 
-    if (!rsa_load_public_key(&rsa_key, key)) {
+    if (!rsa_key && !rsa_load_public_key(&rsa_key, key)) {
         RNP_LOG("failed to load key");
         return RNP_ERROR_OUT_OF_MEMORY;
     }
@@ -218,7 +219,9 @@ rsa_encrypt_pkcs1(rng_t *              rng,
     ret = RNP_SUCCESS;
 done:
     botan_pk_op_encrypt_destroy(enc_op);
-    botan_pubkey_destroy(rsa_key);
+    if (rsa_key != bkey) {
+        botan_pubkey_destroy(rsa_key);
+    }
     return ret;
 }
 
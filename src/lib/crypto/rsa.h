@@ -31,6 +31,7 @@
 #ifndef RNP_RSA_H_
 #define RNP_RSA_H_
 
+#include <botan/ffi.h>
 #include <rnp/rnp_def.h>
 #include <repgp/repgp_def.h>
 #include "crypto/rng.h"
@@ -62,11 +63,15 @@ rnp_result_t rsa_validate_key(rng_t *rng, const pgp_rsa_key_t *key, bool secret)
 
 rnp_result_t rsa_generate(rng_t *rng, pgp_rsa_key_t *key, size_t numbits);
 
+bool rsa_load_public_key(botan_pubkey_t *bkey, const pgp_rsa_key_t *key);
+
+/* bkey, if not NULL, is the preloaded backend key for the key, which is not destroyed */
 rnp_result_t rsa_encrypt_pkcs1(rng_t *              rng,
                                pgp_rsa_encrypted_t *out,
                                const uint8_t *      in,
                                size_t               in_len,
-                               const pgp_rsa_key_t *key);
+                               const pgp_rsa_key_t *key,
+                               botan_pubkey_t       bkey = NULL);
 
 rnp_result_t rsa_decrypt_pkcs1(rng_t *                    rng,
                                uint8_t *                  out,
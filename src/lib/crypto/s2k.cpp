@@ -37,12 +37,20 @@
 #include "uniwin.h"
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 #include "crypto/s2k.h"
+#include "crypto/mem.h"
 #include "defaults.h"
 #include "rnp.h"
 #include "types.h"
 #include "utils.h"
 
+/* size of the block with repeated salt and password, hashed during the iterated S2K */
+#define PGP_S2K_BLOCK_SIZE ((size_t) 16384)
+
 bool
 pgp_s2k_derive_key(pgp_s2k_t *s2k, const char *password, uint8_t *key, int keysize)
 {
@@ -83,19 +91,63 @@ pgp_s2k_iterated(pgp_hash_alg_t alg,
                  const uint8_t *salt,
                  size_t         iterations)
 {
-    char s2k_algo_str[128];
-    snprintf(s2k_algo_str, sizeof(s2k_algo_str), "OpenPGP-S2K(%s)", pgp_hash_name_botan(alg));
-
-    return botan_pwdhash(s2k_algo_str,
-                         iterations,
-                         0,
-                         0,
-                         out,
-                         output_len,
-                         password,
-                         0,
-                         salt,
-                         salt ? PGP_SALT_SIZE : 0);
+    size_t hashlen = pgp_digest_length(alg);
+    if (!hashlen) {
+        RNP_LOG("unknown hash algorithm: %d", (int) alg);
+        return -1;
+    }
+
+    /* salt || password is hashed over and over until iterations bytes are processed, but
+     * at least once. Data is fed to the hash in large blocks of the repeated salt || password,
+     * so block size must be a multiple of its length to keep the sequence. */
+    size_t saltlen = salt ? PGP_SALT_SIZE : 0;
+    size_t passlen = strlen(password);
+    size_t unitlen = saltlen + passlen;
+    size_t total = unitlen ? std::max(iterations, unitlen) : 0;
+    size_t units = unitlen ? std::max(PGP_S2K_BLOCK_SIZE / unitlen, (size_t) 1) : 0;
+    if (units * unitlen > total) {
+        units = (total + unitlen - 1) / unitlen;
+    }
+
+    try {
+        rnp::secure_vector<uint8_t> block(units * unitlen);
+        for (size_t i = 0; i < units; i++) {
+            if (saltlen) {
+                memcpy(&block[i * unitlen], salt, saltlen);
+            }
+            memcpy(&block[i * unitlen + saltlen], password, passlen);
+        }
+
+        rnp::secure_array<uint8_t, PGP_MAX_HASH_SIZE> digest;
+        /* each next part of the output is prefixed with one more zero byte */
+        for (size_t pass = 0, done = 0; done < output_len; pass++) {
+            pgp_hash_t hash = {};
+            if (!pgp_hash_create(&hash, alg)) {
+                return -1;
+            }
+            uint8_t zero = 0;
+            int     res = 0;
+            for (size_t i = 0; (i < pass) && !res; i++) {
+                res = pgp_hash_add(&hash, &zero, 1);
+            }
+            for (size_t left = total; left && !res;) {
+                size_t len = std::min(left, block.size());
+                res = pgp_hash_add(&hash, block.data(), len);
+                left -= len;
+            }
+            pgp_hash_finish(&hash, digest.data());
+            if (res) {
+                return res;
+            }
+            size_t len = std::min(hashlen, output_len - done);
+            memcpy(out + done, digest.data(), len);
+            done += len;
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return -1;
+    }
 }
 
 size_t
@@ -147,20 +199,23 @@ get_timestamp_usec()
 #endif
 }
 
-size_t
-pgp_s2k_compute_iters(pgp_hash_alg_t alg, size_t desired_msec, size_t trial_msec)
-{
-    if (desired_msec == 0) {
-        desired_msec = DEFAULT_S2K_MSEC;
-    }
-    if (trial_msec == 0) {
-        trial_msec = DEFAULT_S2K_TUNE_MSEC;
-    }
+typedef struct pgp_s2k_tuning_t {
+    double   bytes_per_usec; /* measured hashing speed */
+    uint64_t trial_usec;     /* duration of the measurement */
+    uint64_t timestamp;      /* time of the measurement */
+} pgp_s2k_tuning_t;
 
+/* Hashing speed measured for each hash algorithm, shared by the whole process */
+static std::mutex                                s2k_tuning_lock;
+static std::unordered_map<int, pgp_s2k_tuning_t> s2k_tuning;
+
+static bool
+s2k_measure_speed(pgp_hash_alg_t alg, size_t trial_msec, pgp_s2k_tuning_t &tuning)
+{
     pgp_hash_t hash = {};
     if (!pgp_hash_create(&hash, alg)) {
         RNP_LOG("failed to create hash object");
-        return 0;
+        return false;
     }
 
     uint64_t start = get_timestamp_usec();
@@ -175,13 +230,64 @@ pgp_s2k_compute_iters(pgp_hash_alg_t alg, size_t desired_msec, size_t trial_msec
 
     pgp_hash_finish(&hash, buf);
 
-    uint64_t      duration = end - start;
+    tuning.trial_usec = end - start;
+    tuning.timestamp = end;
+    tuning.bytes_per_usec =
+      tuning.trial_usec ? static_cast<double>(bytes) / tuning.trial_usec : 0;
+    return true;
+}
+
+/* Use cached measurement if it is fresh and was not shorter than requested */
+static bool
+s2k_get_speed(pgp_hash_alg_t alg, size_t trial_msec, pgp_s2k_tuning_t &tuning)
+{
+    uint64_t now = get_timestamp_usec();
+    {
+        std::lock_guard<std::mutex> lock(s2k_tuning_lock);
+        auto                        it = s2k_tuning.find(alg);
+        if ((it != s2k_tuning.end()) && (it->second.trial_usec >= trial_msec * 1000ull) &&
+            (now - it->second.timestamp < DEFAULT_S2K_TUNE_TTL * 1000000ull)) {
+            tuning = it->second;
+            return true;
+        }
+    }
+    /* measure without the lock, so other algorithms may be tuned in parallel */
+    if (!s2k_measure_speed(alg, trial_msec, tuning)) {
+        return false;
+    }
+    if (tuning.bytes_per_usec > 0) {
+        std::lock_guard<std::mutex> lock(s2k_tuning_lock);
+        s2k_tuning[alg] = tuning;
+    }
+    return true;
+}
+
+size_t
+pgp_s2k_compute_iters(pgp_hash_alg_t alg, size_t desired_msec, size_t trial_msec)
+{
+    if (desired_msec == 0) {
+        desired_msec = DEFAULT_S2K_MSEC;
+    }
+    if (trial_msec == 0) {
+        trial_msec = DEFAULT_S2K_TUNE_MSEC;
+    }
+
+    pgp_s2k_tuning_t tuning = {};
+    try {
+        if (!s2k_get_speed(alg, trial_msec, tuning)) {
+            return 0;
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return 0;
+    }
+
     const uint8_t MIN_ITERS = 96;
-    if (duration == 0) {
+    if (tuning.bytes_per_usec <= 0) {
         return pgp_s2k_decode_iterations(MIN_ITERS);
     }
 
-    const double  bytes_per_usec = static_cast<double>(bytes) / duration;
+    const double  bytes_per_usec = tuning.bytes_per_usec;
     const double  desired_usec = desired_msec * 1000.0;
     const double  bytes_for_target = bytes_per_usec * desired_usec;
     const uint8_t iters = pgp_s2k_encode_iterations(bytes_for_target);
@@ -30,7 +30,7 @@
 #include "hash.h"
 #include "utils.h"
 
-static bool
+bool
 sm2_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata)
 {
     const ec_curve_desc_t *curve = NULL;
@@ -282,11 +282,12 @@ sm2_encrypt(rng_t *              rng,
             const uint8_t *      in,
             size_t               in_len,
             pgp_hash_alg_t       hash_algo,
-            const pgp_ec_key_t * key)
+            const pgp_ec_key_t * key,
+            botan_pubkey_t       bkey)
 {
     rnp_result_t           ret = RNP_ERROR_GENERIC;
     const ec_curve_desc_t *curve = NULL;
-    botan_pubkey_t         sm2_key = NULL;
+    botan_pubkey_t         sm2_key = bkey;
     botan_pk_op_encrypt_t  enc_op = NULL;
     size_t                 point_len;
     size_t                 hash_alg_len;
@@ -313,7 +314,7 @@ sm2_encrypt(rng_t *              rng,
         goto done;
     }
 
-    if (!sm2_load_public_key(&sm2_key, key)) {
+    if (!sm2_key && !sm2_load_public_key(&sm2_key, key)) {
         RNP_LOG("Failed to load public key");
         goto done;
     }
@@ -335,7 +336,9 @@ sm2_encrypt(rng_t *              rng,
     }
 done:
     botan_pk_op_encrypt_destroy(enc_op);
-    botan_pubkey_destroy(sm2_key);
+    if (sm2_key != bkey) {
+        botan_pubkey_destroy(sm2_key);
+    }
     return ret;
 }
 
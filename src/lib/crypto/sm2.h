@@ -27,6 +27,7 @@
 #ifndef RNP_SM2_H_
 #define RNP_SM2_H_
 
+#include <botan/ffi.h>
 #include "ec.h"
 
 typedef struct pgp_sm2_encrypted_t {
@@ -35,6 +36,8 @@ typedef struct pgp_sm2_encrypted_t {
 
 rnp_result_t sm2_validate_key(rng_t *rng, const pgp_ec_key_t *key, bool secret);
 
+bool sm2_load_public_key(botan_pubkey_t *pubkey, const pgp_ec_key_t *keydata);
+
 /**
  * Compute the SM2 "ZA" field, and add it to the hash object
  *
@@ -57,12 +60,14 @@ rnp_result_t sm2_verify(const pgp_ec_signature_t *sig,
                         size_t                    hash_len,
                         const pgp_ec_key_t *      key);
 
+/* bkey, if not NULL, is the preloaded backend key for the key, which is not destroyed */
 rnp_result_t sm2_encrypt(rng_t *              rng,
                          pgp_sm2_encrypted_t *out,
                          const uint8_t *      in,
                          size_t               in_len,
                          pgp_hash_alg_t       hash_algo,
-                         const pgp_ec_key_t * key);
+                         const pgp_ec_key_t * key,
+                         botan_pubkey_t       bkey = NULL);
 
 rnp_result_t sm2_decrypt(uint8_t *                  out,
                          size_t *                   out_len,
@@ -39,6 +39,9 @@
 /* Default number of msec to run S2K tuning */
 #define DEFAULT_S2K_TUNE_MSEC 10
 
+/* Number of seconds during which S2K tuning result is reused */
+#define DEFAULT_S2K_TUNE_TTL 600
+
 /* Default compression algorithm and level */
 #define DEFAULT_Z_ALG "ZIP"
 #define DEFAULT_Z_LEVEL 6
@@ -29,7 +29,12 @@
 #include <json.h>
 #include "utils.h"
 #include <list>
+#include <vector>
+#include <string>
+#include <unordered_set>
 #include <crypto/mem.h>
+#include "key-cache.h"
+#include "key-pool.h"
 
 struct rnp_key_handle_st {
     rnp_ffi_t        ffi;
@@ -77,6 +82,11 @@ struct rnp_ffi_st {
     rng_t                   rng;
     pgp_key_provider_t      key_provider;
     pgp_password_provider_t pass_provider;
+    pgp_seckey_cache_t *    keycache;
+    pgp_key_pool_t *        keypool;
+    pgp_stream_stats_t      stats;
+    bool                    stats_enabled;
+    size_t                  validation_threads;
 };
 
 struct rnp_input_st {
@@ -126,18 +136,32 @@ struct rnp_op_sign_signature_st {
 
 typedef std::list<rnp_op_sign_signature_st> rnp_op_sign_signatures_t;
 
+struct rnp_signer_st {
+    rnp_ffi_t         ffi{};
+    pgp_fingerprint_t fp{};     /* fingerprint of the signing key or subkey */
+    pgp_key_id_t      keyid{};  /* keyid of the signing key or subkey */
+    pgp_key_pkt_t     seckey{}; /* unlocked copy of the secret key packet */
+};
+
+struct rnp_digest_st {
+    rnp_signer_t signer{};
+    pgp_hash_t   hash{};
+};
+
 struct rnp_op_sign_st {
-    rnp_ffi_t                ffi{};
-    rnp_input_t              input{};
-    rnp_output_t             output{};
-    rnp_ctx_t                rnpctx{};
-    rnp_op_sign_signatures_t signatures{};
+    rnp_ffi_t                  ffi{};
+    rnp_input_t                input{};
+    rnp_output_t               output{};
+    rnp_ctx_t                  rnpctx{};
+    rnp_op_sign_signatures_t   signatures{};
+    struct pgp_write_stream_t *stream{}; /* stack of streams if data is pushed via feed */
 };
 
 struct rnp_op_verify_signature_st {
     rnp_ffi_t       ffi;
     rnp_result_t    verify_status;
     pgp_signature_t sig_pkt;
+    size_t          input_idx{}; /* index of the detached signature input */
 };
 
 struct rnp_op_verify_st {
@@ -146,6 +170,9 @@ struct rnp_op_verify_st {
     rnp_input_t  detached_input{}; /* for detached signature will be source file/data */
     rnp_output_t output{};
     rnp_ctx_t    rnpctx{};
+    /* additional detached signature inputs and number of signatures read from each input */
+    std::vector<rnp_input_t> detached_sigs{};
+    std::vector<size_t>      detached_counts{};
     /* these fields are filled after operation execution */
     rnp_op_verify_signature_t signatures{};
     size_t                    signature_count{};
@@ -169,12 +196,22 @@ struct rnp_op_verify_st {
     ~rnp_op_verify_st();
 };
 
+struct rnp_recipient_set_st {
+    rnp_ffi_t                           ffi{};
+    std::vector<pgp_fingerprint_t>      keys{};    /* resolved encryption keys or subkeys */
+    std::shared_ptr<pgp_pubkey_cache_t> pubkeys{}; /* preloaded backend keys */
+    std::vector<uint8_t>                ciphers{}; /* ciphers, preferred by all recipients */
+    bool                                prefs{};   /* ciphers are limited by preferences */
+};
+
 struct rnp_op_encrypt_st {
-    rnp_ffi_t                ffi{};
-    rnp_input_t              input{};
-    rnp_output_t             output{};
-    rnp_ctx_t                rnpctx{};
-    rnp_op_sign_signatures_t signatures{};
+    rnp_ffi_t                  ffi{};
+    rnp_input_t                input{};
+    rnp_output_t               output{};
+    rnp_ctx_t                  rnpctx{};
+    rnp_op_sign_signatures_t   signatures{};
+    struct pgp_write_stream_t *stream{}; /* stack of streams if data is pushed via feed */
+    bool                       cipher_set{};
 };
 
 struct rnp_identifier_iterator_st {
@@ -183,7 +220,7 @@ struct rnp_identifier_iterator_st {
     rnp_key_store_t *               store;
     std::list<pgp_key_t>::iterator *keyp;
     unsigned                        uididx;
-    json_object *                   tbl;
+    std::unordered_set<std::string> tbl;
     char
       buf[1 + MAX(MAX(MAX(PGP_KEY_ID_SIZE * 2, PGP_KEY_GRIP_SIZE), PGP_FINGERPRINT_SIZE * 2),
                   MAX_ID_LENGTH)];
@@ -0,0 +1,190 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <botan/ffi.h>
+#include "key-cache.h"
+#include "pgp-key.h"
+#include "logging.h"
+#include "crypto/rsa.h"
+#include "crypto/elgamal.h"
+#include "crypto/sm2.h"
+
+void
+pgp_seckey_cache_t::purge(time_t now)
+{
+    for (auto it = items_.begin(); it != items_.end();) {
+        if (it->second.expires <= now) {
+            it = items_.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void
+pgp_seckey_cache_t::configure(uint32_t ttl, uint32_t max_uses)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    items_.clear();
+    ttl_ = ttl;
+    max_uses_ = max_uses;
+}
+
+bool
+pgp_seckey_cache_t::enabled()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    return ttl_;
+}
+
+pgp_key_pkt_t *
+pgp_seckey_cache_t::get(const pgp_key_t &key)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    purge(time(NULL));
+    auto it = items_.find(key.fp());
+    if (it == items_.end()) {
+        return NULL;
+    }
+    pgp_key_pkt_t *res = new pgp_key_pkt_t(it->second.seckey);
+    if (it->second.uses && !--it->second.uses) {
+        items_.erase(it);
+    }
+    return res;
+}
+
+void
+pgp_seckey_cache_t::add(const pgp_key_t &key, const pgp_key_pkt_t &seckey)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!ttl_ || (max_uses_ == 1)) {
+        return;
+    }
+    time_t now = time(NULL);
+    purge(now);
+    pgp_seckey_cache_item_t &item = items_[key.fp()];
+    item.seckey = seckey;
+    item.expires = now + ttl_;
+    /* the first use is the one which decrypted the key */
+    item.uses = max_uses_ ? max_uses_ - 1 : 0;
+}
+
+void
+pgp_seckey_cache_t::remove(const pgp_fingerprint_t &fp)
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    items_.erase(fp);
+}
+
+void
+pgp_seckey_cache_t::clear()
+{
+    std::lock_guard<std::mutex> lock(lock_);
+    items_.clear();
+}
+
+pgp_key_pkt_t *
+pgp_decrypt_seckey_cached(pgp_seckey_cache_t *           cache,
+                          const pgp_key_t *              key,
+                          const pgp_password_provider_t *provider,
+                          const pgp_password_ctx_t *     ctx)
+{
+    if (!cache || !key || !cache->enabled()) {
+        return pgp_decrypt_seckey(key, provider, ctx);
+    }
+    try {
+        pgp_key_pkt_t *seckey = cache->get(*key);
+        if (seckey) {
+            return seckey;
+        }
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return NULL;
+    }
+
+    pgp_key_pkt_t *seckey = pgp_decrypt_seckey(key, provider, ctx);
+    if (!seckey) {
+        return NULL;
+    }
+    try {
+        cache->add(*key, *seckey);
+    } catch (const std::exception &e) {
+        /* not critical, key just will not be cached */
+        RNP_LOG("%s", e.what());
+    }
+    return seckey;
+}
+
+pgp_pubkey_cache_t::~pgp_pubkey_cache_t()
+{
+    for (auto &item : keys_) {
+        botan_pubkey_destroy(item.second);
+    }
+}
+
+bool
+pgp_pubkey_cache_t::add(const pgp_key_t &key)
+{
+    if (keys_.count(key.fp())) {
+        return true;
+    }
+
+    botan_pubkey_t bkey = NULL;
+    bool           res = false;
+    switch (key.alg()) {
+    case PGP_PKA_RSA:
+    case PGP_PKA_RSA_ENCRYPT_ONLY:
+        res = rsa_load_public_key(&bkey, &key.material().rsa);
+        break;
+    case PGP_PKA_ELGAMAL:
+        res = elgamal_load_public_key(&bkey, &key.material().eg);
+        break;
+    case PGP_PKA_SM2:
+        res = sm2_load_public_key(&bkey, &key.material().ec);
+        break;
+    default:
+        return true;
+    }
+    if (!res) {
+        RNP_LOG("failed to load public key");
+        return false;
+    }
+    try {
+        keys_[key.fp()] = bkey;
+        return true;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        botan_pubkey_destroy(bkey);
+        return false;
+    }
+}
+
+botan_pubkey_t
+pgp_pubkey_cache_t::get(const pgp_fingerprint_t &fp) const
+{
+    auto it = keys_.find(fp);
+    return it == keys_.end() ? NULL : it->second;
+}
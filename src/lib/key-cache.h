@@ -0,0 +1,116 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_KEY_CACHE_H
+#define RNP_KEY_CACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "types.h"
+#include "pass-provider.h"
+#include "librepgp/stream-key.h"
+
+typedef struct pgp_key_t pgp_key_t;
+
+typedef struct pgp_seckey_cache_item_t {
+    pgp_key_pkt_t seckey{};  /* decrypted secret key packet */
+    time_t        expires{}; /* time when item must be dropped */
+    uint32_t      uses{};    /* number of uses left, 0 for unlimited */
+} pgp_seckey_cache_item_t;
+
+/** Cache of decrypted secret keys, so protected keys used over and over for signing or
+ *  decryption do not need the password request and S2K derivation each time.
+ *  Items are wiped once they expire, run out of uses or are flushed. Expiration is lazy:
+ *  there is no timer, expired items are dropped on the next cache access.
+ */
+typedef struct pgp_seckey_cache_t {
+  private:
+    std::unordered_map<pgp_fingerprint_t, pgp_seckey_cache_item_t> items_;
+    std::mutex                                                     lock_;
+    uint32_t                                                       ttl_{};
+    uint32_t                                                       max_uses_{};
+
+    void purge(time_t now);
+
+  public:
+    /** @brief setup cache parameters. Already cached items are flushed.
+     *  @param ttl number of seconds the decrypted key is kept, 0 disables the cache.
+     *  @param max_uses number of times cached key may be used, 0 for no limit.
+     */
+    void configure(uint32_t ttl, uint32_t max_uses);
+    bool enabled();
+
+    /** @brief get copy of the cached decrypted key, counting this as a single use.
+     *  @return key packet which must be deleted by the caller, or NULL if there is no
+     *          cached key.
+     */
+    pgp_key_pkt_t *get(const pgp_key_t &key);
+    void           add(const pgp_key_t &key, const pgp_key_pkt_t &seckey);
+    void           remove(const pgp_fingerprint_t &fp);
+    void           clear();
+} pgp_seckey_cache_t;
+
+/** @brief decrypt secret key, using the cache if it is available and enabled. Decrypted key
+ *         is added to the cache, so subsequent calls do not need to ask for the password.
+ *  @param cache cache object, may be NULL.
+ *  @return decrypted key packet which must be deleted by the caller, or NULL on failure.
+ */
+pgp_key_pkt_t *pgp_decrypt_seckey_cached(pgp_seckey_cache_t *           cache,
+                                         const pgp_key_t *              key,
+                                         const pgp_password_provider_t *provider,
+                                         const pgp_password_ctx_t *     ctx);
+
+/** Backend public keys of the encryption recipients, loaded once and then reused by every
+ *  message encrypted to the same recipients. It is not changed after it is filled, so may be
+ *  shared between the encryption operations and worker threads.
+ *  ECDH keys are not cached since the recipient's point is used as it is.
+ */
+typedef struct pgp_pubkey_cache_t {
+  private:
+    std::unordered_map<pgp_fingerprint_t, botan_pubkey_t> keys_;
+
+  public:
+    pgp_pubkey_cache_t() = default;
+    pgp_pubkey_cache_t(const pgp_pubkey_cache_t &) = delete;
+    pgp_pubkey_cache_t &operator=(const pgp_pubkey_cache_t &) = delete;
+    ~pgp_pubkey_cache_t();
+
+    /** @brief load backend key for the encryption key or subkey.
+     *  @return true if key was loaded or its algorithm doesn't need it, false otherwise.
+     */
+    bool add(const pgp_key_t &key);
+    /** @brief get the preloaded backend key, which is owned by the cache.
+     *  @return backend key or NULL if there is no one for the fingerprint.
+     */
+    botan_pubkey_t get(const pgp_fingerprint_t &fp) const;
+} pgp_pubkey_cache_t;
+
+typedef std::shared_ptr<const pgp_pubkey_cache_t> pgp_pubkey_cache_ptr;
+
+#endif
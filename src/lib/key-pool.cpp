@@ -0,0 +1,264 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "key-pool.h"
+#include "crypto/common.h"
+#include "defaults.h"
+#include "logging.h"
+#include "librepgp/stream-key.h"
+
+/* maximum delay in seconds before the next attempt after the failed key generation */
+#define PGP_KEY_POOL_MAX_RETRY_DELAY 64
+
+pgp_key_pool_t::~pgp_key_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto &slot : slots_) {
+            slot.stop = true;
+        }
+    }
+    cond_.notify_all();
+    for (auto &slot : slots_) {
+        if (slot.thread.joinable()) {
+            slot.thread.join();
+        }
+        wipe(slot, 0);
+    }
+}
+
+pgp_key_pool_t::pgp_key_pool_slot_t *
+pgp_key_pool_t::find(pgp_pubkey_alg_t alg, size_t bits, size_t qbits)
+{
+    for (auto &slot : slots_) {
+        if ((slot.alg == alg) && (slot.bits == bits) && (slot.qbits == qbits) && !slot.stop) {
+            return &slot;
+        }
+    }
+    return NULL;
+}
+
+bool
+pgp_key_pool_t::generate(rng_t *rng, const pgp_key_pool_slot_t &slot, pgp_key_material_t &key)
+{
+    key = {};
+    key.alg = slot.alg;
+    rnp_result_t ret = RNP_ERROR_BAD_PARAMETERS;
+    switch (slot.alg) {
+    case PGP_PKA_RSA:
+        ret = rsa_generate(rng, &key.rsa, slot.bits);
+        break;
+    case PGP_PKA_DSA:
+        ret = dsa_generate(rng, &key.dsa, slot.bits, slot.qbits);
+        break;
+    case PGP_PKA_ELGAMAL:
+        ret = elgamal_generate(rng, &key.eg, slot.bits);
+        break;
+    default:
+        break;
+    }
+    key.secret = !ret;
+    return !ret;
+}
+
+void
+pgp_key_pool_t::wipe(pgp_key_pool_slot_t &slot, size_t size)
+{
+    while (slot.items.size() > size) {
+        forget_secret_key_fields(&slot.items.back());
+        slot.items.pop_back();
+    }
+}
+
+void
+pgp_key_pool_t::worker(pgp_key_pool_slot_t *slot)
+{
+    /* each slot uses own random generator since generation is done without the lock */
+    rng_t    rng = {};
+    bool     rnginit = false;
+    unsigned delay = 0;
+
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!slot->stop) {
+        if (slot->items.size() >= slot->size) {
+            cond_.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        if (!rnginit) {
+            rng = {};
+            rnginit = rng_init(&rng, RNG_DRBG);
+        }
+        pgp_key_material_t key = {};
+        bool               res = false;
+        try {
+            res = rnginit && generate(&rng, *slot, key);
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+        }
+        lock.lock();
+        /* slot could be shrunk or removed meanwhile */
+        try {
+            if (res && !slot->stop && (slot->items.size() < slot->size)) {
+                slot->items.push_back(key);
+            }
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+            res = false;
+        }
+        forget_secret_key_fields(&key);
+        if (res) {
+            delay = 0;
+            continue;
+        }
+        /* failure may be temporary, so retry with growing delay instead of giving up */
+        delay = delay ? std::min(delay * 2, (unsigned) PGP_KEY_POOL_MAX_RETRY_DELAY) : 1;
+        RNP_LOG("Failed to %s pool key, alg %d, bits %zu. Retrying in %u s.",
+                rnginit ? "generate" : "initialize RNG for",
+                (int) slot->alg,
+                slot->bits,
+                delay);
+        cond_.wait_for(lock, std::chrono::seconds(delay), [slot] { return slot->stop; });
+    }
+    lock.unlock();
+    if (rnginit) {
+        rng_destroy(&rng);
+    }
+}
+
+bool
+pgp_key_pool_t::configure(pgp_pubkey_alg_t alg, size_t bits, size_t size)
+{
+    size_t qbits = 0;
+    switch (alg) {
+    case PGP_PKA_RSA:
+    case PGP_PKA_ELGAMAL:
+        if ((bits < 1024) || (bits > PGP_MPINT_BITS)) {
+            RNP_LOG("Unsupported key size: %zu", bits);
+            return false;
+        }
+        break;
+    case PGP_PKA_DSA:
+        if ((bits < DSA_MIN_P_BITLEN) || (bits > DSA_MAX_P_BITLEN)) {
+            RNP_LOG("Unsupported key size: %zu", bits);
+            return false;
+        }
+        qbits = dsa_choose_qsize_by_psize(bits);
+        break;
+    default:
+        RNP_LOG("Key pool is not supported for algorithm %d", (int) alg);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(lock_);
+    pgp_key_pool_slot_t *        slot = find(alg, bits, qbits);
+    if (slot && size) {
+        slot->size = size;
+        wipe(*slot, size);
+        lock.unlock();
+        cond_.notify_all();
+        return true;
+    }
+    if (!slot && !size) {
+        return true;
+    }
+    if (slot) {
+        /* stop the filling thread and remove the slot */
+        slot->stop = true;
+        wipe(*slot, 0);
+        lock.unlock();
+        cond_.notify_all();
+        slot->thread.join();
+        lock.lock();
+        for (auto it = slots_.begin(); it != slots_.end(); it++) {
+            if (&*it == slot) {
+                slots_.erase(it);
+                break;
+            }
+        }
+        return true;
+    }
+
+    slots_.emplace_back();
+    slot = &slots_.back();
+    slot->alg = alg;
+    slot->bits = bits;
+    slot->qbits = qbits;
+    slot->size = size;
+    try {
+        slot->thread = std::thread(&pgp_key_pool_t::worker, this, slot);
+    } catch (const std::system_error &e) {
+        RNP_LOG("Failed to start key pool thread: %s", e.what());
+        slots_.pop_back();
+        return false;
+    }
+    return true;
+}
+
+size_t
+pgp_key_pool_t::available(pgp_pubkey_alg_t alg, size_t bits)
+{
+    size_t qbits = alg == PGP_PKA_DSA ? dsa_choose_qsize_by_psize(bits) : 0;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    pgp_key_pool_slot_t *       slot = find(alg, bits, qbits);
+    return slot ? slot->items.size() : 0;
+}
+
+bool
+pgp_key_pool_t::take(const rnp_keygen_crypto_params_t &crypto, pgp_key_material_t &material)
+{
+    size_t bits = 0;
+    size_t qbits = 0;
+    switch (crypto.key_alg) {
+    case PGP_PKA_RSA:
+        bits = crypto.rsa.modulus_bit_len;
+        break;
+    case PGP_PKA_DSA:
+        bits = crypto.dsa.p_bitlen;
+        qbits = crypto.dsa.q_bitlen;
+        break;
+    case PGP_PKA_ELGAMAL:
+        bits = crypto.elgamal.key_bitlen;
+        break;
+    default:
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(lock_);
+    pgp_key_pool_slot_t *        slot = find(crypto.key_alg, bits, qbits);
+    if (!slot || slot->items.empty()) {
+        return false;
+    }
+    material = slot->items.front();
+    forget_secret_key_fields(&slot->items.front());
+    slot->items.pop_front();
+    lock.unlock();
+    cond_.notify_all();
+    return true;
+}
@@ -0,0 +1,84 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_KEY_POOL_H
+#define RNP_KEY_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include "types.h"
+
+/** Pool of pre-generated key material for the algorithms with slow key generation (RSA, DSA
+ *  and ElGamal). Each configured slot has background thread which keeps it filled, so key
+ *  generation on the request path only needs to bind the userid and create self-signatures.
+ *  Failed background generation is logged and retried after a growing delay.
+ *  Each key material is given out only once, and is wiped once slot is shrunk or removed,
+ *  or pool is destroyed.
+ */
+typedef struct pgp_key_pool_t {
+  private:
+    typedef struct pgp_key_pool_slot_t {
+        pgp_pubkey_alg_t               alg{};
+        size_t                         bits{};
+        size_t                         qbits{};
+        size_t                         size{};
+        bool                           stop{};
+        std::deque<pgp_key_material_t> items;
+        std::thread                    thread;
+    } pgp_key_pool_slot_t;
+
+    std::list<pgp_key_pool_slot_t> slots_;
+    std::mutex                     lock_;
+    std::condition_variable        cond_;
+
+    pgp_key_pool_slot_t *find(pgp_pubkey_alg_t alg, size_t bits, size_t qbits);
+    void                 worker(pgp_key_pool_slot_t *slot);
+    static bool generate(rng_t *rng, const pgp_key_pool_slot_t &slot, pgp_key_material_t &key);
+    static void wipe(pgp_key_pool_slot_t &slot, size_t size);
+
+  public:
+    ~pgp_key_pool_t();
+
+    /** @brief add, resize or remove the pool slot for the algorithm and key size.
+     *  @param alg public key algorithm, must be RSA, DSA or ElGamal.
+     *  @param bits key size in bits. For DSA q size is chosen as for the key generation.
+     *  @param size number of pre-generated keys kept ready, 0 removes the slot.
+     *  @return true on success or false if parameters are not supported.
+     */
+    bool configure(pgp_pubkey_alg_t alg, size_t bits, size_t size);
+    /** @brief number of keys, ready to be taken from the slot. */
+    size_t available(pgp_pubkey_alg_t alg, size_t bits);
+    /** @brief take pre-generated key material, matching key generation parameters.
+     *  @return true if material was taken, or false if there is no one available.
+     */
+    bool take(const rnp_keygen_crypto_params_t &crypto, pgp_key_material_t &material);
+} pgp_key_pool_t;
+
+#endif
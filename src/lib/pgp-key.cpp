@@ -71,6 +71,10 @@
 #include <algorithm>
 #include <stdexcept>
 #include "defaults.h"
+#include "workers.h"
+
+/* minimum number of signatures per thread for the batch validation */
+#define PGP_SIG_BATCH_THREAD_MIN 8
 
 pgp_key_pkt_t *
 pgp_decrypt_seckey_pgp(const uint8_t *      data,
@@ -1820,11 +1824,6 @@ pgp_key_t::write_autocrypt(pgp_dest_t &dst, pgp_key_t &sub, uint32_t uid)
     return res;
 }
 
-/* look only for primary userids */
-#define PGP_UID_PRIMARY ((uint32_t) -2)
-/* look for any uid, except PGP_UID_NONE) */
-#define PGP_UID_ANY ((uint32_t) -3)
-
 pgp_subsig_t *
 pgp_key_t::latest_selfsig(uint32_t uid)
 {
@@ -2040,7 +2039,7 @@ pgp_key_t::validate_sig(const pgp_key_t &key, pgp_subsig_t &sig) const
 }
 
 void
-pgp_key_t::validate_self_signatures()
+pgp_key_t::add_self_signatures(pgp_sig_batch_t &batch)
 {
     for (auto &sigid : sigs_) {
         pgp_subsig_t &sig = get_sig(sigid);
@@ -2050,13 +2049,13 @@ pgp_key_t::validate_self_signatures()
 
         if (is_direct_self(sig) || is_self_cert(sig) || is_uid_revocation(sig) ||
             is_revocation(sig)) {
-            validate_sig(*this, sig);
+            batch.add(*this, *this, sig);
         }
     }
 }
 
 void
-pgp_key_t::validate_self_signatures(pgp_key_t &primary)
+pgp_key_t::add_self_signatures(pgp_sig_batch_t &batch, pgp_key_t &primary)
 {
     for (auto &sigid : sigs_) {
         pgp_subsig_t &sig = get_sig(sigid);
@@ -2065,11 +2064,53 @@ pgp_key_t::validate_self_signatures(pgp_key_t &primary)
         }
 
         if (is_binding(sig) || is_revocation(sig)) {
-            primary.validate_sig(*this, sig);
+            batch.add(primary, *this, sig);
         }
     }
 }
 
+void
+pgp_key_t::validate_self_signatures()
+{
+    pgp_sig_batch_t batch;
+    add_self_signatures(batch);
+    batch.validate();
+}
+
+void
+pgp_key_t::validate_self_signatures(pgp_key_t &primary)
+{
+    pgp_sig_batch_t batch;
+    add_self_signatures(batch, primary);
+    batch.validate();
+}
+
+void
+pgp_sig_batch_t::add(const pgp_key_t &signer, const pgp_key_t &key, pgp_subsig_t &sig)
+{
+    items_.push_back({&signer, &key, &sig});
+}
+
+size_t
+pgp_sig_batch_t::size() const
+{
+    return items_.size();
+}
+
+void
+pgp_sig_batch_t::validate(size_t threads)
+{
+    /* do not start a thread for just a few signatures */
+    size_t maxthreads = std::max(items_.size() / PGP_SIG_BATCH_THREAD_MIN, (size_t) 1);
+    threads = std::min(rnp_worker_count(threads, items_.size()), maxthreads);
+    /* if validation throws, signature is left not validated and error is logged */
+    rnp_run_workers(threads, items_.size(), [this](size_t idx, size_t) {
+        pgp_sig_batch_item_t &item = items_[idx];
+        item.signer->validate_sig(*item.key, *item.sig);
+    });
+    items_.clear();
+}
+
 void
 pgp_key_t::validate_primary(rnp_key_store_t &keyring)
 {
@@ -139,8 +139,13 @@ typedef struct pgp_userid_t {
 } pgp_userid_t;
 
 #define PGP_UID_NONE ((uint32_t) -1)
+/* look only for primary userids */
+#define PGP_UID_PRIMARY ((uint32_t) -2)
+/* look for any uid, except PGP_UID_NONE) */
+#define PGP_UID_ANY ((uint32_t) -3)
 
 typedef struct rnp_key_store_t rnp_key_store_t;
+typedef struct pgp_sig_batch_t pgp_sig_batch_t;
 
 /* describes a user's key */
 struct pgp_key_t {
@@ -385,6 +390,11 @@ struct pgp_key_t {
     void validate_sig(const pgp_key_t &key, pgp_subsig_t &sig) const;
     void validate_self_signatures();
     void validate_self_signatures(pgp_key_t &primary);
+    /** @brief Add not yet validated self-signatures of the primary key to the batch */
+    void add_self_signatures(pgp_sig_batch_t &batch);
+    /** @brief Add not yet validated binding/revocation signatures of the subkey to the
+     *         batch */
+    void add_self_signatures(pgp_sig_batch_t &batch, pgp_key_t &primary);
     void validate(rnp_key_store_t &keyring);
     void validate_subkey(pgp_key_t *primary = NULL);
     void revalidate(rnp_key_store_t &keyring);
@@ -400,6 +410,31 @@ struct pgp_key_t {
     bool merge(const pgp_key_t &src, pgp_key_t *primary);
 };
 
+/** Signatures collected for the validation. Each signature is validated separately, so
+ *  invalid ones are marked individually, while the whole batch may be processed on the several
+ *  threads.
+ *  Keys and signatures must not be modified or destroyed until validate() returns.
+ */
+typedef struct pgp_sig_batch_t {
+  private:
+    typedef struct pgp_sig_batch_item_t {
+        const pgp_key_t *signer; /* signing key */
+        const pgp_key_t *key;    /* key to which signature belongs */
+        pgp_subsig_t *   sig;    /* signature to validate */
+    } pgp_sig_batch_item_t;
+
+    std::vector<pgp_sig_batch_item_t> items_;
+
+  public:
+    void   add(const pgp_key_t &signer, const pgp_key_t &key, pgp_subsig_t &sig);
+    size_t size() const;
+    /** @brief validate all added signatures and clear the batch.
+     *  @param threads maximum number of threads, including the calling one, 0 means number of
+     *         the hardware threads. Less threads are used if there are not enough signatures.
+     */
+    void validate(size_t threads = 1);
+} pgp_sig_batch_t;
+
 pgp_key_pkt_t *pgp_decrypt_seckey_pgp(const uint8_t *,
                                       size_t,
                                       const pgp_key_pkt_t *,
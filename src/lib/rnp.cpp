@@ -27,6 +27,7 @@
 
 #include "crypto.h"
 #include "crypto/common.h"
+#include "crypto/signatures.h"
 #include "pgp-key.h"
 #include "defaults.h"
 #include <assert.h>
@@ -54,11 +55,17 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <sstream>
 #include "utils.h"
 #include "json_utils.h"
 #include "version.h"
 #include "ffi-priv-types.h"
 #include "file-utils.h"
+#include "workers.h"
 
 #define FFI_LOG(ffi, ...)            \
     do {                             \
@@ -135,6 +142,8 @@ rnp_ctx_init_ffi(rnp_ctx_t &ctx, rnp_ffi_t ffi)
 {
     ctx.rng = &ffi->rng;
     ctx.ealg = DEFAULT_PGP_SYMM_ALG;
+    ctx.keycache = ffi->keycache;
+    ctx.stats = ffi->stats_enabled ? &ffi->stats : NULL;
 }
 
 static const pgp_map_t sig_type_map[] = {{PGP_SIG_BINARY, "binary"},
@@ -487,9 +496,13 @@ try {
     }
     // default to all stderr
     ob->errs = stderr;
+    // validate keys on the calling thread
+    ob->validation_threads = 1;
     try {
         ob->pubring = new rnp_key_store_t(pub_ks_format, "");
         ob->secring = new rnp_key_store_t(sec_ks_format, "");
+        ob->keycache = new pgp_seckey_cache_t();
+        ob->keypool = new pgp_key_pool_t();
     } catch (const std::exception &e) {
         FFI_LOG(ob, "%s", e.what());
         ret = RNP_ERROR_OUT_OF_MEMORY;
@@ -536,8 +549,12 @@ rnp_ffi_destroy(rnp_ffi_t ffi)
 try {
     if (ffi) {
         close_io_file(&ffi->errs);
+        /* wipe decrypted keys before waiting for the background key generation */
+        ffi->keycache->clear();
+        delete ffi->keypool;
         delete ffi->pubring;
         delete ffi->secring;
+        delete ffi->keycache;
         rng_destroy(&ffi->rng);
         free(ffi);
     }
@@ -592,6 +609,215 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_ffi_set_rng_buffered(rnp_ffi_t ffi, bool buffered)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    rng_type_t type = buffered ? RNG_BUFFERED : RNG_DRBG;
+    if (ffi->rng.rng_type == type) {
+        return RNP_SUCCESS;
+    }
+    /* new generator will be initialized and seeded on the first use */
+    rng_destroy(&ffi->rng);
+    if (!rng_init(&ffi->rng, type)) {
+        return RNP_ERROR_RNG;
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_validation_threads(rnp_ffi_t ffi, size_t threads)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->validation_threads = threads;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_stream_stats(rnp_ffi_t ffi, bool enabled)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->stats_enabled = enabled;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+static void
+stream_stats_merge(pgp_stream_stats_t &to, const pgp_stream_stats_t &from)
+{
+    for (int type = 0; type < PGP_STREAM_TYPE_COUNT; type++) {
+        to.src[type].calls += from.src[type].calls;
+        to.src[type].bytes += from.src[type].bytes;
+        to.src[type].copied += from.src[type].copied;
+        to.src[type].ns += from.src[type].ns;
+        to.dst[type].calls += from.dst[type].calls;
+        to.dst[type].bytes += from.dst[type].bytes;
+        to.dst[type].copied += from.dst[type].copied;
+        to.dst[type].ns += from.dst[type].ns;
+    }
+}
+
+static const pgp_map_t stream_type_map[] = {{PGP_STREAM_NULL, "null"},
+                                            {PGP_STREAM_FILE, "file"},
+                                            {PGP_STREAM_MEMORY, "memory"},
+                                            {PGP_STREAM_STDIN, "stdin"},
+                                            {PGP_STREAM_STDOUT, "stdout"},
+                                            {PGP_STREAM_PACKET, "packet"},
+                                            {PGP_STREAM_PARLEN_PACKET, "partial"},
+                                            {PGP_STREAM_LITERAL, "literal"},
+                                            {PGP_STREAM_COMPRESSED, "compressed"},
+                                            {PGP_STREAM_ENCRYPTED, "encrypted"},
+                                            {PGP_STREAM_SIGNED, "signed"},
+                                            {PGP_STREAM_ARMORED, "armored"},
+                                            {PGP_STREAM_CLEARTEXT, "cleartext"}};
+
+static bool
+stream_counters_to_json(json_object *jso, const pgp_stream_counter_t *counters)
+{
+    for (int type = 0; type < PGP_STREAM_TYPE_COUNT; type++) {
+        const pgp_stream_counter_t &cnt = counters[type];
+        if (!cnt.calls && !cnt.copied) {
+            continue;
+        }
+        const char *name = "unknown";
+        ARRAY_LOOKUP_BY_ID(stream_type_map, type, string, type, name);
+        json_object *jsocnt = json_object_new_object();
+        if (!obj_add_field_json(jso, name, jsocnt) ||
+            !obj_add_field_json(jsocnt, "calls", json_object_new_int64(cnt.calls)) ||
+            !obj_add_field_json(jsocnt, "bytes", json_object_new_int64(cnt.bytes)) ||
+            !obj_add_field_json(jsocnt, "copied", json_object_new_int64(cnt.copied)) ||
+            !obj_add_field_json(jsocnt, "ns", json_object_new_int64(cnt.ns))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+rnp_result_t
+rnp_ffi_get_stream_stats(rnp_ffi_t ffi, bool reset, char **json)
+try {
+    if (!ffi || !json) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    json_object *jso = json_object_new_object();
+    if (!jso) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = RNP_ERROR_OUT_OF_MEMORY;
+    json_object *jsoread = json_object_new_object();
+    if (!obj_add_field_json(jso, "read", jsoread) ||
+        !stream_counters_to_json(jsoread, ffi->stats.src)) {
+        goto done;
+    }
+    json_object *jsowrite;
+    jsowrite = json_object_new_object();
+    if (!obj_add_field_json(jso, "write", jsowrite) ||
+        !stream_counters_to_json(jsowrite, ffi->stats.dst)) {
+        goto done;
+    }
+    *json = (char *) json_object_to_json_string_ext(jso, JSON_C_TO_STRING_PRETTY);
+    if (!*json) {
+        ret = RNP_ERROR_BAD_STATE;
+        goto done;
+    }
+    *json = strdup(*json);
+    if (!*json) {
+        goto done;
+    }
+    if (reset) {
+        ffi->stats = {};
+    }
+    ret = RNP_SUCCESS;
+done:
+    json_object_put(jso);
+    return ret;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_key_cache(rnp_ffi_t ffi, uint32_t ttl, uint32_t max_uses)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    ffi->keycache->configure(ttl, max_uses);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_set_key_pool(rnp_ffi_t ffi, const char *alg, uint32_t bits, size_t size)
+try {
+    if (!ffi || !alg) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    pgp_pubkey_alg_t key_alg = PGP_PKA_NOTHING;
+    if (!str_to_pubkey_alg(alg, &key_alg)) {
+        FFI_LOG(ffi, "Unknown key algorithm: %s", alg);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    if (!ffi->keypool->configure(key_alg, bits, size)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_ffi_get_key_pool_size(rnp_ffi_t ffi, const char *alg, uint32_t bits, size_t *count)
+try {
+    if (!ffi || !alg || !count) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    pgp_pubkey_alg_t key_alg = PGP_PKA_NOTHING;
+    if (!str_to_pubkey_alg(alg, &key_alg)) {
+        FFI_LOG(ffi, "Unknown key algorithm: %s", alg);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    *count = ffi->keypool->available(key_alg, bits);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+static void
+rnp_key_cache_flush(rnp_ffi_t ffi, const pgp_key_t *key, bool subkeys)
+{
+    ffi->keycache->remove(key->fp());
+    if (!subkeys || !key->is_primary()) {
+        return;
+    }
+    for (auto &fp : key->subkey_fps()) {
+        ffi->keycache->remove(fp);
+    }
+}
+
+rnp_result_t
+rnp_ffi_flush_key_cache(rnp_ffi_t ffi, rnp_key_handle_t key)
+try {
+    if (!ffi) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!key) {
+        ffi->keycache->clear();
+        return RNP_SUCCESS;
+    }
+    pgp_key_t *pkey = get_key_prefer_public(key);
+    if (!pkey) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp_key_cache_flush(ffi, pkey, true);
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 static const char *
 operation_description(uint8_t op)
 {
@@ -1173,6 +1399,7 @@ do_load_keys(rnp_ffi_t              ffi,
         FFI_LOG(ffi, "%s", e.what());
         return RNP_ERROR_OUT_OF_MEMORY;
     }
+    tmp_store->validation_threads = ffi->validation_threads;
 
     // load keys into our temporary store
     tmpret = load_keys_from_input(ffi, input, tmp_store);
@@ -1299,6 +1526,7 @@ try {
     }
     if (flags & RNP_KEY_UNLOAD_SECRET) {
         rnp_key_store_clear(ffi->secring);
+        ffi->keycache->clear();
     }
 
     return RNP_SUCCESS;
@@ -1438,6 +1666,7 @@ try {
         FFI_LOG(ffi, "Failed to create key store: %s.", e.what());
         return RNP_ERROR_OUT_OF_MEMORY;
     }
+    tmp_store->validation_threads = ffi->validation_threads;
 
     if (single) {
         /* we need to init and handle dearmor on this layer since it may be used for the next
@@ -1805,6 +2034,34 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_input_from_file(rnp_input_t *input, const char *path, uint32_t flags)
+try {
+    if (!input || !path) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    bool readahead = false;
+    if (flags & RNP_INPUT_FILE_READ_AHEAD) {
+        readahead = true;
+        flags &= ~RNP_INPUT_FILE_READ_AHEAD;
+    }
+    if (flags) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp_input_t ob = (rnp_input_t) calloc(1, sizeof(*ob));
+    if (!ob) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = init_file_src(&ob->src, path, readahead);
+    if (ret) {
+        free(ob);
+        return ret;
+    }
+    *input = ob;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_input_from_memory(rnp_input_t *input, const uint8_t buf[], size_t buf_len, bool do_copy)
 try {
@@ -1950,6 +2207,7 @@ try {
     }
     bool overwrite = false;
     bool random = false;
+    bool writebehind = false;
     if (flags & RNP_OUTPUT_FILE_OVERWRITE) {
         overwrite = true;
         flags &= ~RNP_OUTPUT_FILE_OVERWRITE;
@@ -1958,6 +2216,10 @@ try {
         random = true;
         flags &= ~RNP_OUTPUT_FILE_RANDOM;
     }
+    if (flags & RNP_OUTPUT_FILE_WRITE_BEHIND) {
+        writebehind = true;
+        flags &= ~RNP_OUTPUT_FILE_WRITE_BEHIND;
+    }
     if (flags) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -1967,9 +2229,9 @@ try {
     }
     rnp_result_t ret = RNP_ERROR_GENERIC;
     if (random) {
-        ret = init_tmpfile_dest(&res->dst, path, overwrite);
+        ret = init_tmpfile_dest(&res->dst, path, overwrite, writebehind);
     } else {
-        ret = init_file_dest(&res->dst, path, overwrite);
+        ret = init_file_dest(&res->dst, path, overwrite, writebehind);
     }
     if (ret) {
         free(res);
@@ -2056,6 +2318,32 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_output_memory_drain(rnp_output_t output, uint8_t **buf, size_t *len)
+try {
+    if (!output || !buf || !len) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (output->dst.type != PGP_STREAM_MEMORY) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    *buf = NULL;
+    *len = output->dst.writeb;
+    if (!*len) {
+        return RNP_SUCCESS;
+    }
+    *buf = (uint8_t *) malloc(*len);
+    if (!*buf) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(*buf, mem_dest_get_memory(&output->dst), *len);
+    /* memory destination writes at the writeb offset, so buffer will be reused */
+    output->dst.writeb = 0;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 static rnp_result_t
 output_writer_bounce(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -2177,6 +2465,20 @@ try {
 }
 FFI_GUARD
 
+static pgp_key_t *
+rnp_find_signing_key(rnp_key_handle_t key)
+{
+    pgp_key_t *signkey = find_suitable_key(
+      PGP_OP_SIGN, get_key_prefer_public(key), &key->ffi->key_provider, PGP_KF_SIGN);
+    if (signkey && !signkey->is_secret()) {
+        pgp_key_request_ctx_t ctx = {.op = PGP_OP_SIGN, .secret = true};
+        ctx.search.type = PGP_KEY_SEARCH_GRIP;
+        ctx.search.by.grip = signkey->grip();
+        signkey = pgp_request_key(&key->ffi->key_provider, &ctx);
+    }
+    return signkey;
+}
+
 static rnp_result_t
 rnp_op_add_signature(rnp_ffi_t                 ffi,
                      rnp_op_sign_signatures_t &signatures,
@@ -2188,14 +2490,7 @@ rnp_op_add_signature(rnp_ffi_t                 ffi,
         return RNP_ERROR_NULL_POINTER;
     }
 
-    pgp_key_t *signkey = find_suitable_key(
-      PGP_OP_SIGN, get_key_prefer_public(key), &key->ffi->key_provider, PGP_KF_SIGN);
-    if (signkey && !signkey->is_secret()) {
-        pgp_key_request_ctx_t ctx = {.op = PGP_OP_SIGN, .secret = true};
-        ctx.search.type = PGP_KEY_SEARCH_GRIP;
-        ctx.search.by.grip = signkey->grip();
-        signkey = pgp_request_key(&key->ffi->key_provider, &ctx);
-    }
+    pgp_key_t *signkey = rnp_find_signing_key(key);
     if (!signkey) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
@@ -2243,6 +2538,20 @@ rnp_op_set_compression(rnp_ffi_t ffi, rnp_ctx_t &ctx, const char *compression, i
     return RNP_SUCCESS;
 }
 
+static rnp_result_t
+rnp_op_get_used_compression(rnp_ctx_t &ctx, char **compression)
+{
+    if (!compression) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    /* compression is decided when operation starts */
+    if (ctx.zused < 0) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    return get_map_value(
+      compress_alg_map, ARRAY_SIZE(compress_alg_map), ctx.zused, compression);
+}
+
 static rnp_result_t
 rnp_op_set_hash(rnp_ffi_t ffi, rnp_ctx_t &ctx, const char *hash)
 {
@@ -2285,6 +2594,17 @@ rnp_op_set_file_mtime(rnp_ctx_t &ctx, uint32_t mtime)
     return RNP_SUCCESS;
 }
 
+/* settings may not be changed once data was pushed to the operation */
+static bool
+rnp_op_started(rnp_ffi_t ffi, const pgp_write_stream_t *stream)
+{
+    if (!stream) {
+        return false;
+    }
+    FFI_LOG(ffi, "Operation is already started.");
+    return true;
+}
+
 rnp_result_t
 rnp_op_encrypt_create(rnp_op_encrypt_t *op,
                       rnp_ffi_t         ffi,
@@ -2292,7 +2612,7 @@ rnp_op_encrypt_create(rnp_op_encrypt_t *op,
                       rnp_output_t      output)
 try {
     // checks
-    if (!op || !ffi || !input || !output) {
+    if (!op || !ffi || !output) {
         return RNP_ERROR_NULL_POINTER;
     }
 
@@ -2312,6 +2632,9 @@ try {
     if (!op || !handle) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
 
     pgp_key_t *key = find_suitable_key(PGP_OP_ENCRYPT,
                                        get_key_prefer_public(handle),
@@ -2326,49 +2649,213 @@ try {
 FFI_GUARD
 
 rnp_result_t
-rnp_op_encrypt_add_signature(rnp_op_encrypt_t         op,
-                             rnp_key_handle_t         key,
-                             rnp_op_sign_signature_t *sig)
+rnp_recipient_set_create(rnp_ffi_t ffi, rnp_recipient_set_t *set)
 try {
-    if (!op) {
+    if (!ffi || !set) {
         return RNP_ERROR_NULL_POINTER;
     }
-    return rnp_op_add_signature(op->ffi, op->signatures, key, op->rnpctx, sig);
+    *set = new rnp_recipient_set_st();
+    (*set)->ffi = ffi;
+    (*set)->pubkeys = std::make_shared<pgp_pubkey_cache_t>();
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
+static void
+recipient_set_add_prefs(rnp_recipient_set_t set, pgp_key_t *key)
+{
+    /* preferences are taken from the primary key's self-signature */
+    if (key->is_subkey()) {
+        if (!key->has_primary_fp()) {
+            return;
+        }
+        key = rnp_key_store_get_key_by_fpr(set->ffi->pubring, key->primary_fp());
+        if (!key) {
+            return;
+        }
+    }
+    pgp_subsig_t *sig = key->latest_selfsig(PGP_UID_PRIMARY);
+    if (!sig) {
+        sig = key->latest_selfsig(PGP_UID_ANY);
+    }
+    if (!sig || sig->prefs.symm_algs.empty()) {
+        return;
+    }
+    auto &algs = sig->prefs.symm_algs;
+    if (!set->prefs) {
+        /* only 128-bit block ciphers are picked, so the choice works with AEAD as well */
+        for (auto alg : algs) {
+            pgp_symm_alg_t salg = (pgp_symm_alg_t) alg;
+            if ((pgp_block_size(salg) == 16) && pgp_is_sa_supported(salg)) {
+                set->ciphers.push_back(alg);
+            }
+        }
+        set->prefs = true;
+        return;
+    }
+    /* keep order of the first recipient's preferences */
+    std::vector<uint8_t> common;
+    for (auto alg : set->ciphers) {
+        if (std::find(algs.begin(), algs.end(), alg) != algs.end()) {
+            common.push_back(alg);
+        }
+    }
+    set->ciphers = common;
+}
+
 rnp_result_t
-rnp_op_encrypt_set_hash(rnp_op_encrypt_t op, const char *hash)
+rnp_recipient_set_add(rnp_recipient_set_t set, rnp_key_handle_t handle)
 try {
-    if (!op) {
+    if (!set || !handle) {
         return RNP_ERROR_NULL_POINTER;
     }
-    return rnp_op_set_hash(op->ffi, op->rnpctx, hash);
+    if (handle->ffi != set->ffi) {
+        FFI_LOG(set->ffi, "Key belongs to the other FFI object");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    /* unlike the single operation, unusable key is reported right away */
+    pgp_key_t *key = find_suitable_key(PGP_OP_ENCRYPT,
+                                       get_key_prefer_public(handle),
+                                       &handle->ffi->key_provider,
+                                       PGP_KF_ENCRYPT);
+    if (!key) {
+        FFI_LOG(set->ffi, "No suitable encryption key");
+        return RNP_ERROR_NO_SUITABLE_KEY;
+    }
+    if (!set->pubkeys->add(*key)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    set->keys.push_back(key->fp());
+    recipient_set_add_prefs(set, get_key_prefer_public(handle));
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
 rnp_result_t
-rnp_op_encrypt_set_creation_time(rnp_op_encrypt_t op, uint32_t create)
+rnp_recipient_set_get_count(rnp_recipient_set_t set, size_t *count)
 try {
-    if (!op) {
+    if (!set || !count) {
         return RNP_ERROR_NULL_POINTER;
     }
-    return rnp_op_set_creation_time(op->rnpctx, create);
+    *count = set->keys.size();
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
 rnp_result_t
-rnp_op_encrypt_set_expiration_time(rnp_op_encrypt_t op, uint32_t expire)
+rnp_recipient_set_destroy(rnp_recipient_set_t set)
 try {
-    if (!op) {
-        return RNP_ERROR_NULL_POINTER;
-    }
-    return rnp_op_set_expiration_time(op->rnpctx, expire);
+    delete set;
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
 rnp_result_t
-rnp_op_encrypt_add_password(rnp_op_encrypt_t op,
+rnp_op_encrypt_add_recipient_set(rnp_op_encrypt_t op, rnp_recipient_set_t set)
+try {
+    if (!op || !set) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (op->ffi != set->ffi) {
+        FFI_LOG(op->ffi, "Recipient set belongs to the other FFI object");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    /* keys are already resolved, so encryption will use them as is */
+    std::vector<pgp_key_t *> keys;
+    for (auto &fp : set->keys) {
+        pgp_key_t *key = rnp_key_store_get_key_by_fpr(op->ffi->pubring, fp);
+        if (!key) {
+            key = rnp_key_store_get_key_by_fpr(op->ffi->secring, fp);
+        }
+        if (!key) {
+            FFI_LOG(op->ffi, "Recipient's key is not available anymore");
+            return RNP_ERROR_KEY_NOT_FOUND;
+        }
+        keys.push_back(key);
+    }
+    auto &recipients = op->rnpctx.recipients;
+    recipients.insert(recipients.end(), keys.begin(), keys.end());
+    op->rnpctx.pubkeys.push_back(set->pubkeys);
+    if (!op->cipher_set && !set->ciphers.empty()) {
+        op->rnpctx.ealg = (pgp_symm_alg_t) set->ciphers.front();
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_set_recipient_threads(rnp_op_encrypt_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    op->rnpctx.ethreads = threads;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_add_signature(rnp_op_encrypt_t         op,
+                             rnp_key_handle_t         key,
+                             rnp_op_sign_signature_t *sig)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    return rnp_op_add_signature(op->ffi, op->signatures, key, op->rnpctx, sig);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_set_hash(rnp_op_encrypt_t op, const char *hash)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    return rnp_op_set_hash(op->ffi, op->rnpctx, hash);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_set_creation_time(rnp_op_encrypt_t op, uint32_t create)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    return rnp_op_set_creation_time(op->rnpctx, create);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_set_expiration_time(rnp_op_encrypt_t op, uint32_t expire)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    return rnp_op_set_expiration_time(op->rnpctx, expire);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_add_password(rnp_op_encrypt_t op,
                             const char *     password,
                             const char *     s2k_hash,
                             size_t           iterations,
@@ -2378,6 +2865,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     if (password && !*password) {
         // no blank passwords
         FFI_LOG(op->ffi, "Blank password");
@@ -2428,6 +2918,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_armor(op->rnpctx, armored);
 }
 FFI_GUARD
@@ -2439,10 +2932,14 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     if (!str_to_cipher(cipher, &op->rnpctx.ealg)) {
         FFI_LOG(op->ffi, "Invalid cipher: %s", cipher);
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    op->cipher_set = true;
     return RNP_SUCCESS;
 }
 FFI_GUARD
@@ -2454,6 +2951,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     if (!str_to_aead_alg(alg, &op->rnpctx.aalg)) {
         FFI_LOG(op->ffi, "Invalid AEAD algorithm: %s", alg);
         return RNP_ERROR_BAD_PARAMETERS;
@@ -2468,6 +2968,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     if ((bits < 0) || (bits > 56)) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
@@ -2483,16 +2986,60 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_compression(op->ffi, op->rnpctx, compression, level);
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_encrypt_set_compression_threads(rnp_op_encrypt_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    op->rnpctx.zthreads = threads;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_set_compression_auto(rnp_op_encrypt_t op, bool enable)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    op->rnpctx.zauto = enable;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_get_used_compression(rnp_op_encrypt_t op, char **compression)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    return rnp_op_get_used_compression(op->rnpctx, compression);
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_encrypt_set_file_name(rnp_op_encrypt_t op, const char *filename)
 try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_file_name(op->rnpctx, filename);
 }
 FFI_GUARD
@@ -2503,6 +3050,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_file_mtime(op->rnpctx, mtime);
 }
 FFI_GUARD
@@ -2545,6 +3095,75 @@ rnp_op_add_signatures(rnp_op_sign_signatures_t &opsigs, rnp_ctx_t &ctx)
     return RNP_SUCCESS;
 }
 
+/* start processing of the data, which is pushed to the operation via feed calls */
+static rnp_result_t
+rnp_op_stream_start(rnp_ffi_t                 ffi,
+                    rnp_ctx_t &               ctx,
+                    rnp_op_sign_signatures_t &signatures,
+                    rnp_output_t              output,
+                    bool                      encrypt,
+                    pgp_write_stream_t **     stream)
+{
+    // set the default hash alg if none was specified
+    if (!ctx.halg) {
+        ctx.halg = DEFAULT_PGP_HASH_ALG;
+    }
+    pgp_write_handler_t handler =
+      pgp_write_handler(&ffi->pass_provider, &ctx, NULL, &ffi->key_provider);
+
+    bool         sign = !encrypt || !signatures.empty();
+    rnp_result_t ret;
+    if (sign && (ret = rnp_op_add_signatures(signatures, ctx))) {
+        return ret;
+    }
+    pgp_write_stream_t *res = new pgp_write_stream_t();
+    if ((ret = rnp_write_stream_init(&handler, res, &output->dst, encrypt, sign))) {
+        delete res;
+        return ret;
+    }
+    *stream = res;
+    return RNP_SUCCESS;
+}
+
+static void
+rnp_op_stream_destroy(pgp_write_stream_t *&stream, bool discard)
+{
+    if (!stream) {
+        return;
+    }
+    rnp_write_stream_close(stream, discard);
+    delete stream;
+    stream = NULL;
+}
+
+static rnp_result_t
+rnp_op_stream_feed(pgp_write_stream_t *&stream,
+                   rnp_output_t &       output,
+                   const uint8_t *      buf,
+                   size_t               len)
+{
+    rnp_result_t ret = rnp_write_stream_feed(stream, buf, len);
+    /* make produced data available to the output's reader as soon as possible */
+    dst_flush(&output->dst);
+    if (ret) {
+        rnp_op_stream_destroy(stream, true);
+        output->keep = false;
+        output = NULL;
+    }
+    return ret;
+}
+
+static rnp_result_t
+rnp_op_stream_finish(pgp_write_stream_t *&stream, rnp_output_t &output)
+{
+    rnp_result_t ret = rnp_write_stream_finish(stream);
+    rnp_op_stream_destroy(stream, ret != RNP_SUCCESS);
+    dst_flush(&output->dst);
+    output->keep = ret == RNP_SUCCESS;
+    output = NULL;
+    return ret;
+}
+
 rnp_result_t
 rnp_op_encrypt_execute(rnp_op_encrypt_t op)
 try {
@@ -2578,9 +3197,57 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_encrypt_feed(rnp_op_encrypt_t op, const uint8_t *buf, size_t len)
+try {
+    if (!op || (!buf && len)) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!op->output) {
+        FFI_LOG(op->ffi, "Operation is already finished.");
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (!op->stream) {
+        rnp_result_t ret = rnp_op_stream_start(
+          op->ffi, op->rnpctx, op->signatures, op->output, true, &op->stream);
+        if (ret) {
+            op->output = NULL;
+            return ret;
+        }
+        /* input is not used anymore */
+        op->input = NULL;
+    }
+    return rnp_op_stream_feed(op->stream, op->output, buf, len);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_encrypt_finish(rnp_op_encrypt_t op)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!op->output) {
+        FFI_LOG(op->ffi, "Operation is already finished.");
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (!op->stream) {
+        /* no data was fed */
+        rnp_result_t ret = rnp_op_encrypt_feed(op, NULL, 0);
+        if (ret) {
+            return ret;
+        }
+    }
+    return rnp_op_stream_finish(op->stream, op->output);
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_encrypt_destroy(rnp_op_encrypt_t op)
 try {
+    if (op) {
+        rnp_op_stream_destroy(op->stream, true);
+    }
     delete op;
     return RNP_SUCCESS;
 }
@@ -2590,7 +3257,7 @@ rnp_result_t
 rnp_op_sign_create(rnp_op_sign_t *op, rnp_ffi_t ffi, rnp_input_t input, rnp_output_t output)
 try {
     // checks
-    if (!op || !ffi || !input || !output) {
+    if (!op || !ffi || !output) {
         return RNP_ERROR_NULL_POINTER;
     }
 
@@ -2637,10 +3304,212 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_add_signature(op->ffi, op->signatures, key, op->rnpctx, sig);
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_signer_create(rnp_ffi_t ffi, rnp_key_handle_t key, rnp_signer_t *signer)
+try {
+    if (!ffi || !key || !signer) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (key->ffi != ffi) {
+        FFI_LOG(ffi, "Key belongs to the other FFI object");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    pgp_key_t *signkey = rnp_find_signing_key(key);
+    if (!signkey) {
+        FFI_LOG(ffi, "No suitable signing key");
+        return RNP_ERROR_NO_SUITABLE_KEY;
+    }
+
+    std::unique_ptr<rnp_signer_st> obj(new rnp_signer_st());
+    obj->ffi = ffi;
+    obj->fp = signkey->fp();
+    obj->keyid = signkey->keyid();
+    if (signkey->encrypted()) {
+        pgp_password_ctx_t ctx = {.op = PGP_OP_SIGN, .key = signkey};
+        pgp_key_pkt_t *    seckey = pgp_decrypt_seckey_cached(
+          ffi->keycache, signkey, &ffi->pass_provider, &ctx);
+        if (!seckey) {
+            FFI_LOG(ffi, "Failed to unlock the signing key");
+            return RNP_ERROR_BAD_PASSWORD;
+        }
+        obj->seckey = std::move(*seckey);
+        delete seckey;
+    } else {
+        obj->seckey = signkey->pkt();
+    }
+    *signer = obj.release();
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_signer_destroy(rnp_signer_t signer)
+try {
+    delete signer;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_sign_add_signer(rnp_op_sign_t op, rnp_signer_t signer, rnp_op_sign_signature_t *sig)
+try {
+    if (!op || !signer) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (op->ffi != signer->ffi) {
+        FFI_LOG(op->ffi, "Signer belongs to the other FFI object");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    /* key could be unloaded or reloaded after the signer was created */
+    pgp_key_t *key = rnp_key_store_get_key_by_fpr(op->ffi->secring, signer->fp);
+    if (!key) {
+        FFI_LOG(op->ffi, "Signer's key is not available anymore");
+        return RNP_ERROR_KEY_NOT_FOUND;
+    }
+    op->signatures.emplace_back();
+    rnp_op_sign_signature_t newsig = &op->signatures.back();
+    newsig->signer.key = key;
+    newsig->signer.seckey = &signer->seckey;
+    newsig->signer.sigcreate = op->rnpctx.sigcreate;
+    newsig->signer.sigexpire = op->rnpctx.sigexpire;
+    newsig->ffi = op->ffi;
+    if (sig) {
+        *sig = newsig;
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_signer_digest_create(rnp_signer_t signer, const char *hash, rnp_digest_t *digest)
+try {
+    if (!signer || !hash || !digest) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    pgp_hash_alg_t halg = PGP_HASH_UNKNOWN;
+    if (!str_to_hash_alg(hash, &halg)) {
+        FFI_LOG(signer->ffi, "Invalid hash: %s", hash);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    halg = pgp_hash_adjust_alg_to_key(halg, &signer->seckey);
+
+    std::unique_ptr<rnp_digest_st> obj(new rnp_digest_st());
+    obj->signer = signer;
+    rnp_result_t ret = signature_init(&signer->seckey.material, halg, &obj->hash);
+    if (ret) {
+        return ret;
+    }
+    *digest = obj.release();
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_digest_update(rnp_digest_t digest, const uint8_t *data, size_t len)
+try {
+    if (!digest || (!data && len)) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (len && pgp_hash_add(&digest->hash, data, len)) {
+        return RNP_ERROR_GENERIC;
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_digest_destroy(rnp_digest_t digest)
+try {
+    if (digest) {
+        pgp_hash_finish(&digest->hash, NULL);
+        delete digest;
+    }
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+static rnp_result_t
+rnp_signer_sign_digest(rnp_signer_t signer,
+                       rnp_digest_t digest,
+                       rnp_output_t output,
+                       rng_t *      rng)
+{
+    if (!digest || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (digest->signer != signer) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    pgp_signature_t sig;
+    sig.version = PGP_V4;
+    sig.halg = pgp_hash_alg_type(&digest->hash);
+    sig.palg = signer->seckey.alg;
+    sig.set_type(PGP_SIG_BINARY);
+    sig.set_keyfp(signer->fp);
+    sig.set_keyid(signer->keyid);
+    sig.set_creation(time(NULL));
+    if (!signature_fill_hashed_data(&sig)) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    /* digest context is kept intact, so it may be updated and signed again */
+    pgp_hash_t hash;
+    if (!pgp_hash_copy(&hash, &digest->hash)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    rnp_result_t ret = signature_calculate(&sig, &signer->seckey.material, &hash, rng);
+    if (ret) {
+        return ret;
+    }
+    sig.write(output->dst);
+    ret = output->dst.werr;
+    output->keep = !ret;
+    return ret;
+}
+
+rnp_result_t
+rnp_signer_sign_digests(rnp_signer_t  signer,
+                        rnp_digest_t *digests,
+                        size_t        count,
+                        size_t        threads,
+                        rnp_output_t *outputs,
+                        rnp_result_t *results)
+try {
+    if (!signer || !digests || !outputs || !results) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!count) {
+        return RNP_SUCCESS;
+    }
+
+    rnp_worker_rngs_t rngs(rnp_worker_count(threads, count));
+    rnp_run_workers(threads, count, [&](size_t idx, size_t worker) {
+        rng_t *rng = rngs.get(worker);
+        if (!rng) {
+            results[idx] = RNP_ERROR_RNG;
+            return;
+        }
+        try {
+            results[idx] = rnp_signer_sign_digest(signer, digests[idx], outputs[idx], rng);
+        } catch (const std::exception &e) {
+            FFI_LOG(signer->ffi, "%s", e.what());
+            results[idx] = RNP_ERROR_GENERIC;
+        }
+    });
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_sign_signature_set_hash(rnp_op_sign_signature_t sig, const char *hash)
 try {
@@ -2686,6 +3555,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_armor(op->rnpctx, armored);
 }
 FFI_GUARD
@@ -2696,16 +3568,60 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_compression(op->ffi, op->rnpctx, compression, level);
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_sign_set_compression_threads(rnp_op_sign_t op, size_t threads)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    op->rnpctx.zthreads = threads;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_sign_set_compression_auto(rnp_op_sign_t op, bool enable)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
+    op->rnpctx.zauto = enable;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_sign_get_used_compression(rnp_op_sign_t op, char **compression)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    return rnp_op_get_used_compression(op->rnpctx, compression);
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_sign_set_hash(rnp_op_sign_t op, const char *hash)
 try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_hash(op->ffi, op->rnpctx, hash);
 }
 FFI_GUARD
@@ -2716,6 +3632,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_creation_time(op->rnpctx, create);
 }
 FFI_GUARD
@@ -2726,6 +3645,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_expiration_time(op->rnpctx, expire);
 }
 FFI_GUARD
@@ -2736,6 +3658,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_file_name(op->rnpctx, filename);
 }
 FFI_GUARD
@@ -2746,6 +3671,9 @@ try {
     if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    if (rnp_op_started(op->ffi, op->stream)) {
+        return RNP_ERROR_BAD_STATE;
+    }
     return rnp_op_set_file_mtime(op->rnpctx, mtime);
 }
 FFI_GUARD
@@ -2779,9 +3707,57 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_sign_feed(rnp_op_sign_t op, const uint8_t *buf, size_t len)
+try {
+    if (!op || (!buf && len)) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!op->output) {
+        FFI_LOG(op->ffi, "Operation is already finished.");
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (!op->stream) {
+        rnp_result_t ret = rnp_op_stream_start(
+          op->ffi, op->rnpctx, op->signatures, op->output, false, &op->stream);
+        if (ret) {
+            op->output = NULL;
+            return ret;
+        }
+        /* input is not used anymore */
+        op->input = NULL;
+    }
+    return rnp_op_stream_feed(op->stream, op->output, buf, len);
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_sign_finish(rnp_op_sign_t op)
+try {
+    if (!op) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (!op->output) {
+        FFI_LOG(op->ffi, "Operation is already finished.");
+        return RNP_ERROR_BAD_STATE;
+    }
+    if (!op->stream) {
+        /* no data was fed */
+        rnp_result_t ret = rnp_op_sign_feed(op, NULL, 0);
+        if (ret) {
+            return ret;
+        }
+    }
+    return rnp_op_stream_finish(op->stream, op->output);
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_sign_destroy(rnp_op_sign_t op)
 try {
+    if (op) {
+        rnp_op_stream_destroy(op->stream, true);
+    }
     delete op;
     return RNP_SUCCESS;
 }
@@ -2824,6 +3800,17 @@ rnp_op_verify_on_signatures(const std::vector<pgp_signature_info_t> &sigs, void
         }
         res->ffi = op->ffi;
     }
+
+    /* signatures of all detached inputs are processed at once, in the order of inputs */
+    size_t idx = 0;
+    size_t left = op->detached_counts.empty() ? 0 : op->detached_counts[0];
+    for (i = 0; i < op->signature_count; i++) {
+        while (!left && (idx + 1 < op->detached_counts.size())) {
+            left = op->detached_counts[++idx];
+        }
+        op->signatures[i].input_idx = idx;
+        left -= !!left;
+    }
 }
 
 static bool
@@ -2957,84 +3944,278 @@ rnp_verify_on_decryption_info(bool mdc, pgp_aead_alg_t aead, pgp_symm_alg_t salg
     op->encrypted = true;
 }
 
-static void
-rnp_verify_on_decryption_done(bool validated, void *param)
-{
-    rnp_op_verify_t op = (rnp_op_verify_t) param;
-    if (op->encrypted_layers > 1) {
-        return;
+static void
+rnp_verify_on_decryption_done(bool validated, void *param)
+{
+    rnp_op_verify_t op = (rnp_op_verify_t) param;
+    if (op->encrypted_layers > 1) {
+        return;
+    }
+    op->validated = validated;
+}
+
+rnp_result_t
+rnp_op_verify_create(rnp_op_verify_t *op,
+                     rnp_ffi_t        ffi,
+                     rnp_input_t      input,
+                     rnp_output_t     output)
+try {
+    if (!op || !ffi || !input || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+
+    *op = new rnp_op_verify_st();
+    rnp_ctx_init_ffi((*op)->rnpctx, ffi);
+    (*op)->ffi = ffi;
+    (*op)->input = input;
+    (*op)->output = output;
+
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+rnp_result_t
+rnp_op_verify_detached_create(rnp_op_verify_t *op,
+                              rnp_ffi_t        ffi,
+                              rnp_input_t      input,
+                              rnp_input_t      signature)
+try {
+    if (!op || !ffi || !input || !signature) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+
+    *op = new rnp_op_verify_st();
+    rnp_ctx_init_ffi((*op)->rnpctx, ffi);
+    (*op)->rnpctx.detached = true;
+    (*op)->ffi = ffi;
+    (*op)->input = signature;
+    (*op)->detached_input = input;
+
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
+/* read signatures from all of the detached inputs, so data is hashed and processed once */
+static rnp_result_t
+rnp_op_verify_process_detached(rnp_op_verify_t op, pgp_parse_handler_t &handler)
+{
+    pgp_dest_t memdst = {};
+    if (init_mem_dest(&memdst, NULL, 0)) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = RNP_SUCCESS;
+    op->detached_counts.clear();
+    for (size_t i = 0; i <= op->detached_sigs.size(); i++) {
+        rnp_input_t          input = i ? op->detached_sigs[i - 1] : op->input;
+        pgp_signature_list_t sigs;
+        ret = process_pgp_signatures(&input->src, sigs);
+        if (ret) {
+            FFI_LOG(op->ffi, "Failed to read signatures from input %zu", i);
+            break;
+        }
+        try {
+            for (auto &sig : sigs) {
+                sig.write(memdst);
+            }
+            op->detached_counts.push_back(sigs.size());
+        } catch (const std::exception &e) {
+            FFI_LOG(op->ffi, "%s", e.what());
+            ret = RNP_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+    }
+    if (!ret && memdst.werr) {
+        ret = memdst.werr;
+    }
+    if (!ret && !memdst.writeb) {
+        FFI_LOG(op->ffi, "No signatures found");
+        ret = RNP_ERROR_NO_SIGNATURES_FOUND;
+    }
+    pgp_source_t sigsrc = {};
+    size_t       len = memdst.writeb;
+    if (!ret && init_mem_src(&sigsrc, mem_dest_own_memory(&memdst), len, true)) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+    }
+    dst_close(&memdst, true);
+    if (ret) {
+        op->detached_counts.clear();
+        return ret;
+    }
+    ret = process_pgp_source(&handler, sigsrc);
+    src_close(&sigsrc);
+    return ret;
+}
+
+static rnp_result_t
+rnp_op_verify_process(rnp_op_verify_t           op,
+                      pgp_key_provider_t *     key_provider,
+                      pgp_password_provider_t *pass_provider)
+{
+    pgp_parse_handler_t handler;
+
+    handler.password_provider = pass_provider;
+    handler.key_provider = key_provider;
+    handler.on_signatures = rnp_op_verify_on_signatures;
+    handler.src_provider = rnp_verify_src_provider;
+    handler.dest_provider = rnp_verify_dest_provider;
+    handler.on_recipients = rnp_verify_on_recipients;
+    handler.on_decryption_start = rnp_verify_on_decryption_start;
+    handler.on_decryption_info = rnp_verify_on_decryption_info;
+    handler.on_decryption_done = rnp_verify_on_decryption_done;
+    handler.param = op;
+    handler.ctx = &op->rnpctx;
+
+    if (!op->detached_sigs.empty()) {
+        return rnp_op_verify_process_detached(op, handler);
     }
-    op->validated = validated;
+    rnp_result_t ret = process_pgp_source(&handler, op->input->src);
+    if (op->output) {
+        dst_flush(&op->output->dst);
+        op->output->keep = ret == RNP_SUCCESS;
+    }
+    return ret;
 }
 
 rnp_result_t
-rnp_op_verify_create(rnp_op_verify_t *op,
-                     rnp_ffi_t        ffi,
-                     rnp_input_t      input,
-                     rnp_output_t     output)
+rnp_op_verify_add_detached_signature(rnp_op_verify_t op, rnp_input_t signature)
 try {
-    if (!op || !ffi || !input || !output) {
+    if (!op || !signature) {
         return RNP_ERROR_NULL_POINTER;
     }
-
-    *op = new rnp_op_verify_st();
-    rnp_ctx_init_ffi((*op)->rnpctx, ffi);
-    (*op)->ffi = ffi;
-    (*op)->input = input;
-    (*op)->output = output;
-
+    if (!op->rnpctx.detached) {
+        FFI_LOG(op->ffi, "Operation is not a detached signature verification");
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    op->detached_sigs.push_back(signature);
     return RNP_SUCCESS;
 }
 FFI_GUARD
 
 rnp_result_t
-rnp_op_verify_detached_create(rnp_op_verify_t *op,
-                              rnp_ffi_t        ffi,
-                              rnp_input_t      input,
-                              rnp_input_t      signature)
+rnp_op_verify_execute(rnp_op_verify_t op)
 try {
-    if (!op || !ffi || !input || !signature) {
+    if (!op) {
         return RNP_ERROR_NULL_POINTER;
     }
+    return rnp_op_verify_process(op, &op->ffi->key_provider, &op->ffi->pass_provider);
+}
+FFI_GUARD
 
-    *op = new rnp_op_verify_st();
-    rnp_ctx_init_ffi((*op)->rnpctx, ffi);
-    (*op)->rnpctx.detached = true;
-    (*op)->ffi = ffi;
-    (*op)->input = signature;
-    (*op)->detached_input = input;
+/* state, shared between the batch verification workers */
+typedef struct rnp_verify_batch_t {
+    rnp_ffi_t        ffi;
+    rnp_op_verify_t *ops;
+    rnp_result_t *   results;
+    std::mutex       pass_lock;
+} rnp_verify_batch_t;
 
-    return RNP_SUCCESS;
+static pgp_key_t *
+rnp_verify_batch_key_provider(const pgp_key_request_ctx_t *ctx, void *userdata)
+{
+    /* key store is only read here, so no locking is needed. Key callback is not called since
+     * it may modify the key store */
+    rnp_verify_batch_t *batch = (rnp_verify_batch_t *) userdata;
+    return find_key(
+      batch->ffi, &ctx->search, ctx->secret ? KEY_TYPE_SECRET : KEY_TYPE_PUBLIC, false);
+}
+
+static bool
+rnp_verify_batch_pass_provider(const pgp_password_ctx_t *ctx,
+                               char *                    password,
+                               size_t                    password_size,
+                               void *                    userdata)
+{
+    rnp_verify_batch_t *        batch = (rnp_verify_batch_t *) userdata;
+    std::lock_guard<std::mutex> lock(batch->pass_lock);
+    return pgp_request_password(&batch->ffi->pass_provider, ctx, password, password_size);
+}
+
+static void
+rnp_verify_batch_item(rnp_verify_batch_t *batch,
+                      size_t              idx,
+                      rng_t *             rng,
+                      pgp_stream_stats_t &stats)
+{
+    pgp_key_provider_t      key_provider = {rnp_verify_batch_key_provider, batch};
+    pgp_password_provider_t pass_provider = {rnp_verify_batch_pass_provider, batch};
+    rnp_op_verify_t         op = batch->ops[idx];
+
+    if (!rng) {
+        batch->results[idx] = RNP_ERROR_RNG;
+        return;
+    }
+    op->rnpctx.rng = rng;
+    /* stream counters are accumulated per thread and merged afterwards */
+    pgp_stream_stats_t *opstats = op->rnpctx.stats;
+    if (opstats) {
+        op->rnpctx.stats = &stats;
+    }
+    try {
+        batch->results[idx] = rnp_op_verify_process(op, &key_provider, &pass_provider);
+    } catch (const std::bad_alloc &) {
+        batch->results[idx] = RNP_ERROR_OUT_OF_MEMORY;
+    } catch (const std::exception &e) {
+        FFI_LOG(batch->ffi, "%s", e.what());
+        batch->results[idx] = RNP_ERROR_GENERIC;
+    }
+    op->rnpctx.rng = &batch->ffi->rng;
+    op->rnpctx.stats = opstats;
 }
-FFI_GUARD
 
 rnp_result_t
-rnp_op_verify_execute(rnp_op_verify_t op)
+rnp_op_verify_execute_batch(rnp_op_verify_t *ops,
+                            size_t           count,
+                            size_t           threads,
+                            rnp_result_t *   results)
 try {
-    if (!op) {
+    if (!ops || !results) {
         return RNP_ERROR_NULL_POINTER;
     }
+    for (size_t i = 0; i < count; i++) {
+        if (!ops[i]) {
+            return RNP_ERROR_NULL_POINTER;
+        }
+        if (ops[i]->ffi != ops[0]->ffi) {
+            FFI_LOG(ops[0]->ffi, "All operations must belong to the same ffi object.");
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+    }
+    if (!count) {
+        return RNP_SUCCESS;
+    }
+    /* operations are run concurrently, so they may not share any state */
+    std::unordered_set<const void *> used;
+    for (size_t i = 0; i < count; i++) {
+        rnp_op_verify_t op = ops[i];
+        if (!used.insert(op).second) {
+            FFI_LOG(op->ffi, "Operation %zu is listed twice.", i);
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        std::vector<const void *> streams = {op->input, op->detached_input, op->output};
+        streams.insert(streams.end(), op->detached_sigs.begin(), op->detached_sigs.end());
+        for (auto stream : streams) {
+            if (stream && !used.insert(stream).second) {
+                FFI_LOG(op->ffi, "Operation %zu shares input or output with another one.", i);
+                return RNP_ERROR_BAD_PARAMETERS;
+            }
+        }
+    }
 
-    pgp_parse_handler_t handler;
-
-    handler.password_provider = &op->ffi->pass_provider;
-    handler.key_provider = &op->ffi->key_provider;
-    handler.on_signatures = rnp_op_verify_on_signatures;
-    handler.src_provider = rnp_verify_src_provider;
-    handler.dest_provider = rnp_verify_dest_provider;
-    handler.on_recipients = rnp_verify_on_recipients;
-    handler.on_decryption_start = rnp_verify_on_decryption_start;
-    handler.on_decryption_info = rnp_verify_on_decryption_info;
-    handler.on_decryption_done = rnp_verify_on_decryption_done;
-    handler.param = op;
-    handler.ctx = &op->rnpctx;
+    rnp_verify_batch_t batch;
+    batch.ffi = ops[0]->ffi;
+    batch.ops = ops;
+    batch.results = results;
 
-    rnp_result_t ret = process_pgp_source(&handler, op->input->src);
-    if (op->output) {
-        dst_flush(&op->output->dst);
-        op->output->keep = ret == RNP_SUCCESS;
+    size_t                          workers = rnp_worker_count(threads, count);
+    rnp_worker_rngs_t               rngs(workers);
+    std::vector<pgp_stream_stats_t> stats(workers);
+    rnp_run_workers(threads, count, [&](size_t idx, size_t worker) {
+        rnp_verify_batch_item(&batch, idx, rngs.get(worker), stats[worker]);
+    });
+    for (auto &wstats : stats) {
+        stream_stats_merge(batch.ffi->stats, wstats);
     }
-    return ret;
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
@@ -3316,6 +4497,17 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_op_verify_signature_get_input_index(rnp_op_verify_signature_t sig, size_t *index)
+try {
+    if (!sig || !index) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    *index = sig->input_idx;
+    return RNP_SUCCESS;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_op_verify_signature_get_handle(rnp_op_verify_signature_t sig,
                                    rnp_signature_handle_t *  handle)
@@ -3438,6 +4630,31 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_decrypt_range(
+  rnp_ffi_t ffi, rnp_input_t input, uint64_t offset, uint64_t length, rnp_output_t output)
+try {
+    // checks
+    if (!ffi || !input || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+
+    rnp_ctx_t rnpctx;
+    rnp_ctx_init_ffi(rnpctx, ffi);
+    pgp_parse_handler_t handler;
+    memset(&handler, 0, sizeof(handler));
+    handler.password_provider = &ffi->pass_provider;
+    handler.key_provider = &ffi->key_provider;
+    handler.ctx = &rnpctx;
+
+    rnp_result_t ret =
+      rnp_decrypt_range_src(&handler, input->src, offset, length, output->dst);
+    dst_flush(&output->dst);
+    output->keep = (ret == RNP_SUCCESS);
+    return ret;
+}
+FFI_GUARD
+
 static rnp_result_t
 str_to_locator(rnp_ffi_t         ffi,
                pgp_key_search_t *locator,
@@ -3949,6 +5166,7 @@ try {
         if (!key->ffi->secring || !key->sec) {
             return RNP_ERROR_BAD_PARAMETERS;
         }
+        rnp_key_cache_flush(key->ffi, key->sec, sub);
         if (!rnp_key_store_remove_key(key->ffi->secring, key->sec, sub)) {
             return RNP_ERROR_KEY_NOT_FOUND;
         }
@@ -4515,6 +5733,67 @@ done:
     return ret;
 }
 
+static rnp_result_t
+gen_json_sections(rnp_ffi_t ffi, json_object *jso, json_object **primary, json_object **sub)
+{
+    json_object_object_foreach(jso, key, value)
+    {
+        json_object **dest = NULL;
+
+        if (rnp_strcasecmp(key, "primary") == 0) {
+            dest = primary;
+        } else if (rnp_strcasecmp(key, "sub") == 0) {
+            dest = sub;
+        } else {
+            // unrecognized key in the object
+            FFI_LOG(ffi, "Unexpected key in JSON: %s", key);
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+
+        // duplicate "primary"/"sub"
+        if (*dest) {
+            return RNP_ERROR_BAD_PARAMETERS;
+        }
+        *dest = value;
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+gen_json_add_keys(rnp_ffi_t                  ffi,
+                  const rnp_action_keygen_t &desc,
+                  pgp_key_t &                primary_sec,
+                  pgp_key_t &                primary_pub,
+                  pgp_key_t *                sub_sec,
+                  pgp_key_t *                sub_pub)
+{
+    if (ffi->pubring) {
+        if (!rnp_key_store_add_key(ffi->pubring, &primary_pub)) {
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
+        if (sub_pub && !rnp_key_store_add_key(ffi->pubring, sub_pub)) {
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    /* add key/subkey protection */
+    if (desc.primary.protection.symm_alg &&
+        !primary_sec.protect(desc.primary.protection, ffi->pass_provider)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    if (sub_sec && desc.subkey.protection.symm_alg &&
+        !sub_sec->protect(desc.subkey.protection, ffi->pass_provider)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    if (!rnp_key_store_add_key(ffi->secring, &primary_sec)) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    if (sub_sec && !rnp_key_store_add_key(ffi->secring, sub_sec)) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_generate_key_json(rnp_ffi_t ffi, const char *json, char **results)
 try {
@@ -4546,29 +5825,9 @@ try {
     }
 
     // locate the appropriate sections
-    {
-        json_object_object_foreach(jso, key, value)
-        {
-            json_object **dest = NULL;
-
-            if (rnp_strcasecmp(key, "primary") == 0) {
-                dest = &jsoprimary;
-            } else if (rnp_strcasecmp(key, "sub") == 0) {
-                dest = &jsosub;
-            } else {
-                // unrecognized key in the object
-                FFI_LOG(ffi, "Unexpected key in JSON: %s", key);
-                ret = RNP_ERROR_BAD_PARAMETERS;
-                goto done;
-            }
-
-            // duplicate "primary"/"sub"
-            if (*dest) {
-                ret = RNP_ERROR_BAD_PARAMETERS;
-                goto done;
-            }
-            *dest = value;
-        }
+    ret = gen_json_sections(ffi, jso, &jsoprimary, &jsosub);
+    if (ret) {
+        goto done;
     }
 
     if (jsoprimary && jsosub) { // generating primary+sub
@@ -4577,6 +5836,8 @@ try {
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
         }
+        keygen_desc.primary.keygen.crypto.pool = ffi->keypool;
+        keygen_desc.subkey.keygen.crypto.pool = ffi->keypool;
         if (!pgp_generate_keypair(&ffi->rng,
                                   &keygen_desc.primary.keygen,
                                   &keygen_desc.subkey.keygen,
@@ -4592,39 +5853,14 @@ try {
             ret = RNP_ERROR_OUT_OF_MEMORY;
             goto done;
         }
-        if (ffi->pubring) {
-            if (!rnp_key_store_add_key(ffi->pubring, &primary_pub)) {
-                ret = RNP_ERROR_OUT_OF_MEMORY;
-                goto done;
-            }
-            if (!rnp_key_store_add_key(ffi->pubring, &sub_pub)) {
-                ret = RNP_ERROR_OUT_OF_MEMORY;
-                goto done;
-            }
-        }
-        /* add key/subkey protection */
-        if (keygen_desc.primary.protection.symm_alg &&
-            !primary_sec.protect(keygen_desc.primary.protection, ffi->pass_provider)) {
-            ret = RNP_ERROR_BAD_PARAMETERS;
-            goto done;
-        }
-
-        if (keygen_desc.subkey.protection.symm_alg &&
-            !sub_sec.protect(keygen_desc.subkey.protection, ffi->pass_provider)) {
-            ret = RNP_ERROR_BAD_PARAMETERS;
-            goto done;
-        }
-
-        if (!rnp_key_store_add_key(ffi->secring, &primary_sec)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto done;
-        }
-        if (!rnp_key_store_add_key(ffi->secring, &sub_sec)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
+        ret =
+          gen_json_add_keys(ffi, keygen_desc, primary_sec, primary_pub, &sub_sec, &sub_pub);
+        if (ret) {
             goto done;
         }
     } else if (jsoprimary && !jsosub) { // generating primary only
         keygen_desc.primary.keygen.crypto.rng = &ffi->rng;
+        keygen_desc.primary.keygen.crypto.pool = ffi->keypool;
         if (!parse_keygen_primary(jsoprimary, &keygen_desc)) {
             ret = RNP_ERROR_BAD_PARAMETERS;
             goto done;
@@ -4640,21 +5876,8 @@ try {
             ret = RNP_ERROR_OUT_OF_MEMORY;
             goto done;
         }
-        if (ffi->pubring) {
-            if (!rnp_key_store_add_key(ffi->pubring, &primary_pub)) {
-                ret = RNP_ERROR_OUT_OF_MEMORY;
-                goto done;
-            }
-        }
-        /* encrypt secret key if specified */
-        if (keygen_desc.primary.protection.symm_alg &&
-            !primary_sec.protect(keygen_desc.primary.protection, ffi->pass_provider)) {
-            ret = RNP_ERROR_BAD_PARAMETERS;
-            goto done;
-        }
-
-        if (!rnp_key_store_add_key(ffi->secring, &primary_sec)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
+        ret = gen_json_add_keys(ffi, keygen_desc, primary_sec, primary_pub, NULL, NULL);
+        if (ret) {
             goto done;
         }
     } else if (jsosub) { // generating subkey only
@@ -4702,6 +5925,7 @@ try {
             goto done;
         }
         keygen_desc.subkey.keygen.crypto.rng = &ffi->rng;
+        keygen_desc.subkey.keygen.crypto.pool = ffi->keypool;
         if (!pgp_generate_subkey(&keygen_desc.subkey.keygen,
                                  true,
                                  primary_sec,
@@ -4729,22 +5953,169 @@ try {
             goto done;
         }
 
-        if (!rnp_key_store_add_key(ffi->secring, &sub_sec)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto done;
+        if (!rnp_key_store_add_key(ffi->secring, &sub_sec)) {
+            ret = RNP_ERROR_OUT_OF_MEMORY;
+            goto done;
+        }
+    } else {
+        // nothing to generate...
+        ret = RNP_ERROR_BAD_PARAMETERS;
+        goto done;
+    }
+
+    ret = RNP_SUCCESS;
+done:
+    json_object_put(jso);
+    free(identifier_type);
+    free(identifier);
+    return ret;
+}
+FFI_GUARD
+
+typedef struct rnp_keygen_batch_item_t {
+    rnp_action_keygen_t desc{};
+    bool                has_sub{};
+    pgp_key_t           primary_sec;
+    pgp_key_t           primary_pub;
+    pgp_key_t           sub_sec;
+    pgp_key_t           sub_pub;
+    rnp_result_t        ret{};
+} rnp_keygen_batch_item_t;
+
+
+static rnp_result_t
+rnp_keygen_batch_parse(rnp_ffi_t ffi, const char *json, rnp_keygen_batch_item_t &item)
+{
+    if (!json) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    json_tokener_error error;
+    json_object *      jso = json_tokener_parse_verbose(json, &error);
+    if (!jso) {
+        FFI_LOG(ffi, "Invalid JSON: %s", json_tokener_error_desc(error));
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    json_object *jsoprimary = NULL;
+    json_object *jsosub = NULL;
+    rnp_result_t ret = gen_json_sections(ffi, jso, &jsoprimary, &jsosub);
+    if (ret) {
+        goto done;
+    }
+    /* subkey for the existing primary key requires unlocking of it, so is not allowed here */
+    if (!jsoprimary) {
+        FFI_LOG(ffi, "Only primary key or primary key with subkey may be generated in batch.");
+        ret = RNP_ERROR_BAD_PARAMETERS;
+        goto done;
+    }
+    if (!parse_keygen_primary(jsoprimary, &item.desc) ||
+        (jsosub && !parse_keygen_sub(jsosub, &item.desc))) {
+        ret = RNP_ERROR_BAD_PARAMETERS;
+        goto done;
+    }
+    item.has_sub = jsosub != NULL;
+    item.desc.primary.keygen.crypto.pool = ffi->keypool;
+    item.desc.subkey.keygen.crypto.pool = ffi->keypool;
+done:
+    json_object_put(jso);
+    return ret;
+}
+
+static void
+rnp_keygen_batch_generate(rnp_keygen_batch_item_t &item,
+                          rng_t *                  rng,
+                          pgp_key_store_format_t   format)
+{
+    if (!rng) {
+        item.ret = RNP_ERROR_RNG;
+        return;
+    }
+    try {
+        bool res = false;
+        if (item.has_sub) {
+            res = pgp_generate_keypair(rng,
+                                       &item.desc.primary.keygen,
+                                       &item.desc.subkey.keygen,
+                                       true,
+                                       &item.primary_sec,
+                                       &item.primary_pub,
+                                       &item.sub_sec,
+                                       &item.sub_pub,
+                                       format);
+        } else {
+            item.desc.primary.keygen.crypto.rng = rng;
+            res = pgp_generate_primary_key(
+              &item.desc.primary.keygen, true, &item.primary_sec, &item.primary_pub, format);
+        }
+        item.ret = res ? RNP_SUCCESS : RNP_ERROR_KEY_GENERATION;
+    } catch (const std::bad_alloc &) {
+        item.ret = RNP_ERROR_OUT_OF_MEMORY;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        item.ret = RNP_ERROR_GENERIC;
+    }
+    /* rng will be destroyed when workers are done */
+    item.desc.primary.keygen.crypto.rng = NULL;
+    item.desc.subkey.keygen.crypto.rng = NULL;
+}
+
+rnp_result_t
+rnp_generate_keys_json(rnp_ffi_t         ffi,
+                       const char **     jsons,
+                       size_t            count,
+                       size_t            threads,
+                       rnp_key_handle_t *keys,
+                       rnp_result_t *    results)
+try {
+    if (!ffi || !ffi->secring || !jsons || !results) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    if (keys) {
+        for (size_t i = 0; i < count; i++) {
+            keys[i] = NULL;
         }
-    } else {
-        // nothing to generate...
-        ret = RNP_ERROR_BAD_PARAMETERS;
-        goto done;
+    }
+    if (!count) {
+        return RNP_SUCCESS;
     }
 
-    ret = RNP_SUCCESS;
-done:
-    json_object_put(jso);
-    free(identifier_type);
-    free(identifier);
-    return ret;
+    std::vector<rnp_keygen_batch_item_t> items(count);
+    pgp_key_store_format_t               format = ffi->secring->format;
+    size_t                               jobs = 0;
+    for (size_t i = 0; i < count; i++) {
+        items[i].ret = rnp_keygen_batch_parse(ffi, jsons[i], items[i]);
+        jobs += !items[i].ret;
+    }
+
+    /* do not start more threads than there are valid descriptions */
+    threads = rnp_worker_count(threads, jobs);
+    rnp_worker_rngs_t rngs(threads);
+    rnp_run_workers(threads, count, [&](size_t idx, size_t worker) {
+        if (!items[idx].ret) {
+            /* do not initialize rng for the items which failed to parse */
+            rnp_keygen_batch_generate(items[idx], rngs.get(worker), format);
+        }
+    });
+
+    /* keys are protected and added to the keyrings in the order of specs */
+    for (size_t i = 0; i < count; i++) {
+        rnp_keygen_batch_item_t &item = items[i];
+        if (item.ret) {
+            results[i] = item.ret;
+            continue;
+        }
+        pgp_key_search_t locator = {PGP_KEY_SEARCH_FINGERPRINT};
+        locator.by.fingerprint = item.primary_pub.fp();
+        results[i] = gen_json_add_keys(ffi,
+                                       item.desc,
+                                       item.primary_sec,
+                                       item.primary_pub,
+                                       item.has_sub ? &item.sub_sec : NULL,
+                                       item.has_sub ? &item.sub_pub : NULL);
+        if (!results[i] && keys) {
+            results[i] = rnp_locate_key_int(ffi, locator, &keys[i]);
+        }
+    }
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
@@ -4970,6 +6341,7 @@ try {
     (*op)->primary = true;
     (*op)->crypto.key_alg = key_alg;
     (*op)->crypto.rng = &ffi->rng;
+    (*op)->crypto.pool = ffi->keypool;
     (*op)->cert.key_flags = default_key_flags(key_alg, false);
 
     return RNP_SUCCESS;
@@ -5014,6 +6386,7 @@ try {
     (*op)->primary = false;
     (*op)->crypto.key_alg = key_alg;
     (*op)->crypto.rng = &ffi->rng;
+    (*op)->crypto.pool = ffi->keypool;
     (*op)->binding.key_flags = default_key_flags(key_alg, true);
     (*op)->primary_sec = primary->sec;
     (*op)->primary_pub = primary->pub;
@@ -6742,6 +8115,8 @@ try {
     if (!key) {
         return RNP_ERROR_NO_SUITABLE_KEY;
     }
+    /* locked key must not be usable via the cached decrypted copy */
+    rnp_key_cache_flush(handle->ffi, key, false);
     if (!key->lock()) {
         return RNP_ERROR_GENERIC;
     }
@@ -7638,13 +9013,338 @@ done:
 }
 FFI_GUARD
 
-static rnp_result_t
-rnp_dump_src_to_json(pgp_source_t *src, uint32_t flags, char **result)
+rnp_result_t
+rnp_key_to_json_output(rnp_key_handle_t handle, rnp_output_t output, uint32_t flags)
+try {
+    if (!handle || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    json_object *jso = json_object_new_object();
+    if (!jso) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = key_to_json(jso, handle, flags);
+    if (ret) {
+        json_object_put(jso);
+        return ret;
+    }
+    /* write serialized JSON directly, without making a copy of it */
+    const char *str = json_object_to_json_string_ext(jso, JSON_C_TO_STRING_PRETTY);
+    if (str) {
+        dst_write(&output->dst, str, strlen(str));
+        ret = output->dst.werr;
+    } else {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+    }
+    json_object_put(jso);
+    output->keep = !ret;
+    return ret;
+}
+FFI_GUARD
+
+typedef enum rnp_key_field_t {
+    RNP_KEY_FIELD_FINGERPRINT,
+    RNP_KEY_FIELD_KEYID,
+    RNP_KEY_FIELD_GRIP,
+    RNP_KEY_FIELD_PRIMARY_GRIP,
+    RNP_KEY_FIELD_ALG,
+    RNP_KEY_FIELD_BITS,
+    RNP_KEY_FIELD_CURVE,
+    RNP_KEY_FIELD_CREATED,
+    RNP_KEY_FIELD_EXPIRATION,
+    RNP_KEY_FIELD_PRIMARY,
+    RNP_KEY_FIELD_SECRET,
+    RNP_KEY_FIELD_VALID,
+    RNP_KEY_FIELD_EXPIRED,
+    RNP_KEY_FIELD_REVOKED,
+    RNP_KEY_FIELD_UID,
+} rnp_key_field_t;
+
+static const pgp_map_t key_field_map[] = {
+  {RNP_KEY_FIELD_FINGERPRINT, "fingerprint"},
+  {RNP_KEY_FIELD_KEYID, "keyid"},
+  {RNP_KEY_FIELD_GRIP, "grip"},
+  {RNP_KEY_FIELD_PRIMARY_GRIP, "primary_grip"},
+  {RNP_KEY_FIELD_ALG, "alg"},
+  {RNP_KEY_FIELD_BITS, "bits"},
+  {RNP_KEY_FIELD_CURVE, "curve"},
+  {RNP_KEY_FIELD_CREATED, "created"},
+  {RNP_KEY_FIELD_EXPIRATION, "expiration"},
+  {RNP_KEY_FIELD_PRIMARY, "primary"},
+  {RNP_KEY_FIELD_SECRET, "secret"},
+  {RNP_KEY_FIELD_VALID, "valid"},
+  {RNP_KEY_FIELD_EXPIRED, "expired"},
+  {RNP_KEY_FIELD_REVOKED, "revoked"},
+  {RNP_KEY_FIELD_UID, "uid"},
+};
+
+static const char *
+key_field_name(int field)
 {
-    rnp_dump_ctx_t dumpctx = {};
-    json_object *  jso = NULL;
-    rnp_result_t   ret = RNP_ERROR_GENERIC;
+    const char *name = "unknown";
+    ARRAY_LOOKUP_BY_ID(key_field_map, type, string, field, name);
+    return name;
+}
+
+static bool
+parse_key_fields(const char *fields, std::vector<int> &res)
+{
+    if (!fields) {
+        for (size_t i = 0; i < ARRAY_SIZE(key_field_map); i++) {
+            res.push_back(key_field_map[i].type);
+        }
+        return true;
+    }
+    std::string        str(fields);
+    std::istringstream stream(str);
+    std::string        field;
+    while (std::getline(stream, field, ',')) {
+        int type = -1;
+        ARRAY_LOOKUP_BY_STRCASE(key_field_map, string, type, field.c_str(), type);
+        if (type < 0) {
+            RNP_LOG("Unknown key field: %s", field.c_str());
+            return false;
+        }
+        res.push_back(type);
+    }
+    return !res.empty();
+}
+
+static void
+key_list_add_hex(std::string &line, const uint8_t *data, size_t len)
+{
+    char hex[PGP_FINGERPRINT_SIZE * 2 + 1];
+    if ((len > PGP_FINGERPRINT_SIZE) || !rnp::hex_encode(data, len, hex, sizeof(hex))) {
+        return;
+    }
+    line.append(hex);
+}
+
+static void
+key_list_add_str(std::string &line, const char *str, bool json)
+{
+    /* in TSV output tab, newline, carriage return and backslash characters are escaped */
+    static const char hexchars[] = "0123456789abcdef";
+    for (; *str; str++) {
+        uint8_t ch = *str;
+        switch (ch) {
+        case '\\':
+            line.append("\\\\");
+            continue;
+        case '\t':
+            line.append("\\t");
+            continue;
+        case '\n':
+            line.append("\\n");
+            continue;
+        case '\r':
+            line.append("\\r");
+            continue;
+        case '"':
+            line.append(json ? "\\\"" : "\"");
+            continue;
+        default:
+            break;
+        }
+        if (json && (ch < 0x20)) {
+            line.append("\\u00");
+            line.push_back(hexchars[ch >> 4]);
+            line.push_back(hexchars[ch & 0xf]);
+            continue;
+        }
+        line.push_back(ch);
+    }
+}
+
+static void
+key_list_add_field(rnp_ffi_t ffi, pgp_key_t *key, int field, bool json, std::string &line)
+{
+    const char *str = NULL;
+    bool        flag = false;
+    switch (field) {
+    case RNP_KEY_FIELD_FINGERPRINT:
+        key_list_add_hex(line, key->fp().fingerprint, key->fp().length);
+        return;
+    case RNP_KEY_FIELD_KEYID:
+        key_list_add_hex(line, key->keyid().data(), key->keyid().size());
+        return;
+    case RNP_KEY_FIELD_GRIP:
+        key_list_add_hex(line, key->grip().data(), key->grip().size());
+        return;
+    case RNP_KEY_FIELD_PRIMARY_GRIP:
+        if (key->is_subkey() && key->has_primary_fp()) {
+            pgp_key_t *primary = rnp_key_store_get_key_by_fpr(ffi->pubring, key->primary_fp());
+            if (!primary) {
+                primary = rnp_key_store_get_key_by_fpr(ffi->secring, key->primary_fp());
+            }
+            if (primary) {
+                key_list_add_hex(line, primary->grip().data(), primary->grip().size());
+            }
+        }
+        return;
+    case RNP_KEY_FIELD_ALG:
+        ARRAY_LOOKUP_BY_ID(pubkey_alg_map, type, string, key->alg(), str);
+        break;
+    case RNP_KEY_FIELD_BITS:
+        line.append(std::to_string(key->material().bits()));
+        return;
+    case RNP_KEY_FIELD_CURVE:
+        if ((key->curve() != PGP_CURVE_UNKNOWN) && !curve_type_to_str(key->curve(), &str)) {
+            str = NULL;
+        }
+        break;
+    case RNP_KEY_FIELD_CREATED:
+        line.append(std::to_string(key->creation()));
+        return;
+    case RNP_KEY_FIELD_EXPIRATION:
+        line.append(std::to_string(key->expiration()));
+        return;
+    case RNP_KEY_FIELD_PRIMARY:
+        flag = key->is_primary();
+        break;
+    case RNP_KEY_FIELD_SECRET:
+        flag = key->is_secret() || rnp_key_store_get_key_by_fpr(ffi->secring, key->fp());
+        break;
+    case RNP_KEY_FIELD_VALID:
+        flag = key->valid();
+        break;
+    case RNP_KEY_FIELD_EXPIRED:
+        flag = key->expired();
+        break;
+    case RNP_KEY_FIELD_REVOKED:
+        flag = key->revoked();
+        break;
+    case RNP_KEY_FIELD_UID:
+        if (key->has_primary_uid()) {
+            str = key->get_uid(key->get_primary_uid()).str.c_str();
+            break;
+        }
+        for (size_t i = 0; i < key->uid_count(); i++) {
+            if (key->get_uid(i).valid) {
+                str = key->get_uid(i).str.c_str();
+                break;
+            }
+        }
+        break;
+    default:
+        return;
+    }
+
+    switch (field) {
+    case RNP_KEY_FIELD_ALG:
+    case RNP_KEY_FIELD_CURVE:
+    case RNP_KEY_FIELD_UID:
+        if (json) {
+            if (!str) {
+                line.append("null");
+                return;
+            }
+            line.push_back('"');
+            key_list_add_str(line, str, true);
+            line.push_back('"');
+        } else if (str) {
+            key_list_add_str(line, str, false);
+        }
+        return;
+    default:
+        line.append(json ? (flag ? "true" : "false") : (flag ? "1" : "0"));
+    }
+}
+
+static bool
+key_list_hex_field(int field)
+{
+    return (field == RNP_KEY_FIELD_FINGERPRINT) || (field == RNP_KEY_FIELD_KEYID) ||
+           (field == RNP_KEY_FIELD_GRIP) || (field == RNP_KEY_FIELD_PRIMARY_GRIP);
+}
+
+static void
+key_list_add_line(rnp_ffi_t               ffi,
+                  pgp_key_t *             key,
+                  const std::vector<int> &fields,
+                  bool                    json,
+                  std::string &           line)
+{
+    if (json) {
+        line.push_back('{');
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (i) {
+            line.push_back(json ? ',' : '\t');
+        }
+        if (json) {
+            line.push_back('"');
+            line.append(key_field_name(fields[i]));
+            line.append("\":");
+        }
+        size_t pos = line.size();
+        if (json && key_list_hex_field(fields[i])) {
+            line.push_back('"');
+        }
+        key_list_add_field(ffi, key, fields[i], json, line);
+        if (json && key_list_hex_field(fields[i])) {
+            /* empty hex value, i.e. primary grip of the primary key */
+            if (line.size() == pos + 1) {
+                line.resize(pos);
+                line.append("null");
+            } else {
+                line.push_back('"');
+            }
+        }
+    }
+    line.append(json ? "}\n" : "\n");
+}
+
+rnp_result_t
+rnp_key_list_to_output(rnp_ffi_t ffi, const char *fields, rnp_output_t output, uint32_t flags)
+try {
+    if (!ffi || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+    bool json = flags & RNP_KEY_LIST_JSON;
+    bool header = !(flags & RNP_KEY_LIST_NO_HEADER);
+    flags &= ~(RNP_KEY_LIST_JSON | RNP_KEY_LIST_NO_HEADER);
+    if (flags) {
+        FFI_LOG(ffi, "Invalid flags: %" PRIu32, flags);
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    std::vector<int> ids;
+    if (!parse_key_fields(fields, ids)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+
+    std::string line;
+    if (header && !json) {
+        for (size_t i = 0; i < ids.size(); i++) {
+            line.append(i ? "\t" : "");
+            line.append(key_field_name(ids[i]));
+        }
+        line.push_back('\n');
+        dst_write(&output->dst, line.data(), line.size());
+    }
+    /* public keys first, then secret keys which do not have public counterpart */
+    for (auto &key : ffi->pubring->keys) {
+        line.clear();
+        key_list_add_line(ffi, &key, ids, json, line);
+        dst_write(&output->dst, line.data(), line.size());
+    }
+    for (auto &key : ffi->secring->keys) {
+        if (rnp_key_store_get_key_by_fpr(ffi->pubring, key.fp())) {
+            continue;
+        }
+        line.clear();
+        key_list_add_line(ffi, &key, ids, json, line);
+        dst_write(&output->dst, line.data(), line.size());
+    }
+    rnp_result_t ret = output->dst.werr;
+    output->keep = !ret;
+    return ret;
+}
+FFI_GUARD
 
+static bool
+rnp_dump_json_flags(rnp_dump_ctx_t &dumpctx, uint32_t flags)
+{
     if (flags & RNP_JSON_DUMP_MPI) {
         dumpctx.dump_mpi = true;
         flags &= ~RNP_JSON_DUMP_MPI;
@@ -7657,7 +9357,17 @@ rnp_dump_src_to_json(pgp_source_t *src, uint32_t flags, char **result)
         dumpctx.dump_grips = true;
         flags &= ~RNP_JSON_DUMP_GRIP;
     }
-    if (flags) {
+    return !flags;
+}
+
+static rnp_result_t
+rnp_dump_src_to_json(pgp_source_t *src, uint32_t flags, char **result)
+{
+    rnp_dump_ctx_t dumpctx = {};
+    json_object *  jso = NULL;
+    rnp_result_t   ret = RNP_ERROR_GENERIC;
+
+    if (!rnp_dump_json_flags(dumpctx, flags)) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
@@ -7733,6 +9443,23 @@ try {
 }
 FFI_GUARD
 
+rnp_result_t
+rnp_dump_packets_to_json_output(rnp_input_t input, rnp_output_t output, uint32_t flags)
+try {
+    if (!input || !output) {
+        return RNP_ERROR_NULL_POINTER;
+    }
+
+    rnp_dump_ctx_t dumpctx = {};
+    if (!rnp_dump_json_flags(dumpctx, flags)) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    rnp_result_t ret = stream_dump_packets_json(&dumpctx, &input->src, &output->dst);
+    output->keep = true;
+    return ret;
+}
+FFI_GUARD
+
 rnp_result_t
 rnp_dump_packets_to_output(rnp_input_t input, rnp_output_t output, uint32_t flags)
 try {
@@ -7857,6 +9584,37 @@ key_iter_first_item(rnp_identifier_iterator_t it)
     return true;
 }
 
+// check whether identifier of the current item was already returned
+static bool
+key_iter_seen(rnp_identifier_iterator_t it)
+{
+    const pgp_key_t *key = &**it->keyp;
+    // secret key with public counterpart has the same key identifiers
+    if ((it->type != PGP_KEY_SEARCH_USERID) && (it->store == it->ffi->secring) &&
+        rnp_key_store_get_key_by_fpr(it->ffi->pubring, key->fp())) {
+        return true;
+    }
+    std::string id;
+    switch (it->type) {
+    case PGP_KEY_SEARCH_KEYID:
+        id.assign((const char *) key->keyid().data(), key->keyid().size());
+        break;
+    case PGP_KEY_SEARCH_FINGERPRINT:
+        // fingerprints are unique within the key store
+        return false;
+    case PGP_KEY_SEARCH_GRIP:
+        id.assign((const char *) key->grip().data(), key->grip().size());
+        break;
+    case PGP_KEY_SEARCH_USERID:
+        id = key->get_uid(it->uididx).str;
+        break;
+    default:
+        assert(false);
+        break;
+    }
+    return !it->tbl.insert(std::move(id)).second;
+}
+
 static bool
 key_iter_get_item(const rnp_identifier_iterator_t it, char *buf, size_t buf_len)
 {
@@ -7900,49 +9658,30 @@ rnp_identifier_iterator_create(rnp_ffi_t                  ffi,
                                rnp_identifier_iterator_t *it,
                                const char *               identifier_type)
 try {
-    rnp_result_t                       ret = RNP_ERROR_GENERIC;
-    struct rnp_identifier_iterator_st *obj = NULL;
-
     // checks
     if (!ffi || !it || !identifier_type) {
         return RNP_ERROR_NULL_POINTER;
     }
-    // create iterator
-    obj = (struct rnp_identifier_iterator_st *) calloc(1, sizeof(*obj));
-    if (!obj) {
-        return RNP_ERROR_OUT_OF_MEMORY;
-    }
-    obj->ffi = ffi;
     // parse identifier type
-    obj->type = PGP_KEY_SEARCH_UNKNOWN;
-    ARRAY_LOOKUP_BY_STRCASE(identifier_type_map, string, type, identifier_type, obj->type);
-    if (obj->type == PGP_KEY_SEARCH_UNKNOWN) {
-        ret = RNP_ERROR_BAD_PARAMETERS;
-        goto done;
-    }
-    obj->tbl = json_object_new_object();
-    if (!obj->tbl) {
-        ret = RNP_ERROR_OUT_OF_MEMORY;
-        goto done;
+    pgp_key_search_type_t type = PGP_KEY_SEARCH_UNKNOWN;
+    ARRAY_LOOKUP_BY_STRCASE(identifier_type_map, string, type, identifier_type, type);
+    if (type == PGP_KEY_SEARCH_UNKNOWN) {
+        return RNP_ERROR_BAD_PARAMETERS;
     }
+    // create iterator
+    struct rnp_identifier_iterator_st *obj = new rnp_identifier_iterator_st();
+    obj->ffi = ffi;
+    obj->type = type;
     // move to first item (if any)
     key_iter_first_item(obj);
     *it = obj;
-
-    ret = RNP_SUCCESS;
-done:
-    if (ret) {
-        rnp_identifier_iterator_destroy(obj);
-    }
-    return ret;
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
 rnp_result_t
 rnp_identifier_iterator_next(rnp_identifier_iterator_t it, const char **identifier)
 try {
-    rnp_result_t ret = RNP_ERROR_GENERIC;
-
     // checks
     if (!it || !identifier) {
         return RNP_ERROR_NULL_POINTER;
@@ -7953,42 +9692,20 @@ try {
     if (!it->store) {
         return RNP_SUCCESS;
     }
+    // skip already returned identifiers, without formatting them
+    while (key_iter_seen(it)) {
+        if (!key_iter_next_item(it)) {
+            return RNP_SUCCESS;
+        }
+    }
     // get the item
     if (!key_iter_get_item(it, it->buf, sizeof(it->buf))) {
         return RNP_ERROR_GENERIC;
     }
-    bool exists;
-    bool iterator_valid = true;
-    while ((exists = json_object_object_get_ex(it->tbl, it->buf, NULL))) {
-        if (!((iterator_valid = key_iter_next_item(it)))) {
-            break;
-        }
-        if (!key_iter_get_item(it, it->buf, sizeof(it->buf))) {
-            return RNP_ERROR_GENERIC;
-        }
-    }
-    // see if we actually found a new entry
-    if (!exists) {
-        // TODO: Newer json-c has a useful return value for json_object_object_add,
-        // which doesn't require the json_object_object_get_ex check below.
-        json_object_object_add(it->tbl, it->buf, NULL);
-        if (!json_object_object_get_ex(it->tbl, it->buf, NULL)) {
-            ret = RNP_ERROR_OUT_OF_MEMORY;
-            goto done;
-        }
-        *identifier = it->buf;
-    }
+    *identifier = it->buf;
     // prepare for the next one
-    if (iterator_valid) {
-        key_iter_next_item(it);
-    }
-    ret = RNP_SUCCESS;
-
-done:
-    if (ret) {
-        *identifier = NULL;
-    }
-    return ret;
+    key_iter_next_item(it);
+    return RNP_SUCCESS;
 }
 FFI_GUARD
 
@@ -7996,11 +9713,10 @@ rnp_result_t
 rnp_identifier_iterator_destroy(rnp_identifier_iterator_t it)
 try {
     if (it) {
-        json_object_put(it->tbl);
         if (it->keyp) {
             delete it->keyp;
         }
-        free(it);
+        delete it;
     }
     return RNP_SUCCESS;
 }
@@ -389,6 +389,8 @@ struct rnp_keygen_elgamal_params_t {
     size_t key_bitlen;
 };
 
+typedef struct pgp_key_pool_t pgp_key_pool_t;
+
 /* structure used to hold context of key generation */
 typedef struct rnp_keygen_crypto_params_t {
     // Asymmteric algorithm that user requesed key for
@@ -397,6 +399,8 @@ typedef struct rnp_keygen_crypto_params_t {
     pgp_hash_alg_t hash_alg;
     // Pointer to initialized RNG engine
     rng_t *rng;
+    // Pool of pre-generated key material, may be NULL
+    pgp_key_pool_t *pool;
     union {
         struct rnp_keygen_ecc_params_t     ecc;
         struct rnp_keygen_rsa_params_t     rsa;
@@ -0,0 +1,170 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include "workers.h"
+#include "logging.h"
+
+size_t
+rnp_worker_count(size_t threads, size_t count)
+{
+    size_t cpus = std::max(std::thread::hardware_concurrency(), 1U);
+    if (!threads) {
+        threads = cpus;
+    }
+    threads = std::min(threads, cpus * RNP_WORKERS_PER_CPU);
+    return std::max(std::min(threads, count), (size_t) 1);
+}
+
+void
+rnp_run_workers(size_t                                     threads,
+                size_t                                     count,
+                const std::function<void(size_t, size_t)> &fn)
+{
+    std::atomic<size_t> next(0);
+    auto                worker = [&](size_t id) {
+        size_t idx;
+        while ((idx = next++) < count) {
+            try {
+                fn(idx, id);
+            } catch (const std::exception &e) {
+                RNP_LOG("%s", e.what());
+            }
+        }
+    };
+
+    threads = rnp_worker_count(threads, count);
+    std::vector<std::thread> workers;
+    try {
+        /* so emplace_back() would not reallocate and may throw only on the thread start */
+        workers.reserve(threads - 1);
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back(worker, i);
+        }
+    } catch (const std::exception &e) {
+        /* not critical: remaining work is done by the threads which were started */
+        RNP_LOG("Failed to start worker thread: %s", e.what());
+    }
+    worker(0);
+    for (auto &thread : workers) {
+        thread.join();
+    }
+}
+
+rnp_worker_pool_t::rnp_worker_pool_t(size_t threads)
+{
+    threads = rnp_worker_count(threads, SIZE_MAX);
+    try {
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            threads_.emplace_back(&rnp_worker_pool_t::run, this);
+        }
+    } catch (const std::exception &e) {
+        /* not critical: tasks are processed by the threads which were started */
+        RNP_LOG("Failed to start worker thread: %s", e.what());
+    }
+}
+
+rnp_worker_pool_t::~rnp_worker_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void
+rnp_worker_pool_t::run()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(lock_);
+            cond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        try {
+            task();
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+        }
+    }
+}
+
+size_t
+rnp_worker_pool_t::size() const
+{
+    return threads_.size();
+}
+
+void
+rnp_worker_pool_t::submit(std::function<void()> task)
+{
+    if (threads_.empty()) {
+        try {
+            task();
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+rnp_worker_rngs_t::~rnp_worker_rngs_t()
+{
+    for (size_t i = 0; i < rngs_.size(); i++) {
+        if (state_[i] > 0) {
+            rng_destroy(&rngs_[i]);
+        }
+    }
+}
+
+rng_t *
+rnp_worker_rngs_t::get(size_t worker)
+{
+    if (!state_[worker]) {
+        rngs_[worker] = {};
+        state_[worker] = rng_init(&rngs_[worker], RNG_DRBG) ? 1 : -1;
+    }
+    return state_[worker] > 0 ? &rngs_[worker] : NULL;
+}
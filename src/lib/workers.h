@@ -0,0 +1,114 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RNP_WORKERS_H
+#define RNP_WORKERS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "crypto/rng.h"
+
+/* upper limit of the worker threads, as multiple of the hardware threads */
+#define RNP_WORKERS_PER_CPU 4
+
+/** @brief get the number of threads, which would be used by rnp_run_workers().
+ *  @param threads requested number of threads, 0 means number of the hardware threads.
+ *                 Value is limited to RNP_WORKERS_PER_CPU times the hardware threads.
+ *  @param count number of items to process, there would be no more threads than items.
+ *  @return number of threads, at least 1.
+ */
+size_t rnp_worker_count(size_t threads, size_t count);
+
+/** @brief process items on the worker threads, calling thread is used as a worker as well.
+ *         If some of the threads fail to start then the rest of the work is done by the
+ *         already started ones. All threads are joined before return.
+ *  @param threads requested number of threads, see rnp_worker_count().
+ *  @param count number of items.
+ *  @param fn function, called for each item index in [0, count) concurrently. Second
+ *            parameter is the worker index in [0, rnp_worker_count()), so per-thread state
+ *            may be kept in the array. Exceptions are caught and logged, leaving the item as
+ *            is, so fn should handle them itself if result must be reported.
+ */
+void rnp_run_workers(size_t                                     threads,
+                     size_t                                     count,
+                     const std::function<void(size_t, size_t)> &fn);
+
+/** Fixed set of the worker threads, processing tasks in the order of submission. Used when
+ *  tasks are produced one by one, so a thread is not started for each of them.
+ */
+typedef struct rnp_worker_pool_t {
+  private:
+    std::mutex                        lock_;
+    std::condition_variable           cond_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread>          threads_;
+    bool                              stop_{};
+
+    void run();
+
+  public:
+    /** @brief start the worker threads.
+     *  @param threads requested number of threads, see rnp_worker_count(). If some of the
+     *                 threads fail to start then pool works with the already started ones.
+     */
+    rnp_worker_pool_t(size_t threads);
+    rnp_worker_pool_t(const rnp_worker_pool_t &) = delete;
+    /** @brief wait until all the submitted tasks are processed and join the threads. */
+    ~rnp_worker_pool_t();
+
+    /** @brief number of the running worker threads. */
+    size_t size() const;
+    /** @brief queue the task. If there are no worker threads then it is executed on the
+     *         calling thread. Exceptions thrown by the task are caught and logged.
+     */
+    void submit(std::function<void()> task);
+} rnp_worker_pool_t;
+
+/** Random generators of the worker threads, since rng_t may not be shared between threads.
+ *  Each generator is initialized on the first use.
+ */
+typedef struct rnp_worker_rngs_t {
+  private:
+    std::vector<rng_t> rngs_;
+    std::vector<int>   state_; /* 0 - not initialized, 1 - initialized, -1 - failed */
+
+  public:
+    rnp_worker_rngs_t(size_t workers) : rngs_(workers), state_(workers){};
+    rnp_worker_rngs_t(const rnp_worker_rngs_t &) = delete;
+    ~rnp_worker_rngs_t();
+
+    /** @brief get generator of the worker, must be called only from that worker's thread.
+     *  @return pointer to the generator or NULL if it failed to initialize.
+     */
+    rng_t *get(size_t worker);
+} rnp_worker_rngs_t;
+
+#endif
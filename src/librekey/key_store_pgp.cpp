@@ -66,6 +66,10 @@ __RCSID("$NetBSD: keyring.c,v 1.50 2011/06/25 00:37:44 agc Exp $");
 #include "types.h"
 #include "key_store_pgp.h"
 #include "pgp-key.h"
+#include <algorithm>
+
+/* number of keys which are created and validated at once during the loading */
+#define PGP_KEY_LOAD_BATCH 1024
 
 bool
 rnp_key_store_add_transferable_subkey(rnp_key_store_t *          keyring,
@@ -85,24 +89,44 @@ rnp_key_store_add_transferable_subkey(rnp_key_store_t *          keyring,
     }
 }
 
-bool
-rnp_key_store_add_transferable_key(rnp_key_store_t *keyring, pgp_transferable_key_t *tkey)
-{
-    pgp_key_t *addkey = NULL;
+/* primary key with subkeys, created from the transferable key */
+typedef struct pgp_loaded_key_t {
+    pgp_key_t              key;
+    std::vector<pgp_key_t> subkeys;
+} pgp_loaded_key_t;
 
-    /* create key from transferable key */
+static bool
+rnp_key_store_create_key(pgp_loaded_key_t &loaded, pgp_transferable_key_t &tkey)
+{
     try {
-        pgp_key_t key(*tkey);
-        /* temporary disable key validation */
-        keyring->disable_validation = true;
-        /* add key to the storage before subkeys */
-        addkey = rnp_key_store_add_key(keyring, &key);
+        loaded.key = pgp_key_t(tkey);
     } catch (const std::exception &e) {
-        keyring->disable_validation = false;
-        RNP_LOG_KEY_PKT("failed to add key %s", tkey->key);
+        RNP_LOG("%s", e.what());
+        RNP_LOG_KEY_PKT("failed to create key %s", tkey.key);
         return false;
     }
+    for (auto &subkey : tkey.subkeys) {
+        try {
+            loaded.subkeys.emplace_back(subkey, &loaded.key);
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+            RNP_LOG_KEY_PKT("failed to create subkey %s", subkey.subkey);
+            RNP_LOG_KEY("primary key is %s", (&loaded.key));
+            return false;
+        }
+    }
+    return true;
+}
 
+static bool
+rnp_key_store_add_loaded_key(rnp_key_store_t *keyring, pgp_loaded_key_t &loaded)
+{
+    pgp_key_t *addkey = NULL;
+
+    /* temporary disable key validation */
+    keyring->disable_validation = true;
+    /* add key to the storage before subkeys */
+    addkey = rnp_key_store_add_key(keyring, &loaded.key);
     if (!addkey) {
         keyring->disable_validation = false;
         RNP_LOG("Failed to add key to key store.");
@@ -110,8 +134,8 @@ rnp_key_store_add_transferable_key(rnp_key_store_t *keyring, pgp_transferable_ke
     }
 
     /* add subkeys */
-    for (auto &subkey : tkey->subkeys) {
-        if (!rnp_key_store_add_transferable_subkey(keyring, &subkey, addkey)) {
+    for (auto &subkey : loaded.subkeys) {
+        if (!rnp_key_store_add_key(keyring, &subkey)) {
             RNP_LOG("Failed to add subkey to key store.");
             keyring->disable_validation = false;
             goto error;
@@ -128,6 +152,59 @@ error:
     return false;
 }
 
+bool
+rnp_key_store_add_transferable_key(rnp_key_store_t *keyring, pgp_transferable_key_t *tkey)
+{
+    try {
+        pgp_loaded_key_t loaded;
+        if (!rnp_key_store_create_key(loaded, *tkey)) {
+            return false;
+        }
+        return rnp_key_store_add_loaded_key(keyring, loaded);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        RNP_LOG_KEY_PKT("failed to add key %s", tkey->key);
+        return false;
+    }
+}
+
+/* Create keys from the sequence and validate their self-signatures at once, so it may be done
+ * on the several threads, and then add them to the keyring */
+static rnp_result_t
+rnp_key_store_add_key_sequence(rnp_key_store_t *keyring, pgp_key_sequence_t &keys)
+{
+    pgp_sig_batch_t batch;
+
+    for (size_t start = 0; start < keys.keys.size(); start += PGP_KEY_LOAD_BATCH) {
+        size_t count = std::min(keys.keys.size() - start, (size_t) PGP_KEY_LOAD_BATCH);
+
+        std::vector<pgp_loaded_key_t> loaded(count);
+        size_t                        created = 0;
+        for (; created < count; created++) {
+            pgp_loaded_key_t &key = loaded[created];
+            if (!rnp_key_store_create_key(key, keys.keys[start + created])) {
+                break;
+            }
+            key.key.add_self_signatures(batch);
+            for (auto &subkey : key.subkeys) {
+                subkey.add_self_signatures(batch, key.key);
+            }
+        }
+        batch.validate(keyring->validation_threads);
+
+        /* keys before the failed one are added, as if they were processed one by one */
+        for (size_t i = 0; i < created; i++) {
+            if (!rnp_key_store_add_loaded_key(keyring, loaded[i])) {
+                return RNP_ERROR_BAD_STATE;
+            }
+        }
+        if (created < count) {
+            return RNP_ERROR_BAD_STATE;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
 rnp_key_store_pgp_read_key_from_src(rnp_key_store_t &keyring,
                                     pgp_source_t &   src,
@@ -179,12 +256,12 @@ rnp_key_store_pgp_read_from_src(rnp_key_store_t *keyring, pgp_source_t *src, boo
         return ret;
     }
 
-    for (auto &key : keys.keys) {
-        if (!rnp_key_store_add_transferable_key(keyring, &key)) {
-            return RNP_ERROR_BAD_STATE;
-        }
+    try {
+        return rnp_key_store_add_key_sequence(keyring, keys);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_BAD_STATE;
     }
-    return RNP_SUCCESS;
 }
 
 bool
@@ -48,6 +48,88 @@
 #include "types.h"
 #include "file-utils.h"
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+static uint64_t
+stream_stats_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static pgp_stream_counter_t *
+src_counter(pgp_source_t *src)
+{
+    if (!src->stats || (src->type < 0) || (src->type >= PGP_STREAM_TYPE_COUNT)) {
+        return NULL;
+    }
+    return &src->stats->src[src->type];
+}
+
+static pgp_stream_counter_t *
+dst_counter(pgp_dest_t *dst)
+{
+    if (!dst->stats || (dst->type < 0) || (dst->type >= PGP_STREAM_TYPE_COUNT)) {
+        return NULL;
+    }
+    return &dst->stats->dst[dst->type];
+}
+
+/* call the source's read callback, updating counters if they are enabled */
+static bool
+src_call_read(pgp_source_t *src, void *buf, size_t len, size_t *read)
+{
+    pgp_stream_counter_t *cnt = src_counter(src);
+    if (!cnt) {
+        return src->read(src, buf, len, read);
+    }
+    uint64_t start = stream_stats_now();
+    bool     res = src->read(src, buf, len, read);
+    cnt->ns += stream_stats_now() - start;
+    cnt->calls++;
+    if (res) {
+        cnt->bytes += *read;
+    }
+    return res;
+}
+
+static void
+src_count_copied(pgp_source_t *src, size_t len)
+{
+    pgp_stream_counter_t *cnt = src_counter(src);
+    if (cnt) {
+        cnt->copied += len;
+    }
+}
+
+static void
+dst_count_copied(pgp_dest_t *dst, size_t len)
+{
+    pgp_stream_counter_t *cnt = dst_counter(dst);
+    if (cnt) {
+        cnt->copied += len;
+    }
+}
+
+/* call the dest's write callback, updating counters if they are enabled */
+static rnp_result_t
+dst_call_write(pgp_dest_t *dst, const void *buf, size_t len)
+{
+    pgp_stream_counter_t *cnt = dst_counter(dst);
+    if (!cnt) {
+        return dst->write(dst, buf, len);
+    }
+    uint64_t     start = stream_stats_now();
+    rnp_result_t res = dst->write(dst, buf, len);
+    cnt->ns += stream_stats_now() - start;
+    cnt->calls++;
+    cnt->bytes += len;
+    return res;
+}
 
 bool
 src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
@@ -78,10 +160,12 @@ src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         read = cache->len - cache->pos;
         if (read >= len) {
             memcpy(buf, &cache->buf[cache->pos], len);
+            src_count_copied(src, len);
             cache->pos += len;
             goto finish;
         } else {
             memcpy(buf, &cache->buf[cache->pos], read);
+            src_count_copied(src, read);
             cache->pos += read;
             buf = (uint8_t *) buf + read;
             left = len - read;
@@ -92,7 +176,7 @@ src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
     while (left > 0) {
         if (left > sizeof(cache->buf) || !readahead || !cache) {
             // If there is no cache or chunk is larger then read directly
-            if (!src->read(src, buf, left, &read)) {
+            if (!src_call_read(src, buf, left, &read)) {
                 src->error = 1;
                 return false;
             }
@@ -105,7 +189,7 @@ src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
             buf = (uint8_t *) buf + read;
         } else {
             // Try to fill the cache to avoid small reads
-            if (!src->read(src, &cache->buf[0], sizeof(cache->buf), &read)) {
+            if (!src_call_read(src, &cache->buf[0], sizeof(cache->buf), &read)) {
                 src->error = 1;
                 return false;
             }
@@ -115,10 +199,12 @@ src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
                 goto finish;
             } else if (read < left) {
                 memcpy(buf, &cache->buf[0], read);
+                src_count_copied(src, read);
                 left -= read;
                 buf = (uint8_t *) buf + read;
             } else {
                 memcpy(buf, &cache->buf[0], left);
+                src_count_copied(src, left);
                 cache->pos = left;
                 cache->len = read;
                 goto finish;
@@ -184,7 +270,7 @@ src_peek(pgp_source_t *src, void *buf, size_t len, size_t *peeked)
         if (src->knownsize && (src->readb + read > src->size)) {
             read = src->size - src->readb;
         }
-        if (!src->read(src, &cache->buf[cache->len], read, &read)) {
+        if (!src_call_read(src, &cache->buf[cache->len], read, &read)) {
             src->error = 1;
             return false;
         }
@@ -214,6 +300,25 @@ src_peek_eq(pgp_source_t *src, void *buf, size_t len)
     return src_peek(src, buf, len, &res) && (res == len);
 }
 
+bool
+src_seek(pgp_source_t *src, uint64_t offset)
+{
+    if (!src->seek || src->error || (src->knownsize && (offset > src->size))) {
+        return false;
+    }
+    if (!src->seek(src, offset)) {
+        src->error = 1;
+        return false;
+    }
+    if (src->cache) {
+        src->cache->pos = 0;
+        src->cache->len = 0;
+    }
+    src->readb = offset;
+    src->eof = 0;
+    return true;
+}
+
 void
 src_skip(pgp_source_t *src, size_t len)
 {
@@ -250,7 +355,12 @@ src_finish(pgp_source_t *src)
 {
     rnp_result_t res = RNP_SUCCESS;
     if (src->finish) {
+        pgp_stream_counter_t *cnt = src_counter(src);
+        uint64_t              start = cnt ? stream_stats_now() : 0;
         res = src->finish(src);
+        if (cnt) {
+            cnt->ns += stream_stats_now() - start;
+        }
     }
 
     return res;
@@ -325,16 +435,20 @@ src_peek_line(pgp_source_t *src, char *buf, size_t len, size_t *readres)
         }
 
         /* we continue scanning where we stopped previously */
-        for (; scan_pos < *readres; scan_pos++) {
-            if (buf[scan_pos] == '\n') {
-                if ((scan_pos > 0) && (buf[scan_pos - 1] == '\r')) {
-                    scan_pos--;
-                }
-                buf[scan_pos] = '\0';
-                *readres = scan_pos;
-                return true;
+        char *eol = NULL;
+        if (scan_pos < *readres) {
+            eol = (char *) memchr(buf + scan_pos, '\n', *readres - scan_pos);
+        }
+        if (eol) {
+            scan_pos = eol - buf;
+            if ((scan_pos > 0) && (buf[scan_pos - 1] == '\r')) {
+                scan_pos--;
             }
+            buf[scan_pos] = '\0';
+            *readres = scan_pos;
+            return true;
         }
+        scan_pos = *readres;
         if (*readres < to_peek) {
             return false;
         }
@@ -365,8 +479,215 @@ init_src_common(pgp_source_t *src, size_t paramsize)
     return true;
 }
 
+/* Background reader or writer of the file descriptor. Blocks are passed between the stream
+ * and the I/O thread via ring buffer, so file I/O overlaps with the data processing. */
+typedef struct pgp_file_io_t {
+    std::thread             thread;
+    std::mutex              lock;
+    std::condition_variable cond;
+    uint8_t                 blocks[PGP_FILE_IO_BLOCKS][PGP_FILE_IO_BLOCK_SIZE];
+    size_t                  lens[PGP_FILE_IO_BLOCKS];
+    size_t                  head;  /* block which is processed by the consumer */
+    size_t                  ready; /* number of blocks, ready for the consumer */
+    size_t                  pos;   /* position within the block, used by the stream */
+    int                     fd;
+    int                     errcode;
+    bool                    eof;
+    bool                    stop;
+} pgp_file_io_t;
+
+static void
+file_io_read_thread(pgp_file_io_t *io)
+{
+    std::unique_lock<std::mutex> lock(io->lock);
+    while (!io->stop && !io->eof && !io->errcode) {
+        if (io->ready == PGP_FILE_IO_BLOCKS) {
+            io->cond.wait(lock);
+            continue;
+        }
+        /* block is not accessed by the stream until it is marked as ready */
+        size_t idx = (io->head + io->ready) % PGP_FILE_IO_BLOCKS;
+        lock.unlock();
+        int64_t res = read(io->fd, io->blocks[idx], PGP_FILE_IO_BLOCK_SIZE);
+        int     err = errno;
+        lock.lock();
+        if (res < 0) {
+            io->errcode = err;
+        } else if (!res) {
+            io->eof = true;
+        } else {
+            io->lens[idx] = res;
+            io->ready++;
+        }
+        io->cond.notify_all();
+    }
+}
+
+static void
+file_io_write_thread(pgp_file_io_t *io)
+{
+    std::unique_lock<std::mutex> lock(io->lock);
+    while (!io->errcode) {
+        if (!io->ready) {
+            if (io->stop) {
+                break;
+            }
+            io->cond.wait(lock);
+            continue;
+        }
+        size_t idx = io->head;
+        lock.unlock();
+        size_t written = 0;
+        int    err = 0;
+        while (written < io->lens[idx]) {
+            int64_t res = write(io->fd, io->blocks[idx] + written, io->lens[idx] - written);
+            if (res < 0) {
+                err = errno;
+                break;
+            }
+            written += res;
+        }
+        lock.lock();
+        if (err) {
+            io->errcode = err;
+            RNP_LOG("write failed, error %d", err);
+        } else {
+            io->head = (io->head + 1) % PGP_FILE_IO_BLOCKS;
+            io->ready--;
+        }
+        io->cond.notify_all();
+    }
+}
+
+static void
+file_io_start(pgp_file_io_t *io, bool write)
+{
+    io->head = 0;
+    io->ready = 0;
+    io->pos = 0;
+    io->eof = false;
+    io->stop = false;
+    io->thread = std::thread(write ? file_io_write_thread : file_io_read_thread, io);
+}
+
+static void
+file_io_stop(pgp_file_io_t *io)
+{
+    {
+        std::lock_guard<std::mutex> lock(io->lock);
+        io->stop = true;
+    }
+    io->cond.notify_all();
+    if (io->thread.joinable()) {
+        io->thread.join();
+    }
+}
+
+static pgp_file_io_t *
+file_io_create(int fd, bool write)
+{
+    pgp_file_io_t *io = NULL;
+    try {
+        io = new pgp_file_io_t();
+        io->fd = fd;
+        file_io_start(io, write);
+        return io;
+    } catch (const std::exception &e) {
+        RNP_LOG("failed to start I/O thread: %s", e.what());
+        delete io;
+        return NULL;
+    }
+}
+
+static void
+file_io_destroy(pgp_file_io_t *io)
+{
+    if (io) {
+        file_io_stop(io);
+        delete io;
+    }
+}
+
+static bool
+file_io_read(pgp_file_io_t *io, uint8_t *buf, size_t len, size_t *readres)
+{
+    std::unique_lock<std::mutex> lock(io->lock);
+    while (!io->ready && !io->eof && !io->errcode) {
+        io->cond.wait(lock);
+    }
+    if (!io->ready && io->errcode) {
+        RNP_LOG("read failed, error %d", io->errcode);
+        return false;
+    }
+
+    *readres = 0;
+    while (io->ready && (*readres < len)) {
+        size_t idx = io->head;
+        size_t avail = std::min(len - *readres, io->lens[idx] - io->pos);
+        memcpy(buf + *readres, io->blocks[idx] + io->pos, avail);
+        *readres += avail;
+        io->pos += avail;
+        if (io->pos == io->lens[idx]) {
+            /* return block to the reader thread */
+            io->head = (io->head + 1) % PGP_FILE_IO_BLOCKS;
+            io->ready--;
+            io->pos = 0;
+            io->cond.notify_all();
+        }
+    }
+    return true;
+}
+
+static rnp_result_t
+file_io_write(pgp_file_io_t *io, const uint8_t *buf, size_t len)
+{
+    std::unique_lock<std::mutex> lock(io->lock);
+    while (len) {
+        while ((io->ready == PGP_FILE_IO_BLOCKS) && !io->errcode) {
+            io->cond.wait(lock);
+        }
+        if (io->errcode) {
+            return RNP_ERROR_WRITE;
+        }
+        /* block is not accessed by the writer thread until it is marked as ready */
+        size_t idx = (io->head + io->ready) % PGP_FILE_IO_BLOCKS;
+        size_t avail = std::min(len, PGP_FILE_IO_BLOCK_SIZE - io->pos);
+        lock.unlock();
+        memcpy(io->blocks[idx] + io->pos, buf, avail);
+        lock.lock();
+        io->pos += avail;
+        buf += avail;
+        len -= avail;
+        if (io->pos == PGP_FILE_IO_BLOCK_SIZE) {
+            io->lens[idx] = io->pos;
+            io->ready++;
+            io->pos = 0;
+            io->cond.notify_all();
+        }
+    }
+    return RNP_SUCCESS;
+}
+
+/* pass the partially filled block to the writer thread and wait until everything is written */
+static rnp_result_t
+file_io_flush(pgp_file_io_t *io)
+{
+    std::unique_lock<std::mutex> lock(io->lock);
+    if (io->pos && !io->errcode) {
+        io->lens[(io->head + io->ready) % PGP_FILE_IO_BLOCKS] = io->pos;
+        io->ready++;
+        io->pos = 0;
+        io->cond.notify_all();
+    }
+    while (io->ready && !io->errcode) {
+        io->cond.wait(lock);
+    }
+    return io->errcode ? RNP_ERROR_WRITE : RNP_SUCCESS;
+}
+
 typedef struct pgp_source_file_param_t {
-    int fd;
+    int            fd;
+    pgp_file_io_t *io; /* background reader, if read-ahead is enabled */
 } pgp_source_file_param_t;
 
 static bool
@@ -376,6 +697,9 @@ file_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
     if (!param) {
         return false;
     }
+    if (param->io) {
+        return file_io_read(param->io, (uint8_t *) buf, len, readres);
+    }
 
     int64_t rres = read(param->fd, buf, len);
     if (rres < 0) {
@@ -385,11 +709,35 @@ file_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
     return true;
 }
 
+static bool
+file_src_seek(pgp_source_t *src, uint64_t offset)
+{
+    pgp_source_file_param_t *param = (pgp_source_file_param_t *) src->param;
+    if (!param) {
+        return false;
+    }
+    if (!param->io) {
+        return lseek(param->fd, offset, SEEK_SET) == (off_t) offset;
+    }
+    /* background reader is restarted from the new position */
+    file_io_stop(param->io);
+    param->io->errcode = 0;
+    bool res = lseek(param->fd, offset, SEEK_SET) == (off_t) offset;
+    try {
+        file_io_start(param->io, false);
+    } catch (const std::exception &e) {
+        RNP_LOG("failed to restart I/O thread: %s", e.what());
+        return false;
+    }
+    return res;
+}
+
 static void
 file_src_close(pgp_source_t *src)
 {
     pgp_source_file_param_t *param = (pgp_source_file_param_t *) src->param;
     if (param) {
+        file_io_destroy(param->io);
         if (src->type == PGP_STREAM_FILE) {
             close(param->fd);
         }
@@ -409,6 +757,7 @@ init_fd_src(pgp_source_t *src, int fd, uint64_t *size)
     param->fd = fd;
     src->read = file_src_read;
     src->close = file_src_close;
+    src->seek = file_src_seek;
     src->type = PGP_STREAM_FILE;
     src->size = size ? *size : 0;
     src->knownsize = !!size;
@@ -417,7 +766,7 @@ init_fd_src(pgp_source_t *src, int fd, uint64_t *size)
 }
 
 rnp_result_t
-init_file_src(pgp_source_t *src, const char *path)
+init_file_src(pgp_source_t *src, const char *path, bool readahead)
 {
     int         fd;
     struct stat st;
@@ -451,8 +800,16 @@ init_file_src(pgp_source_t *src, const char *path)
     rnp_result_t ret = init_fd_src(src, fd, &size);
     if (ret) {
         close(fd);
+        return ret;
     }
-    return ret;
+    if (readahead) {
+        pgp_source_file_param_t *param = (pgp_source_file_param_t *) src->param;
+        if (!(param->io = file_io_create(fd, false))) {
+            src_close(src);
+            return RNP_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    return RNP_SUCCESS;
 }
 
 rnp_result_t
@@ -505,6 +862,17 @@ mem_src_read(pgp_source_t *src, void *buf, size_t len, size_t *read)
     return true;
 }
 
+static bool
+mem_src_seek(pgp_source_t *src, uint64_t offset)
+{
+    pgp_source_mem_param_t *param = (pgp_source_mem_param_t *) src->param;
+    if (!param || (offset > param->len)) {
+        return false;
+    }
+    param->pos = offset;
+    return true;
+}
+
 static void
 mem_src_close(pgp_source_t *src)
 {
@@ -536,6 +904,7 @@ init_mem_src(pgp_source_t *src, const void *mem, size_t len, bool free)
     param->free = free;
     src->read = mem_src_read;
     src->close = mem_src_close;
+    src->seek = mem_src_seek;
     src->finish = NULL;
     src->size = len;
     src->knownsize = 1;
@@ -641,9 +1010,10 @@ dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         /* if cache non-empty and len will overflow it then fill it and write out */
         if ((dst->clen > 0) && (dst->clen + len > sizeof(dst->cache))) {
             memcpy(dst->cache + dst->clen, buf, sizeof(dst->cache) - dst->clen);
+            dst_count_copied(dst, sizeof(dst->cache) - dst->clen);
             buf = (uint8_t *) buf + sizeof(dst->cache) - dst->clen;
             len -= sizeof(dst->cache) - dst->clen;
-            dst->werr = dst->write(dst, dst->cache, sizeof(dst->cache));
+            dst->werr = dst_call_write(dst, dst->cache, sizeof(dst->cache));
             dst->writeb += sizeof(dst->cache);
             dst->clen = 0;
             if (dst->werr != RNP_SUCCESS) {
@@ -653,12 +1023,13 @@ dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 
         /* here everything will fit into the cache or cache is empty */
         if (dst->no_cache || (len > sizeof(dst->cache))) {
-            dst->werr = dst->write(dst, buf, len);
+            dst->werr = dst_call_write(dst, buf, len);
             if (!dst->werr) {
                 dst->writeb += len;
             }
         } else {
             memcpy(dst->cache + dst->clen, buf, len);
+            dst_count_copied(dst, len);
             dst->clen += len;
         }
     }
@@ -686,7 +1057,7 @@ void
 dst_flush(pgp_dest_t *dst)
 {
     if ((dst->clen > 0) && (dst->write) && (dst->werr == RNP_SUCCESS)) {
-        dst->werr = dst->write(dst, dst->cache, dst->clen);
+        dst->werr = dst_call_write(dst, dst->cache, dst->clen);
         dst->writeb += dst->clen;
         dst->clen = 0;
     }
@@ -701,7 +1072,12 @@ dst_finish(pgp_dest_t *dst)
         /* flush write cache in the dst */
         dst_flush(dst);
         if (dst->finish) {
+            pgp_stream_counter_t *cnt = dst_counter(dst);
+            uint64_t              start = cnt ? stream_stats_now() : 0;
             res = dst->finish(dst);
+            if (cnt) {
+                cnt->ns += stream_stats_now() - start;
+            }
         }
         dst->finished = true;
     }
@@ -722,10 +1098,11 @@ dst_close(pgp_dest_t *dst, bool discard)
 }
 
 typedef struct pgp_dest_file_param_t {
-    int  fd;
-    int  errcode;
-    bool overwrite;
-    char path[PATH_MAX];
+    int            fd;
+    int            errcode;
+    bool           overwrite;
+    char           path[PATH_MAX];
+    pgp_file_io_t *io; /* background writer, if write-behind is enabled */
 } pgp_dest_file_param_t;
 
 static rnp_result_t
@@ -738,6 +1115,9 @@ file_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         RNP_LOG("wrong param");
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    if (param->io) {
+        return file_io_write(param->io, (const uint8_t *) buf, len);
+    }
 
     /* we assyme that blocking I/O is used so everything is written or error received */
     ret = write(param->fd, buf, len);
@@ -751,6 +1131,19 @@ file_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
     }
 }
 
+static rnp_result_t
+file_dst_finish(pgp_dest_t *dst)
+{
+    pgp_dest_file_param_t *param = (pgp_dest_file_param_t *) dst->param;
+    if (!param) {
+        return RNP_ERROR_BAD_PARAMETERS;
+    }
+    if (!param->io) {
+        return RNP_SUCCESS;
+    }
+    return file_io_flush(param->io);
+}
+
 static void
 file_dst_close(pgp_dest_t *dst, bool discard)
 {
@@ -760,6 +1153,7 @@ file_dst_close(pgp_dest_t *dst, bool discard)
         return;
     }
 
+    file_io_destroy(param->io);
     if (dst->type == PGP_STREAM_FILE) {
         close(param->fd);
         if (discard) {
@@ -788,14 +1182,26 @@ init_fd_dest(pgp_dest_t *dst, int fd, const char *path)
     param->fd = fd;
     memcpy(param->path, path, path_len + 1);
     dst->write = file_dst_write;
+    dst->finish = file_dst_finish;
     dst->close = file_dst_close;
     dst->type = PGP_STREAM_FILE;
 
     return RNP_SUCCESS;
 }
 
+static rnp_result_t
+file_dst_write_behind(pgp_dest_t *dst)
+{
+    pgp_dest_file_param_t *param = (pgp_dest_file_param_t *) dst->param;
+    if (!(param->io = file_io_create(param->fd, true))) {
+        dst_close(dst, true);
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    return RNP_SUCCESS;
+}
+
 rnp_result_t
-init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite)
+init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite, bool writebehind)
 {
     int                    fd;
     int                    flags;
@@ -843,8 +1249,12 @@ init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite)
     rnp_result_t res = init_fd_dest(dst, fd, path);
     if (res) {
         close(fd);
+        return res;
     }
-    return res;
+    if (!writebehind) {
+        return RNP_SUCCESS;
+    }
+    return file_dst_write_behind(dst);
 }
 
 #define TMPDST_SUFFIX ".rnp-tmp.XXXXXX"
@@ -860,6 +1270,14 @@ file_tmpdst_finish(pgp_dest_t *dst)
     if (!param) {
         return RNP_ERROR_BAD_PARAMETERS;
     }
+    if (param->io) {
+        rnp_result_t ret = file_io_flush(param->io);
+        file_io_destroy(param->io);
+        param->io = NULL;
+        if (ret) {
+            return ret;
+        }
+    }
 
     /* remove suffix so we have required path */
     plen = strnlen(param->path, sizeof(param->path));
@@ -909,6 +1327,7 @@ file_tmpdst_close(pgp_dest_t *dst, bool discard)
         return;
     }
 
+    file_io_destroy(param->io);
     /* we close file in finish function, except the case when some error occurred */
     if (!dst->finished && (dst->type == PGP_STREAM_FILE)) {
         close(param->fd);
@@ -922,7 +1341,7 @@ file_tmpdst_close(pgp_dest_t *dst, bool discard)
 }
 
 rnp_result_t
-init_tmpfile_dest(pgp_dest_t *dst, const char *path, bool overwrite)
+init_tmpfile_dest(pgp_dest_t *dst, const char *path, bool overwrite, bool writebehind)
 {
     char                   tmp[PATH_MAX];
     pgp_dest_file_param_t *param = NULL;
@@ -953,7 +1372,10 @@ init_tmpfile_dest(pgp_dest_t *dst, const char *path, bool overwrite)
     param->overwrite = overwrite;
     dst->finish = file_tmpdst_finish;
     dst->close = file_tmpdst_close;
-    return RNP_SUCCESS;
+    if (!writebehind) {
+        return RNP_SUCCESS;
+    }
+    return file_dst_write_behind(dst);
 }
 
 rnp_result_t
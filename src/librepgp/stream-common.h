@@ -35,6 +35,10 @@
 #define PGP_INPUT_CACHE_SIZE 32768
 #define PGP_OUTPUT_CACHE_SIZE 32768
 
+/* size and number of the blocks, passed between file stream and background I/O thread */
+#define PGP_FILE_IO_BLOCK_SIZE ((size_t) 262144)
+#define PGP_FILE_IO_BLOCKS 4
+
 #define PGP_PARTIAL_PKT_FIRST_PART_MIN_SIZE 512
 
 typedef enum {
@@ -53,12 +57,32 @@ typedef enum {
     PGP_STREAM_CLEARTEXT
 } pgp_stream_type_t;
 
+#define PGP_STREAM_TYPE_COUNT (PGP_STREAM_CLEARTEXT + 1)
+
 typedef struct pgp_source_t pgp_source_t;
 typedef struct pgp_dest_t   pgp_dest_t;
 
+/* counters of the single stream layer */
+typedef struct pgp_stream_counter_t {
+    uint64_t calls;  /* number of read/write callback calls */
+    uint64_t bytes;  /* number of bytes returned by read or passed to write callback */
+    uint64_t copied; /* number of bytes copied via the stream cache */
+    uint64_t ns;     /* time spent in callbacks, including the underlying layers */
+} pgp_stream_counter_t;
+
+/** Per-layer counters of the streams, accumulated over all streams of the same type.
+ *  Collected only for streams which have stats pointer set, i.e. when enabled by the user,
+ *  otherwise the only overhead is the pointer check.
+ */
+typedef struct pgp_stream_stats_t {
+    pgp_stream_counter_t src[PGP_STREAM_TYPE_COUNT];
+    pgp_stream_counter_t dst[PGP_STREAM_TYPE_COUNT];
+} pgp_stream_stats_t;
+
 typedef bool pgp_source_read_func_t(pgp_source_t *src, void *buf, size_t len, size_t *read);
 typedef rnp_result_t pgp_source_finish_func_t(pgp_source_t *src);
 typedef void         pgp_source_close_func_t(pgp_source_t *src);
+typedef bool         pgp_source_seek_func_t(pgp_source_t *src, uint64_t offset);
 
 typedef rnp_result_t pgp_dest_write_func_t(pgp_dest_t *dst, const void *buf, size_t len);
 typedef rnp_result_t pgp_dest_finish_func_t(pgp_dest_t *src);
@@ -76,6 +100,7 @@ typedef struct pgp_source_t {
     pgp_source_read_func_t *  read;
     pgp_source_finish_func_t *finish;
     pgp_source_close_func_t * close;
+    pgp_source_seek_func_t *  seek; /* may be NULL if source is not seekable */
     pgp_stream_type_t         type;
 
     uint64_t size;  /* size of the data if available, see knownsize */
@@ -83,6 +108,7 @@ typedef struct pgp_source_t {
                        number of bytes as returned via the read since data may be cached */
     pgp_source_cache_t *cache; /* cache if used */
     void *              param; /* source-specific additional data */
+    pgp_stream_stats_t *stats; /* counters to update, NULL if stats are not collected */
 
     unsigned eof : 1;       /* end of data as reported by read and empty cache */
     unsigned knownsize : 1; /* whether size of the data is known */
@@ -131,6 +157,14 @@ bool src_peek(pgp_source_t *src, void *buf, size_t len, size_t *read);
  *          read error occurred) */
 bool src_peek_eq(pgp_source_t *src, void *buf, size_t len);
 
+/** @brief set the absolute read position in the seekable source (i.e. file or memory).
+ *         Cached data is discarded, eof flag is reset.
+ *  @param src source structure
+ *  @param offset new position, from the beginning of the source
+ *  @return true on success or false if source is not seekable or offset is out of range
+ **/
+bool src_seek(pgp_source_t *src, uint64_t offset);
+
 /** @brief skip up to len bytes.
  *         Note: use src_read() if you want to check error condition/get number of bytes
  *skipped.
@@ -186,9 +220,10 @@ bool src_peek_line(pgp_source_t *src, char *buf, size_t len, size_t *read);
 /** @brief init file source
  *  @param src pre-allocated source structure
  *  @param path path to the file
+ *  @param readahead read the file on the background thread, so I/O overlaps with processing
  *  @return RNP_SUCCESS or error code
  **/
-rnp_result_t init_file_src(pgp_source_t *src, const char *path);
+rnp_result_t init_file_src(pgp_source_t *src, const char *path, bool readahead = false);
 
 /** @brief init stdin source
  *  @param src pre-allocated source structure
@@ -238,12 +273,13 @@ typedef struct pgp_dest_t {
     pgp_stream_type_t       type;
     rnp_result_t            werr; /* write function may set this to some error code */
 
-    size_t   writeb;   /* number of bytes written */
-    void *   param;    /* source-specific additional data */
-    bool     no_cache; /* disable write caching */
-    uint8_t  cache[PGP_OUTPUT_CACHE_SIZE];
-    unsigned clen;     /* number of bytes in cache */
-    bool     finished; /* whether dst_finish was called on dest or not */
+    size_t              writeb;   /* number of bytes written */
+    void *              param;    /* source-specific additional data */
+    pgp_stream_stats_t *stats;    /* counters to update, NULL if stats are not collected */
+    bool                no_cache; /* disable write caching */
+    uint8_t             cache[PGP_OUTPUT_CACHE_SIZE];
+    unsigned            clen;     /* number of bytes in cache */
+    bool                finished; /* whether dst_finish was called on dest or not */
 } pgp_dest_t;
 
 /** @brief helper function to allocate memory for dest's param.
@@ -300,18 +336,27 @@ void dst_flush(pgp_dest_t *dst);
  *  @param dst pre-allocated dest structure
  *  @param path path to the file
  *  @param overwrite overwrite existing file
+ *  @param writebehind write the file on the background thread, so I/O overlaps with
+ *         processing. Write errors are reported by dst_finish() or subsequent writes.
  *  @return RNP_SUCCESS or error code
  **/
-rnp_result_t init_file_dest(pgp_dest_t *dst, const char *path, bool overwrite);
+rnp_result_t init_file_dest(pgp_dest_t *dst,
+                            const char *path,
+                            bool        overwrite,
+                            bool        writebehind = false);
 
 /** @brief init file destination, using the temporary file name, based on path.
  *         Once writing is over, dst_finish() will attempt to rename to the desired name.
  *  @param dst pre-allocated dest structure
  *  @param path path to the file
  *  @param overwrite overwrite existing file on rename
+ *  @param writebehind write the file on the background thread, see init_file_dest()
  *  @return RNP_SUCCESS or error code
  **/
-rnp_result_t init_tmpfile_dest(pgp_dest_t *dst, const char *path, bool overwrite);
+rnp_result_t init_tmpfile_dest(pgp_dest_t *dst,
+                               const char *path,
+                               bool        overwrite,
+                               bool        writebehind = false);
 
 /** @brief init stdout destination
  *  @param dst pre-allocated dest structure
@@ -34,6 +34,7 @@
 #include <string>
 #include <list>
 #include "pgp-key.h"
+#include "key-cache.h"
 #include "crypto/mem.h"
 
 typedef enum rnp_operation_t {
@@ -45,10 +46,11 @@ typedef enum rnp_operation_t {
 
 /* signature info structure */
 typedef struct rnp_signer_info_t {
-    pgp_key_t *    key{};
-    pgp_hash_alg_t halg{};
-    int64_t        sigcreate{};
-    uint64_t       sigexpire{};
+    pgp_key_t *          key{};
+    const pgp_key_pkt_t *seckey{}; /* already unlocked secret key, may be NULL */
+    pgp_hash_alg_t       halg{};
+    int64_t              sigcreate{};
+    uint64_t             sigexpire{};
 } rnp_signer_info_t;
 
 typedef struct rnp_symmetric_pass_info_t {
@@ -66,16 +68,26 @@ typedef struct rnp_symmetric_pass_info_t {
  *    this controls whether output is armored (base64-encoded). For armor/dearmor operation it
  *    controls the direction of the conversion (true means enarmor, false - dearmor),
  *  - rng : random number generator
+ *  - keycache : cache of decrypted secret keys, used for signing and decryption. May be NULL
  *  - operation : current operation type
  *
  *  For operations with OpenPGP embedded data (i.e. encrypted data and attached signatures):
  *  - filename, filemtime : to specify information about the contents of literal data packet
  *  - zalg, zlevel : compression algorithm and level, zlevel = 0 to disable compression
+ *  - zthreads : number of threads used for ZIP/ZLIB compression, 0 or 1 to compress on the
+ *    calling thread
+ *  - zauto : sample the beginning of the input and do not compress it if it looks
+ *    incompressible
+ *  - zused : set when the operation starts to the compression algorithm which is actually
+ *    used, PGP_C_NONE if data is not compressed. -1 if operation was not started yet
  *
  *  For encryption operation (including encrypt-and-sign):
  *  - halg : hash algorithm used during key derivation for password-based encryption
  *  - ealg, aalg, abits : symmetric encryption algorithm and AEAD parameters if used
  *  - recipients : list of key ids used to encrypt data to
+ *  - pubkeys : preloaded backend keys of the recipients, may be empty
+ *  - ethreads : number of threads used to encrypt session key to the recipients, 0 or 1 to
+ *    do this on the calling thread
  *  - passwords : list of passwords used for password-based encryption
  *  - filename, filemtime, zalg, zlevel : see previous
  *
@@ -103,16 +115,23 @@ typedef struct rnp_ctx_t {
     pgp_symm_alg_t ealg{};      /* encryption algorithm */
     int            zalg{};      /* compression algorithm used */
     int            zlevel{};    /* compression level */
+    size_t         zthreads{};  /* number of parallel compression threads */
+    bool           zauto{};     /* skip compression for high-entropy data */
+    int            zused{-1};   /* compression algorithm actually used */
+    size_t         ethreads{};  /* number of threads for recipients' session keys */
     pgp_aead_alg_t aalg{};      /* non-zero to use AEAD */
     int            abits{};     /* AEAD chunk bits */
     bool           overwrite{}; /* allow to overwrite output file if exists */
     bool           armor{};     /* whether to use ASCII armor on output */
     std::list<pgp_key_t *> recipients{};              /* recipients of the encrypted message */
+    std::list<pgp_pubkey_cache_ptr>      pubkeys{};   /* preloaded recipients' keys */
     std::list<rnp_symmetric_pass_info_t> passwords{}; /* passwords to encrypt message */
     std::list<rnp_signer_info_t>         signers{};   /* keys to which sign message */
     bool                                 discard{};   /* discard the output */
     rng_t *                              rng{};       /* pointer to rng_t */
+    pgp_seckey_cache_t *                 keycache{};  /* decrypted secret keys cache */
     rnp_operation_t                      operation{}; /* current operation type */
+    pgp_stream_stats_t *                 stats{};     /* per-layer stream counters or NULL */
 
     rnp_ctx_t() = default;
     rnp_ctx_t(const rnp_ctx_t &) = delete;
@@ -2197,10 +2197,44 @@ stream_dump_marker_json(pgp_source_t &src, json_object *pkt)
 
 static rnp_result_t stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx,
                                                  pgp_source_t *  src,
-                                                 json_object **  jso);
+                                                 json_object *   pkts,
+                                                 pgp_dest_t *    dst);
+
+static bool
+dst_write_json(pgp_dest_t *dst, json_object *jso)
+{
+    const char *str = json_object_to_json_string_ext(jso, JSON_C_TO_STRING_PRETTY);
+    if (!str) {
+        return false;
+    }
+    dst_write(dst, str, strlen(str));
+    return !dst->werr;
+}
+
+/* write opening brace and fields of the object, so more fields may be written later */
+static bool
+dst_write_json_fields(pgp_dest_t *dst, json_object *jso)
+{
+    bool first = true;
+    dst_printf(dst, "{");
+    json_object_object_foreach(jso, key, val)
+    {
+        dst_printf(dst, "%s\n  \"%s\":", first ? "" : ",", key);
+        first = false;
+        const char *str = json_object_to_json_string_ext(val, JSON_C_TO_STRING_PRETTY);
+        if (!str) {
+            return false;
+        }
+        dst_write(dst, str, strlen(str));
+    }
+    return !dst->werr;
+}
 
 static rnp_result_t
-stream_dump_compressed_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object *pkt)
+stream_dump_compressed_json(rnp_dump_ctx_t *ctx,
+                            pgp_source_t *  src,
+                            json_object *   pkt,
+                            pgp_dest_t *    dst)
 {
     pgp_source_t zsrc = {0};
     uint8_t      zalg;
@@ -2217,10 +2251,31 @@ stream_dump_compressed_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object
         goto done;
     }
 
-    ret = stream_dump_raw_packets_json(ctx, &zsrc, &contents);
+    /* when streaming, packet fields are written first, followed by the contents array */
+    if (dst) {
+        if (!dst_write_json_fields(dst, pkt)) {
+            ret = RNP_ERROR_WRITE;
+            goto done;
+        }
+        dst_printf(dst, ",\n  \"contents\":");
+        ret = stream_dump_raw_packets_json(ctx, &zsrc, NULL, dst);
+        dst_printf(dst, "\n}");
+        if (!ret && dst->werr) {
+            ret = RNP_ERROR_WRITE;
+        }
+        goto done;
+    }
+
+    contents = json_object_new_array();
+    if (!contents) {
+        ret = RNP_ERROR_OUT_OF_MEMORY;
+        goto done;
+    }
+    ret = stream_dump_raw_packets_json(ctx, &zsrc, contents, NULL);
     if (!ret && !obj_add_field_json(pkt, "contents", contents)) {
-        json_object_put(contents);
         ret = RNP_ERROR_OUT_OF_MEMORY;
+    } else if (ret) {
+        json_object_put(contents);
     }
 done:
     src_close(&zsrc);
@@ -2308,16 +2363,19 @@ error:
     return false;
 }
 
+/* packets are added to the pkts array, or, if dst is not NULL, written to it one by one */
 static rnp_result_t
-stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object **jso)
+stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx,
+                             pgp_source_t *  src,
+                             json_object *   pkts,
+                             pgp_dest_t *    dst)
 {
-    json_object *pkts = NULL;
     json_object *pkt = NULL;
     rnp_result_t ret = RNP_ERROR_GENERIC;
+    size_t       count = 0;
 
-    pkts = json_object_new_array();
-    if (!pkts) {
-        return RNP_ERROR_OUT_OF_MEMORY;
+    if (dst) {
+        dst_printf(dst, "[");
     }
 
     if (src_eof(src)) {
@@ -2363,6 +2421,10 @@ stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object
             }
         }
 
+        if (dst) {
+            dst_printf(dst, count++ ? ",\n" : "\n");
+        }
+
         switch (hdr.tag) {
         case PGP_PKT_SIGNATURE:
             ret = stream_dump_signature_json(ctx, src, pkt);
@@ -2392,7 +2454,7 @@ stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object
             ret = stream_dump_one_pass_json(src, pkt);
             break;
         case PGP_PKT_COMPRESSED:
-            ret = stream_dump_compressed_json(ctx, src, pkt);
+            ret = stream_dump_compressed_json(ctx, src, pkt, dst);
             break;
         case PGP_PKT_LITDATA:
             ret = stream_dump_literal_json(src, pkt);
@@ -2413,24 +2475,35 @@ stream_dump_raw_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object
             goto done;
         }
 
-        if (json_object_array_add(pkts, pkt)) {
+        if (dst) {
+            /* compressed packet is already written together with its contents */
+            if ((hdr.tag != PGP_PKT_COMPRESSED) && !dst_write_json(dst, pkt)) {
+                ret = RNP_ERROR_WRITE;
+                goto done;
+            }
+            json_object_put(pkt);
+        } else if (json_object_array_add(pkts, pkt)) {
             ret = RNP_ERROR_OUT_OF_MEMORY;
             goto done;
         }
         pkt = NULL;
     }
 done:
-    if (ret) {
-        json_object_put(pkts);
-        json_object_put(pkt);
-        pkts = NULL;
+    json_object_put(pkt);
+    if (dst && !ret) {
+        dst_printf(dst, count ? "\n]" : "]");
+        if (dst->werr) {
+            ret = RNP_ERROR_WRITE;
+        }
     }
-    *jso = pkts;
     return ret;
 }
 
-rnp_result_t
-stream_dump_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object **jso)
+static rnp_result_t
+stream_dump_packets_json(rnp_dump_ctx_t *ctx,
+                         pgp_source_t *  src,
+                         json_object *   pkts,
+                         pgp_dest_t *    dst)
 {
     pgp_source_t armorsrc = {0};
     bool         armored = false;
@@ -2460,10 +2533,32 @@ stream_dump_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object **j
         goto finish;
     }
 
-    ret = stream_dump_raw_packets_json(ctx, src, jso);
+    ret = stream_dump_raw_packets_json(ctx, src, pkts, dst);
 finish:
     if (armored) {
         src_close(&armorsrc);
     }
     return ret;
 }
+
+rnp_result_t
+stream_dump_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, json_object **jso)
+{
+    json_object *pkts = json_object_new_array();
+    if (!pkts) {
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    rnp_result_t ret = stream_dump_packets_json(ctx, src, pkts, NULL);
+    if (ret) {
+        json_object_put(pkts);
+        pkts = NULL;
+    }
+    *jso = pkts;
+    return ret;
+}
+
+rnp_result_t
+stream_dump_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, pgp_dest_t *dst)
+{
+    return stream_dump_packets_json(ctx, src, NULL, dst);
+}
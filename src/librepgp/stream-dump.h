@@ -48,4 +48,10 @@ rnp_result_t stream_dump_packets_json(rnp_dump_ctx_t *ctx,
                                       pgp_source_t *  src,
                                       json_object **  jso);
 
+/**
+ * @brief Dump packets to the JSON array, written to dst packet by packet, so memory usage
+ *        does not depend on the number of packets.
+ */
+rnp_result_t stream_dump_packets_json(rnp_dump_ctx_t *ctx, pgp_source_t *src, pgp_dest_t *dst);
+
 #endif
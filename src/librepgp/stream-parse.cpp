@@ -274,6 +274,7 @@ init_partial_pkt_src(pgp_source_t *src, pgp_source_t *readsrc)
     src->read = partial_pkt_src_read;
     src->close = partial_pkt_src_close;
     src->type = PGP_STREAM_PARLEN_PACKET;
+    src->stats = readsrc->stats;
 
     if (param->psize < PGP_PARTIAL_PKT_FIRST_PART_MIN_SIZE) {
         RNP_LOG("first part of partial length packet sequence has size %d and that's less "
@@ -819,25 +820,36 @@ signed_src_update(pgp_source_t *src, const void *buf, size_t len)
     uint8_t *end = (uint8_t *) buf + len;
     /* we support LF and CRLF line endings */
     while (ch < end) {
-        /* continue if not reached LF */
-        if (*ch != CH_LF) {
-            if (*ch != CH_CR && param->stripped_crs > 0) {
-                while (param->stripped_crs--) {
-                    pgp_hash_list_update(param->txt_hashes, ST_CR, 1);
+        /* find the next LF, everything before it belongs to the current line */
+        uint8_t *eol = (uint8_t *) memchr(ch, CH_LF, end - ch);
+        uint8_t *lend = eol ? eol : end;
+        if (lend > ch) {
+            /* dump CRs stripped from the previous chunk if line continues with non-CR */
+            if (param->stripped_crs > 0) {
+                uint8_t *nocr = ch;
+                while ((nocr < lend) && (*nocr == CH_CR)) {
+                    nocr++;
+                }
+                if (nocr < lend) {
+                    while (param->stripped_crs--) {
+                        pgp_hash_list_update(param->txt_hashes, ST_CR, 1);
+                    }
+                    param->stripped_crs = 0;
                 }
-                param->stripped_crs = 0;
             }
 
-            if (!param->max_line_warn && param->text_line_len >= MAXIMUM_GNUPG_LINELEN) {
+            if (!param->max_line_warn &&
+                (param->text_line_len + (lend - ch) > MAXIMUM_GNUPG_LINELEN)) {
                 RNP_LOG("Canonical text document signature: line is too long, may cause "
                         "incompatibility with other implementations. Consider using binary "
                         "signature instead.");
                 param->max_line_warn = true;
             }
-
-            ch++;
-            param->text_line_len++;
-            continue;
+            param->text_line_len += lend - ch;
+            ch = lend;
+        }
+        if (!eol) {
+            break;
         }
         /* reached eol: dump line contents */
         param->stripped_crs = 0;
@@ -1225,24 +1237,26 @@ cleartext_src_read(pgp_source_t *src, void *buf, size_t len, size_t *readres)
         }
 
         /* processing data line by line, eol could be \n or \r\n */
-        for (cur = srcb, bg = srcb, en = cur + read; cur < en; cur++) {
-            if ((*cur == CH_LF) ||
-                ((*cur == CH_CR) && (cur + 1 < en) && (*(cur + 1) == CH_LF))) {
-                cleartext_process_line(src, bg, cur - bg, true);
-                /* processing eol */
-                if (param->clr_eod) {
-                    break;
-                }
+        bg = srcb;
+        en = srcb + read;
+        while ((bg < en) && (cur = (uint8_t *) memchr(bg, CH_LF, en - bg))) {
+            /* include preceding \r into the eol sequence */
+            if ((cur > bg) && (*(cur - 1) == CH_CR)) {
+                cur--;
+            }
+            cleartext_process_line(src, bg, cur - bg, true);
+            if (param->clr_eod) {
+                break;
+            }
 
-                /* processing eol */
-                param->clr_fline = false;
-                param->clr_mline = false;
-                if (*cur == CH_CR) {
-                    param->out[param->outlen++] = *cur++;
-                }
-                param->out[param->outlen++] = *cur;
-                bg = cur + 1;
+            /* processing eol */
+            param->clr_fline = false;
+            param->clr_mline = false;
+            if (*cur == CH_CR) {
+                param->out[param->outlen++] = *cur++;
             }
+            param->out[param->outlen++] = *cur;
+            bg = cur + 1;
         }
 
         /* if line is larger then 4k then just dump it out */
@@ -1952,7 +1966,7 @@ encrypted_read_packet_data(pgp_source_encrypted_param_t *param)
     return RNP_SUCCESS;
 }
 
-static rnp_result_t
+rnp_result_t
 init_encrypted_src(pgp_parse_handler_t *handler, pgp_source_t *src, pgp_source_t *readsrc)
 {
     rnp_result_t                  errcode = RNP_ERROR_GENERIC;
@@ -2024,8 +2038,8 @@ init_encrypted_src(pgp_parse_handler_t *handler, pgp_source_t *src, pgp_source_t
             /* Decrypt key */
             if (seckey->encrypted()) {
                 pgp_password_ctx_t pass_ctx{.op = PGP_OP_DECRYPT, .key = seckey};
-                decrypted_seckey =
-                  pgp_decrypt_seckey(seckey, handler->password_provider, &pass_ctx);
+                decrypted_seckey = pgp_decrypt_seckey_cached(
+                  handler->ctx->keycache, seckey, handler->password_provider, &pass_ctx);
                 if (!decrypted_seckey) {
                     errcode = RNP_ERROR_BAD_PASSWORD;
                     continue;
@@ -2368,6 +2382,7 @@ init_packet_sequence(pgp_processing_ctx_t &ctx, pgp_source_t &src)
             return ret;
         }
 
+        psrc.stats = lsrc->stats;
         try {
             ctx.sources.push_back(psrc);
             lsrc = &ctx.sources.back();
@@ -2402,6 +2417,7 @@ init_cleartext_sequence(pgp_processing_ctx_t &ctx, pgp_source_t &src)
     if ((res = init_signed_src(&ctx.handler, &clrsrc, &src))) {
         return res;
     }
+    clrsrc.stats = src.stats;
     try {
         ctx.sources.push_back(clrsrc);
     } catch (const std::exception &e) {
@@ -2421,6 +2437,7 @@ init_armored_sequence(pgp_processing_ctx_t &ctx, pgp_source_t &src)
     if ((res = init_armored_src(&armorsrc, &src))) {
         return res;
     }
+    armorsrc.stats = src.stats;
 
     try {
         ctx.sources.push_back(armorsrc);
@@ -2444,8 +2461,11 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t &src)
     bool                 closeout = true;
     uint8_t *            readbuf = NULL;
     char *               filename = NULL;
+    pgp_stream_stats_t * srcstats = src.stats;
+    pgp_stream_stats_t * dststats = NULL;
 
     ctx.handler = *handler;
+    src.stats = handler->ctx->stats;
     /* Building readers sequence. Checking whether it is binary data */
     if (is_pgp_source(src)) {
         res = init_packet_sequence(ctx, src);
@@ -2487,6 +2507,7 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t &src)
             goto finish;
         }
 
+        datasrc.stats = handler->ctx->stats;
         while (!datasrc.eof) {
             size_t read = 0;
             if (!src_read(&datasrc, readbuf, PGP_INPUT_CACHE_SIZE, &read)) {
@@ -2515,6 +2536,8 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t &src)
             res = RNP_ERROR_WRITE;
             goto finish;
         }
+        dststats = outdest->stats;
+        outdest->stats = handler->ctx->stats;
 
         /* reading the input */
         while (!decsrc->eof) {
@@ -2550,9 +2573,252 @@ process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t &src)
 
     if (closeout && (ctx.msg_type != PGP_MESSAGE_DETACHED)) {
         dst_close(outdest, res != RNP_SUCCESS);
+    } else if (outdest) {
+        if (outdest->stats) {
+            /* account cached output data as well */
+            dst_flush(outdest);
+        }
+        outdest->stats = dststats;
     }
 
 finish:
+    src.stats = srcstats;
     free(readbuf);
     return res;
 }
+
+/* state of the random-access AEAD decryption */
+typedef struct pgp_aead_range_t {
+    pgp_source_encrypted_param_t *enc;    /* encrypted source params with initialized cipher */
+    pgp_source_t *                src;    /* seekable source with definite-length packet */
+    uint64_t                      base;   /* offset of the first chunk in src */
+    uint64_t                      total;  /* total length of the decrypted data */
+    uint64_t                      chunks; /* number of non-empty chunks */
+    size_t                        taglen; /* authentication tag length */
+} pgp_aead_range_t;
+
+static bool
+aead_range_start_chunk(pgp_aead_range_t &range, uint64_t idx)
+{
+    /* cipher may be in the middle of other chunk, so reset it */
+    pgp_cipher_aead_reset(&range.enc->decrypt);
+    bool last = idx == range.chunks;
+    if (last) {
+        /* encrypted_start_aead_chunk() calculates total length from the last chunk size */
+        range.enc->chunkin = range.total - (idx ? (idx - 1) * range.enc->chunklen : 0);
+    }
+    bool res = encrypted_start_aead_chunk(range.enc, idx, last);
+    if (last) {
+        /* drop total length from the additional data */
+        range.enc->aead_adlen -= 8;
+    }
+    return res;
+}
+
+/* decrypt and authenticate the chunk idx, copying decrypted bytes [from, to) of it to out */
+static bool
+aead_range_decrypt_chunk(
+  pgp_aead_range_t &range, uint64_t idx, size_t from, size_t to, uint8_t *out)
+{
+    uint64_t chunkpos = idx * range.enc->chunklen;
+    size_t   left = std::min((uint64_t) range.enc->chunklen, range.total - chunkpos);
+    size_t   gran = pgp_cipher_aead_granularity(&range.enc->decrypt);
+    size_t   blen = PGP_INPUT_CACHE_SIZE - PGP_INPUT_CACHE_SIZE % gran;
+    size_t   pos = 0;
+
+    if (!src_seek(range.src, range.base + idx * (range.enc->chunklen + range.taglen)) ||
+        !aead_range_start_chunk(range, idx)) {
+        return false;
+    }
+
+    std::vector<uint8_t> buf(blen + range.taglen);
+    while (true) {
+        bool   last = left <= blen;
+        size_t len = last ? left + range.taglen : blen;
+        if (!src_read_eq(range.src, buf.data(), len)) {
+            RNP_LOG("failed to read chunk %" PRIu64, idx);
+            return false;
+        }
+        uint8_t *data = buf.data();
+        bool     res = last ? pgp_cipher_aead_finish(&range.enc->decrypt, data, data, len) :
+                          pgp_cipher_aead_update(&range.enc->decrypt, data, data, len);
+        if (!res) {
+            RNP_LOG("failed to decrypt chunk %" PRIu64, idx);
+            return false;
+        }
+        size_t declen = last ? left : len;
+        /* copy the requested part of the chunk */
+        size_t cpfrom = std::max(pos, from);
+        size_t cpto = std::min(pos + declen, to);
+        if (cpfrom < cpto) {
+            memcpy(out + cpfrom - from, buf.data() + cpfrom - pos, cpto - cpfrom);
+        }
+        if (last) {
+            return true;
+        }
+        pos += declen;
+        left -= declen;
+    }
+}
+
+/* decrypt len bytes, starting from the offset start, to the out buffer */
+static bool
+aead_range_read(pgp_aead_range_t &range, uint64_t start, uint8_t *out, size_t len)
+{
+    size_t chunklen = range.enc->chunklen;
+    while (len) {
+        uint64_t idx = start / chunklen;
+        size_t   from = start - idx * chunklen;
+        size_t   to = std::min((uint64_t) from + len, (uint64_t) chunklen);
+        if (!aead_range_decrypt_chunk(range, idx, from, to, out)) {
+            return false;
+        }
+        out += to - from;
+        len -= to - from;
+        start += to - from;
+    }
+    return true;
+}
+
+/* decrypt bytes [start, end) of the AEAD-encrypted data, writing them to dst */
+static rnp_result_t
+aead_range_decrypt(pgp_aead_range_t &range, uint64_t start, uint64_t end, pgp_dest_t *dst)
+{
+    size_t               chunklen = range.enc->chunklen;
+    std::vector<uint8_t> buf;
+
+    while (start < end) {
+        /* data is released only after the whole chunk is authenticated */
+        uint64_t idx = start / chunklen;
+        size_t   len = std::min(end, (idx + 1) * chunklen) - start;
+        buf.resize(len);
+        if (!aead_range_read(range, start, buf.data(), len)) {
+            return RNP_ERROR_DECRYPT_FAILED;
+        }
+        dst_write(dst, buf.data(), len);
+        if (dst->werr) {
+            return dst->werr;
+        }
+        start += len;
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+aead_range_init(pgp_aead_range_t &range, pgp_source_t *encsrc, pgp_source_t *src)
+{
+    pgp_source_encrypted_param_t *enc = (pgp_source_encrypted_param_t *) encsrc->param;
+    if (!enc->aead || enc->pkt.partial || enc->pkt.indeterminate) {
+        RNP_LOG("random access is available only for definite-length AEAD packet");
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+
+    range.enc = enc;
+    range.src = src;
+    range.base = src->readb;
+    range.taglen = pgp_cipher_aead_tag_len(enc->aead_hdr.aalg);
+    /* encrypted data: non-empty chunks with tags, and then final tag */
+    uint64_t hdrlen = 4 + enc->aead_hdr.ivlen;
+    if (enc->pkt.len < hdrlen + range.taglen) {
+        RNP_LOG("too short AEAD packet");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    uint64_t datalen = enc->pkt.len - hdrlen - range.taglen;
+    uint64_t fulllen = (uint64_t) enc->chunklen + range.taglen;
+    range.chunks = datalen / fulllen + !!(datalen % fulllen);
+    if (range.chunks && (datalen - (range.chunks - 1) * fulllen <= range.taglen)) {
+        RNP_LOG("wrong AEAD packet length");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    range.total = datalen - range.chunks * range.taglen;
+
+    /* check the final tag which authenticates the total length */
+    uint8_t tag[PGP_AEAD_MAX_TAG_LEN];
+    if (!src_seek(src, range.base + datalen) || !src_read_eq(src, tag, range.taglen)) {
+        RNP_LOG("failed to read final tag");
+        return RNP_ERROR_READ;
+    }
+    if (!aead_range_start_chunk(range, range.chunks) ||
+        !pgp_cipher_aead_finish(&enc->decrypt, tag, tag, range.taglen)) {
+        RNP_LOG("wrong last chunk");
+        return RNP_ERROR_DECRYPT_FAILED;
+    }
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_decrypt_range_src(pgp_parse_handler_t *handler,
+                      pgp_source_t &       src,
+                      uint64_t             offset,
+                      uint64_t             len,
+                      pgp_dest_t &         dst)
+{
+    pgp_source_t     encsrc = {};
+    pgp_source_t     hdrsrc = {};
+    pgp_source_t     litsrc = {};
+    pgp_aead_range_t range = {};
+    rnp_result_t     ret = RNP_ERROR_GENERIC;
+    uint8_t          hdr[PGP_MAX_HEADER_SIZE + 6 + 255];
+    size_t           hdrlen = 0;
+    uint64_t         datastart = 0;
+
+    if (!src.seek) {
+        RNP_LOG("source is not seekable");
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+    if (is_armored_source(&src)) {
+        RNP_LOG("random access is not available for armored message");
+        return RNP_ERROR_NOT_SUPPORTED;
+    }
+    if ((stream_pkt_type(&src) == PGP_PKT_MARKER) && (ret = stream_parse_marker(src))) {
+        return ret;
+    }
+    int ptype = stream_pkt_type(&src);
+    if ((ptype != PGP_PKT_PK_SESSION_KEY) && (ptype != PGP_PKT_SK_SESSION_KEY)) {
+        RNP_LOG("not a binary encrypted message");
+        return RNP_ERROR_BAD_FORMAT;
+    }
+    /* this will also obtain the session key */
+    if ((ret = init_encrypted_src(handler, &encsrc, &src))) {
+        return ret;
+    }
+    if ((ret = aead_range_init(range, &encsrc, &src))) {
+        goto finish;
+    }
+
+    /* encrypted data must be the single literal data packet with definite length */
+    hdrlen = std::min((uint64_t) sizeof(hdr), range.total);
+    if (!aead_range_read(range, 0, hdr, hdrlen)) {
+        ret = RNP_ERROR_DECRYPT_FAILED;
+        goto finish;
+    }
+    if ((ret = init_mem_src(&hdrsrc, hdr, hdrlen, false))) {
+        goto finish;
+    }
+    if (stream_pkt_type(&hdrsrc) != PGP_PKT_LITDATA) {
+        RNP_LOG("random access is available only for uncompressed non-signed data");
+        ret = RNP_ERROR_NOT_SUPPORTED;
+        goto finish;
+    }
+    if ((ret = init_literal_src(&litsrc, &hdrsrc))) {
+        goto finish;
+    }
+    if (!litsrc.knownsize) {
+        RNP_LOG("random access is not available for partial-length literal data");
+        ret = RNP_ERROR_NOT_SUPPORTED;
+        goto finish;
+    }
+    datastart = hdrsrc.readb;
+    if ((offset > litsrc.size) || (datastart + litsrc.size > range.total)) {
+        RNP_LOG("wrong range or literal data length");
+        ret = offset > litsrc.size ? RNP_ERROR_BAD_PARAMETERS : RNP_ERROR_BAD_FORMAT;
+        goto finish;
+    }
+    len = std::min(len, litsrc.size - offset);
+    ret = aead_range_decrypt(range, datastart + offset, datastart + offset + len, &dst);
+finish:
+    src_close(&litsrc);
+    src_close(&hdrsrc);
+    src_close(&encsrc);
+    return ret;
+}
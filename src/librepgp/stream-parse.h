@@ -84,6 +84,36 @@ typedef struct pgp_parse_handler_t {
  **/
 rnp_result_t process_pgp_source(pgp_parse_handler_t *handler, pgp_source_t &src);
 
+/* @brief Decrypt part of the literal data contents from the AEAD-encrypted message, without
+ * processing the whole message. Only chunks, covering the requested range, are read, decrypted
+ * and authenticated, as well as the final authentication tag.
+ * Message must be binary, AEAD-encrypted with definite-length packet, and contain the single
+ * uncompressed literal data packet with definite length.
+ * @param handler handler with key and password providers
+ * @param src seekable source (file or memory) with the message
+ * @param offset offset of the first byte within literal data contents
+ * @param len number of bytes to decrypt, range is truncated to the end of data
+ * @param dst destination to write decrypted data to
+ * @return RNP_SUCCESS on success, RNP_ERROR_NOT_SUPPORTED if message or source doesn't allow
+ *         random access, or any other error code
+ **/
+rnp_result_t rnp_decrypt_range_src(pgp_parse_handler_t *handler,
+                                   pgp_source_t &       src,
+                                   uint64_t             offset,
+                                   uint64_t             len,
+                                   pgp_dest_t &         dst);
+
+/* @brief Init source with OpenPGP encrypted data, including the session key packets. Session
+ * key is obtained via the handler's key and password providers.
+ * @param handler handler with key and password providers
+ * @param src allocated pgp_source_t structure
+ * @param readsrc source to read encrypted data from
+ * @return RNP_SUCCESS on success or error code otherwise
+ */
+rnp_result_t init_encrypted_src(pgp_parse_handler_t *handler,
+                                pgp_source_t *       src,
+                                pgp_source_t *       readsrc);
+
 /* @brief Init source with OpenPGP compressed data packet
  * @param src allocated pgp_source_t structure
  * @param readsrc source to read compressed data from
@@ -54,12 +54,36 @@
 #include "types.h"
 #include "crypto/signatures.h"
 #include "defaults.h"
+#include "workers.h"
 #include <time.h>
+#include <math.h>
 #include <algorithm>
-
-/* 8192 bytes, as GnuPG */
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* first part is 8192 bytes, as GnuPG, then part size doubles up to 1 MB */
 #define PGP_PARTIAL_PKT_SIZE_BITS (13)
 #define PGP_PARTIAL_PKT_BLOCK_SIZE (1 << PGP_PARTIAL_PKT_SIZE_BITS)
+#define PGP_PARTIAL_PKT_MAX_SIZE_BITS (20)
+
+/* maximum body length of the definite-length packet we write */
+#define PGP_MAX_DEFINITE_LEN (0xffffffffULL)
+
+/* input block size and dictionary size for the parallel deflate, as pigz does */
+#define PGP_PARALLEL_DEFLATE_BLOCK (128 * 1024)
+#define PGP_DEFLATE_DICT_SIZE (32 * 1024)
+
+/* minimum number of recipients to encrypt session key on the worker threads */
+#define PGP_PARALLEL_PKESK_MIN (4)
+
+/* sample size and per-byte entropy threshold (in bits) for automatic compression bypass */
+#define PGP_COMPRESS_SAMPLE_SIZE (PGP_INPUT_CACHE_SIZE / 2)
+#define PGP_COMPRESS_MAX_ENTROPY (7.5)
 
 /* common fields for encrypted, compressed and literal data */
 typedef struct pgp_dest_packet_param_t {
@@ -70,8 +94,32 @@ typedef struct pgp_dest_packet_param_t {
     int         tag;                      /* packet tag */
     uint8_t     hdr[PGP_MAX_HEADER_SIZE]; /* header, including length, as it was written */
     size_t      hdrlen;                   /* number of bytes in hdr */
+    uint64_t    len;     /* body length if packet is neither partial nor indeterminate */
+    uint64_t    written; /* number of body bytes written, to check the definite length */
 } pgp_dest_packet_param_t;
 
+/* single block of the parallel deflate, compressed independently of the others */
+typedef struct pgp_deflate_block_t {
+    std::vector<uint8_t> out{};   /* compressed block contents */
+    size_t               inlen{}; /* number of input bytes */
+    uLong                adler{}; /* adler32 checksum of the input, used for ZLIB */
+    bool                 ok{};    /* whether compression succeeded */
+} pgp_deflate_block_t;
+
+/* state of the pigz-style parallel deflate: input is split into blocks which are compressed
+ * concurrently on the worker pool, each primed with the tail of the previous block, and
+ * concatenated in order */
+typedef struct pgp_parallel_deflate_t {
+    int                                          level{};   /* compression level */
+    std::vector<uint8_t>                         block{};   /* input of the current block */
+    std::vector<uint8_t>                         dict{};    /* tail of the previous block */
+    std::deque<std::future<pgp_deflate_block_t>> jobs{};    /* blocks being compressed */
+    uLong                                        adler{};   /* adler32 of the whole input */
+    rnp_worker_pool_t                            pool;      /* compression threads */
+
+    pgp_parallel_deflate_t(size_t threads) : pool(threads){};
+} pgp_parallel_deflate_t;
+
 typedef struct pgp_dest_compressed_param_t {
     pgp_dest_packet_param_t pkt;
     pgp_compression_type_t  alg;
@@ -79,7 +127,8 @@ typedef struct pgp_dest_compressed_param_t {
         z_stream  z;
         bz_stream bz;
     };
-    bool    zstarted;                        /* whether we initialize zlib/bzip2  */
+    bool                    zstarted;  /* whether we initialize zlib/bzip2  */
+    pgp_parallel_deflate_t *par;       /* parallel deflate state, NULL if not used */
     uint8_t cache[PGP_INPUT_CACHE_SIZE / 2]; /* pre-allocated cache for compression */
     size_t  len;                             /* number of bytes cached */
 } pgp_dest_compressed_param_t;
@@ -103,11 +152,12 @@ typedef struct pgp_dest_encrypted_param_t {
 } pgp_dest_encrypted_param_t;
 
 typedef struct pgp_dest_signer_info_t {
-    pgp_one_pass_sig_t onepass;
-    pgp_key_t *        key;
-    pgp_hash_alg_t     halg;
-    int64_t            sigcreate;
-    uint64_t           sigexpire;
+    pgp_one_pass_sig_t   onepass;
+    pgp_key_t *          key;
+    const pgp_key_pkt_t *seckey; /* already unlocked secret key, may be NULL */
+    pgp_hash_alg_t       halg;
+    int64_t              sigcreate;
+    uint64_t             sigexpire;
 } pgp_dest_signer_info_t;
 
 typedef struct pgp_dest_signed_param_t {
@@ -126,12 +176,30 @@ typedef struct pgp_dest_signed_param_t {
 
 typedef struct pgp_dest_partial_param_t {
     pgp_dest_t *writedst;
-    uint8_t     part[PGP_PARTIAL_PKT_BLOCK_SIZE];
+    uint8_t *   part;    /* buffer for the current part, partlen bytes */
     uint8_t     parthdr; /* header byte for the current part */
-    size_t      partlen; /* length of the current part, up to PARTIAL_PKT_BLOCK_SIZE */
+    size_t      partlen; /* length of the current part, up to 1 << PARTIAL_PKT_MAX_SIZE_BITS */
     size_t      len;     /* bytes cached in part */
 } pgp_dest_partial_param_t;
 
+/* each written full part doubles the size of the next one, so long streams have fewer
+ * headers and larger writes, while short ones still fit the single small part */
+static void
+partial_dst_grow(pgp_dest_partial_param_t *param)
+{
+    if ((param->parthdr & 0x1f) >= PGP_PARTIAL_PKT_MAX_SIZE_BITS) {
+        return;
+    }
+    uint8_t *part = (uint8_t *) realloc(param->part, param->partlen * 2);
+    if (!part) {
+        /* not a problem, we may continue with the current part size */
+        return;
+    }
+    param->part = part;
+    param->partlen *= 2;
+    param->parthdr++;
+}
+
 static rnp_result_t
 partial_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -151,6 +219,7 @@ partial_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         buf = (uint8_t *) buf + wrlen;
         len -= wrlen;
         param->len = 0;
+        partial_dst_grow(param);
 
         /* writing all full parts directly from buf */
         while (len >= param->partlen) {
@@ -158,6 +227,7 @@ partial_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
             dst_write(param->writedst, buf, param->partlen);
             buf = (uint8_t *) buf + param->partlen;
             len -= param->partlen;
+            partial_dst_grow(param);
         }
     }
 
@@ -193,6 +263,7 @@ partial_dst_close(pgp_dest_t *dst, bool discard)
         return;
     }
 
+    free(param->part);
     free(param);
     dst->param = NULL;
 }
@@ -207,6 +278,11 @@ init_partial_pkt_dst(pgp_dest_t *dst, pgp_dest_t *writedst)
     }
 
     param = (pgp_dest_partial_param_t *) dst->param;
+    param->part = (uint8_t *) malloc(PGP_PARTIAL_PKT_BLOCK_SIZE);
+    if (!param->part) {
+        partial_dst_close(dst, true);
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
     param->writedst = writedst;
     param->partlen = PGP_PARTIAL_PKT_BLOCK_SIZE;
     param->parthdr = 0xE0 | PGP_PARTIAL_PKT_SIZE_BITS;
@@ -215,12 +291,14 @@ init_partial_pkt_dst(pgp_dest_t *dst, pgp_dest_t *writedst)
     dst->finish = partial_dst_finish;
     dst->close = partial_dst_close;
     dst->type = PGP_STREAM_PARLEN_PACKET;
+    dst->stats = writedst->stats;
 
     return RNP_SUCCESS;
 }
 
 /** @brief helper function for streamed packets (literal, encrypted and compressed).
- *  Allocates part len destination if needed and writes header
+ *  Allocates part len destination if needed and writes header. If packet is neither partial
+ *  nor indeterminate then definite-length header with param->len is written.
  **/
 static bool
 init_streamed_packet(pgp_dest_packet_param_t *param, pgp_dest_t *dst)
@@ -263,8 +341,24 @@ init_streamed_packet(pgp_dest_packet_param_t *param, pgp_dest_t *dst)
         return true;
     }
 
-    RNP_LOG("wrong call");
-    return false;
+    if (param->len > PGP_MAX_DEFINITE_LEN) {
+        RNP_LOG("wrong call");
+        return false;
+    }
+    param->hdr[0] = param->tag | PGP_PTAG_ALWAYS_SET | PGP_PTAG_NEW_FORMAT;
+    param->hdrlen = 1 + write_packet_len(&param->hdr[1], param->len);
+    dst_write(dst, &param->hdr, param->hdrlen);
+    param->writedst = dst;
+    param->origdst = dst;
+    return true;
+}
+
+/** @brief get the full length of the definite-length packet, including header */
+static uint64_t
+definite_packet_len(uint64_t bodylen)
+{
+    uint8_t hdr[PGP_MAX_HEADER_SIZE];
+    return 1 + write_packet_len(hdr, bodylen) + bodylen;
 }
 
 static rnp_result_t
@@ -494,26 +588,15 @@ encrypted_dst_close(pgp_dest_t *dst, bool discard)
 }
 
 static rnp_result_t
-encrypted_add_recipient(pgp_write_handler_t *handler,
-                        pgp_dest_t *         dst,
-                        pgp_key_t *          userkey,
-                        const uint8_t *      key,
-                        const unsigned       keylen)
+encrypted_encrypt_sesskey(rng_t *           rng,
+                          pgp_key_t *       userkey,
+                          botan_pubkey_t    bkey,
+                          pgp_symm_alg_t    ealg,
+                          const uint8_t *   key,
+                          const unsigned    keylen,
+                          pgp_pk_sesskey_t &pkey)
 {
-    pgp_pk_sesskey_t            pkey;
-    pgp_dest_encrypted_param_t *param = (pgp_dest_encrypted_param_t *) dst->param;
-    rnp_result_t                ret = RNP_ERROR_GENERIC;
-
-    /* Use primary key if good for encryption, otherwise look in subkey list */
-    userkey =
-      find_suitable_key(PGP_OP_ENCRYPT_SYM, userkey, handler->key_provider, PGP_KF_ENCRYPT);
-    if (!userkey) {
-        return RNP_ERROR_NO_SUITABLE_KEY;
-    }
-    if (!userkey->valid()) {
-        RNP_LOG("attempt to use invalid key as recipient");
-        return RNP_ERROR_NO_SUITABLE_KEY;
-    }
+    rnp_result_t ret = RNP_ERROR_GENERIC;
 
     /* Fill pkey */
     pkey.version = PGP_PKSK_V3;
@@ -522,7 +605,7 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
 
     /* Encrypt the session key */
     rnp::secure_array<uint8_t, PGP_MAX_KEY_SIZE + 3> enckey;
-    enckey[0] = param->ctx->ealg;
+    enckey[0] = ealg;
     memcpy(&enckey[1], key, keylen);
 
     /* Calculate checksum */
@@ -539,11 +622,8 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
     switch (userkey->alg()) {
     case PGP_PKA_RSA:
     case PGP_PKA_RSA_ENCRYPT_ONLY: {
-        ret = rsa_encrypt_pkcs1(rnp_ctx_rng_handle(handler->ctx),
-                                &material.rsa,
-                                enckey.data(),
-                                keylen + 3,
-                                &userkey->material().rsa);
+        ret = rsa_encrypt_pkcs1(
+          rng, &material.rsa, enckey.data(), keylen + 3, &userkey->material().rsa, bkey);
         if (ret) {
             RNP_LOG("rsa_encrypt_pkcs1 failed");
             return ret;
@@ -551,12 +631,13 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
         break;
     }
     case PGP_PKA_SM2: {
-        ret = sm2_encrypt(rnp_ctx_rng_handle(handler->ctx),
+        ret = sm2_encrypt(rng,
                           &material.sm2,
                           enckey.data(),
                           keylen + 3,
                           PGP_HASH_SM3,
-                          &userkey->material().ec);
+                          &userkey->material().ec,
+                          bkey);
         if (ret) {
             RNP_LOG("sm2_encrypt failed");
             return ret;
@@ -564,7 +645,7 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
         break;
     }
     case PGP_PKA_ECDH: {
-        ret = ecdh_encrypt_pkcs5(rnp_ctx_rng_handle(handler->ctx),
+        ret = ecdh_encrypt_pkcs5(rng,
                                  &material.ecdh,
                                  enckey.data(),
                                  keylen + 3,
@@ -577,11 +658,8 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
         break;
     }
     case PGP_PKA_ELGAMAL: {
-        ret = elgamal_encrypt_pkcs1(rnp_ctx_rng_handle(handler->ctx),
-                                    &material.eg,
-                                    enckey.data(),
-                                    keylen + 3,
-                                    &userkey->material().eg);
+        ret = elgamal_encrypt_pkcs1(
+          rng, &material.eg, enckey.data(), keylen + 3, &userkey->material().eg, bkey);
         if (ret) {
             RNP_LOG("pgp_elgamal_public_encrypt failed");
             return ret;
@@ -593,9 +671,48 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
         return ret;
     }
 
-    /* Writing symmetric key encrypted session key packet */
     try {
         pkey.write_material(material);
+        return RNP_SUCCESS;
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+}
+
+static pgp_key_t *
+encrypted_recipient_key(pgp_write_handler_t *handler, pgp_key_t *userkey)
+{
+    /* Use primary key if good for encryption, otherwise look in subkey list */
+    userkey =
+      find_suitable_key(PGP_OP_ENCRYPT_SYM, userkey, handler->key_provider, PGP_KF_ENCRYPT);
+    if (!userkey) {
+        return NULL;
+    }
+    if (!userkey->valid()) {
+        RNP_LOG("attempt to use invalid key as recipient");
+        return NULL;
+    }
+    return userkey;
+}
+
+static botan_pubkey_t
+encrypted_cached_pubkey(const rnp_ctx_t *ctx, const pgp_key_t *enckey)
+{
+    for (auto &cache : ctx->pubkeys) {
+        botan_pubkey_t bkey = cache->get(enckey->fp());
+        if (bkey) {
+            return bkey;
+        }
+    }
+    return NULL;
+}
+
+static rnp_result_t
+encrypted_write_sesskey(pgp_dest_encrypted_param_t *param, pgp_pk_sesskey_t &pkey)
+{
+    /* Writing public key encrypted session key packet */
+    try {
         pkey.write(*param->pkt.origdst);
         return param->pkt.origdst->werr;
     } catch (const std::exception &e) {
@@ -603,6 +720,122 @@ encrypted_add_recipient(pgp_write_handler_t *handler,
     }
 }
 
+static void
+encrypted_log_recipient_error(const pgp_key_t *userkey, rnp_result_t ret)
+{
+    char keyid[PGP_KEY_ID_SIZE * 2 + 1] = {0};
+    rnp::hex_encode(userkey->keyid().data(), userkey->keyid().size(), keyid, sizeof(keyid));
+    RNP_LOG("failed to encrypt session key to %s: 0x%x", keyid, (unsigned) ret);
+}
+
+static rnp_result_t
+encrypted_add_recipient(pgp_write_handler_t *handler,
+                        pgp_dest_t *         dst,
+                        pgp_key_t *          userkey,
+                        const uint8_t *      key,
+                        const unsigned       keylen)
+{
+    pgp_dest_encrypted_param_t *param = (pgp_dest_encrypted_param_t *) dst->param;
+    pgp_key_t *                 enckey = encrypted_recipient_key(handler, userkey);
+    if (!enckey) {
+        encrypted_log_recipient_error(userkey, RNP_ERROR_NO_SUITABLE_KEY);
+        return RNP_ERROR_NO_SUITABLE_KEY;
+    }
+
+    pgp_pk_sesskey_t pkey;
+    rnp_result_t     ret = encrypted_encrypt_sesskey(rnp_ctx_rng_handle(handler->ctx),
+                                                 enckey,
+                                                 encrypted_cached_pubkey(param->ctx, enckey),
+                                                 param->ctx->ealg,
+                                                 key,
+                                                 keylen,
+                                                 pkey);
+    if (ret) {
+        encrypted_log_recipient_error(userkey, ret);
+        return ret;
+    }
+    return encrypted_write_sesskey(param, pkey);
+}
+
+typedef struct pgp_recipient_job_t {
+    pgp_key_t *      recipient; /* recipient's key, as it was added to the context */
+    pgp_key_t *      key;       /* recipient's encryption key or subkey */
+    botan_pubkey_t   bkey;      /* preloaded backend key or NULL */
+    pgp_pk_sesskey_t pkey;      /* encrypted session key packet */
+    rnp_result_t     ret;       /* result of session key encryption */
+} pgp_recipient_job_t;
+
+/** @brief encrypt session key to all of the recipients, using handler->ctx->ethreads
+ *         threads if there are enough recipients. Packets are written in the recipients
+ *         order, the first failed recipient stops the operation.
+ **/
+static rnp_result_t
+encrypted_add_recipients(pgp_write_handler_t *handler,
+                         pgp_dest_t *         dst,
+                         const uint8_t *      key,
+                         const unsigned       keylen)
+{
+    pgp_dest_encrypted_param_t *param = (pgp_dest_encrypted_param_t *) dst->param;
+    auto &                      recipients = handler->ctx->recipients;
+    size_t                      threads = handler->ctx->ethreads;
+
+    if ((threads < 2) || (recipients.size() < PGP_PARALLEL_PKESK_MIN)) {
+        for (auto recipient : recipients) {
+            rnp_result_t ret = encrypted_add_recipient(handler, dst, recipient, key, keylen);
+            if (ret) {
+                return ret;
+            }
+        }
+        return RNP_SUCCESS;
+    }
+
+    /* Key lookup may call the user's callback, so it is done on the calling thread */
+    std::vector<pgp_recipient_job_t> jobs(recipients.size());
+    size_t                           idx = 0;
+    for (auto recipient : recipients) {
+        jobs[idx].recipient = recipient;
+        jobs[idx].key = encrypted_recipient_key(handler, recipient);
+        jobs[idx].ret = jobs[idx].key ? RNP_SUCCESS : RNP_ERROR_NO_SUITABLE_KEY;
+        if (jobs[idx].ret) {
+            encrypted_log_recipient_error(recipient, jobs[idx].ret);
+            return jobs[idx].ret;
+        }
+        jobs[idx].bkey = encrypted_cached_pubkey(param->ctx, jobs[idx].key);
+        idx++;
+    }
+
+    /* random generator of the operation context may not be shared between threads */
+    pgp_symm_alg_t    ealg = param->ctx->ealg;
+    rnp_worker_rngs_t rngs(rnp_worker_count(threads, jobs.size()));
+    rnp_run_workers(threads, jobs.size(), [&](size_t idx, size_t worker) {
+        pgp_recipient_job_t &job = jobs[idx];
+        rng_t *              rng = rngs.get(worker);
+        if (!rng) {
+            job.ret = RNP_ERROR_RNG;
+            return;
+        }
+        try {
+            job.ret = encrypted_encrypt_sesskey(
+              rng, job.key, job.bkey, ealg, key, keylen, job.pkey);
+        } catch (const std::exception &e) {
+            RNP_LOG("%s", e.what());
+            job.ret = RNP_ERROR_GENERIC;
+        }
+    });
+
+    for (auto &job : jobs) {
+        if (job.ret) {
+            encrypted_log_recipient_error(job.recipient, job.ret);
+            return job.ret;
+        }
+        rnp_result_t ret = encrypted_write_sesskey(param, job.pkey);
+        if (ret) {
+            return ret;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
 static bool
 encrypted_sesk_set_ad(pgp_crypt_t *crypt, pgp_sk_sesskey_t *skey)
 {
@@ -800,8 +1033,15 @@ encrypted_start_aead(pgp_dest_encrypted_param_t *param, uint8_t *enckey)
     return encrypted_start_aead_chunk(param, 0, false);
 }
 
+/** @brief initialize encrypting stream
+ *  @param datalen length of the data which will be written to the stream, if known in advance
+ *         then definite-length packet will be used. 0 if not known.
+ **/
 static rnp_result_t
-init_encrypted_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writedst)
+init_encrypted_dst(pgp_write_handler_t *handler,
+                   pgp_dest_t *         dst,
+                   pgp_dest_t *         writedst,
+                   uint64_t             datalen = 0)
 {
     pgp_dest_encrypted_param_t *param;
     bool                        singlepass = true;
@@ -867,11 +1107,9 @@ init_encrypted_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *wr
     }
 
     /* Configuring and writing pk-encrypted session keys */
-    for (auto recipient : handler->ctx->recipients) {
-        ret = encrypted_add_recipient(handler, dst, recipient, enckey.data(), keylen);
-        if (ret) {
-            goto finish;
-        }
+    ret = encrypted_add_recipients(handler, dst, enckey.data(), keylen);
+    if (ret) {
+        goto finish;
     }
 
     /* Configuring and writing sk-encrypted session key(s) */
@@ -887,8 +1125,24 @@ init_encrypted_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *wr
     param->pkt.indeterminate = false;
     if (param->aead) {
         param->pkt.tag = PGP_PKT_AEAD_ENCRYPTED;
+        /* header, non-empty chunks with tags and the final tag */
+        uint64_t chunklen = 1ULL << (handler->ctx->abits + 6);
+        uint64_t chunks = datalen / chunklen + !!(datalen % chunklen);
+        uint64_t pktlen = 4 + pgp_cipher_aead_nonce_len(param->aalg) + datalen +
+                          (chunks + 1) * pgp_cipher_aead_tag_len(param->aalg);
+        if (datalen && (pktlen <= PGP_MAX_DEFINITE_LEN)) {
+            param->pkt.partial = false;
+            param->pkt.len = pktlen;
+        }
     } else {
         param->pkt.tag = param->has_mdc ? PGP_PKT_SE_IP_DATA : PGP_PKT_SE_DATA;
+        /* version, iv with check bytes, data and mdc packet */
+        uint64_t pktlen = 1 + pgp_block_size(handler->ctx->ealg) + 2 + datalen + 2 +
+                          PGP_SHA1_HASH_SIZE;
+        if (datalen && param->has_mdc && (pktlen <= PGP_MAX_DEFINITE_LEN)) {
+            param->pkt.partial = false;
+            param->pkt.len = pktlen;
+        }
     }
 
     /* initializing partial data length writer */
@@ -928,8 +1182,6 @@ cleartext_dst_writeline(pgp_dest_signed_param_t *param,
                         size_t                   len,
                         bool                     eol)
 {
-    const uint8_t *ptr;
-
     /* dash-escaping line if needed */
     if (param->clr_start && len &&
         ((buf[0] == CH_DASH) || ((len >= 4) && !strncmp((const char *) buf, ST_FROM, 4)))) {
@@ -940,20 +1192,18 @@ cleartext_dst_writeline(pgp_dest_signed_param_t *param,
     dst_write(param->writedst, buf, len);
 
     if (eol) {
-        bool hashcrlf = false;
-        ptr = buf + len - 1;
-
-        /* skipping trailing characters - space, tab, carriage return, line feed */
-        while ((ptr >= buf) && ((*ptr == CH_SPACE) || (*ptr == CH_TAB) || (*ptr == CH_CR) ||
-                                (*ptr == CH_LF))) {
-            if (*ptr == CH_LF) {
-                hashcrlf = true;
-            }
-            ptr--;
+        /* cleartext_dst_scanline() ends the line at the first LF, so it may be only last */
+        bool   hashcrlf = len && (buf[len - 1] == CH_LF);
+        size_t bodylen = hashcrlf ? len - 1 : len;
+
+        /* skipping trailing characters - space, tab, carriage return */
+        while (bodylen && ((buf[bodylen - 1] == CH_SPACE) || (buf[bodylen - 1] == CH_TAB) ||
+                           (buf[bodylen - 1] == CH_CR))) {
+            bodylen--;
         }
 
         /* hashing line body and \r\n */
-        pgp_hash_list_update(param->hashes, buf, ptr + 1 - buf);
+        pgp_hash_list_update(param->hashes, buf, bodylen);
         if (hashcrlf) {
             pgp_hash_list_update(param->hashes, ST_CRLF, 2);
         }
@@ -968,19 +1218,11 @@ cleartext_dst_writeline(pgp_dest_signed_param_t *param,
 static size_t
 cleartext_dst_scanline(const uint8_t *buf, size_t len, bool *eol)
 {
-    for (const uint8_t *ptr = buf, *end = buf + len; ptr < end; ptr++) {
-        if (*ptr == CH_LF) {
-            if (eol) {
-                *eol = true;
-            }
-            return ptr - buf + 1;
-        }
-    }
-
+    const uint8_t *ptr = (const uint8_t *) memchr(buf, CH_LF, len);
     if (eol) {
-        *eol = false;
+        *eol = ptr != NULL;
     }
-    return len;
+    return ptr ? ptr - buf + 1 : len;
 }
 
 static rnp_result_t
@@ -1076,8 +1318,12 @@ signed_fill_signature(pgp_dest_signed_param_t *param,
     }
 
     /* decrypt the secret key if needed */
-    if (signer->key->encrypted()) {
-        deckey = pgp_decrypt_seckey(signer->key, param->password_provider, &ctx);
+    bool decrypt = !signer->seckey && signer->key->encrypted();
+    if (signer->seckey) {
+        deckey = signer->seckey;
+    } else if (decrypt) {
+        deckey = pgp_decrypt_seckey_cached(
+          param->ctx->keycache, signer->key, param->password_provider, &ctx);
         if (!deckey) {
             RNP_LOG("wrong secret key password");
             pgp_hash_finish(&hash, NULL);
@@ -1091,7 +1337,7 @@ signed_fill_signature(pgp_dest_signed_param_t *param,
     ret = signature_calculate(sig, &deckey->material, &hash, rnp_ctx_rng_handle(param->ctx));
 
     /* destroy decrypted secret key */
-    if (signer->key->encrypted()) {
+    if (decrypt) {
         delete deckey;
     }
     return ret;
@@ -1224,6 +1470,7 @@ signed_add_signer(pgp_dest_signed_param_t *param, rnp_signer_info_t *signer, boo
 
     /* copy fields */
     sinfo.key = signer->key;
+    sinfo.seckey = signer->seckey;
     sinfo.sigcreate = signer->sigcreate;
     sinfo.sigexpire = signer->sigexpire;
 
@@ -1361,6 +1608,124 @@ finish:
     return ret;
 }
 
+static pgp_deflate_block_t
+parallel_deflate_block(const std::vector<uint8_t> &in,
+                       const std::vector<uint8_t> &dict,
+                       int                         level,
+                       bool                        last)
+{
+    pgp_deflate_block_t res;
+    z_stream            z = {};
+
+    res.inlen = in.size();
+    res.adler = adler32(adler32(0, Z_NULL, 0), in.data(), in.size());
+    /* raw deflate: headers and checksum of the whole stream are written by the caller */
+    if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        RNP_LOG("failed to init zlib");
+        return res;
+    }
+    if (!dict.empty() && (deflateSetDictionary(&z, dict.data(), dict.size()) != Z_OK)) {
+        RNP_LOG("failed to set deflate dictionary");
+        deflateEnd(&z);
+        return res;
+    }
+
+    /* non-last block is ended with sync flush to be byte-aligned and concatenable */
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    res.out.resize(deflateBound(&z, in.size()) + 16);
+    z.next_in = (Bytef *) in.data();
+    z.avail_in = in.size();
+    z.next_out = res.out.data();
+    z.avail_out = res.out.size();
+    int zret;
+    do {
+        if (!z.avail_out) {
+            size_t outlen = res.out.size();
+            res.out.resize(outlen * 2);
+            z.next_out = res.out.data() + outlen;
+            z.avail_out = res.out.size() - outlen;
+        }
+        zret = deflate(&z, flush);
+    } while ((zret == Z_OK) && (last || z.avail_in || !z.avail_out));
+
+    res.ok = last ? (zret == Z_STREAM_END) : (zret == Z_OK) || (zret == Z_BUF_ERROR);
+    res.out.resize(res.out.size() - z.avail_out);
+    deflateEnd(&z);
+    if (!res.ok) {
+        RNP_LOG("deflate failed with error %d", zret);
+    }
+    return res;
+}
+
+static rnp_result_t
+parallel_deflate_flush(pgp_dest_compressed_param_t *param, size_t maxjobs)
+{
+    pgp_parallel_deflate_t *par = param->par;
+
+    while (par->jobs.size() > maxjobs) {
+        pgp_deflate_block_t blk = par->jobs.front().get();
+        par->jobs.pop_front();
+        if (!blk.ok) {
+            return RNP_ERROR_BAD_STATE;
+        }
+        par->adler = adler32_combine(par->adler, blk.adler, blk.inlen);
+        dst_write(param->pkt.writedst, blk.out.data(), blk.out.size());
+        if (param->pkt.writedst->werr) {
+            return param->pkt.writedst->werr;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
+static rnp_result_t
+parallel_deflate_submit(pgp_dest_compressed_param_t *param, bool last)
+{
+    pgp_parallel_deflate_t *par = param->par;
+
+    try {
+        std::vector<uint8_t> dict = par->dict;
+        size_t dictlen = std::min(par->block.size(), (size_t) PGP_DEFLATE_DICT_SIZE);
+        par->dict.assign(par->block.end() - dictlen, par->block.end());
+        auto task = std::make_shared<std::packaged_task<pgp_deflate_block_t()>>(
+          std::bind(parallel_deflate_block,
+                    std::move(par->block),
+                    std::move(dict),
+                    par->level,
+                    last));
+        par->jobs.push_back(task->get_future());
+        par->pool.submit([task]() { (*task)(); });
+        par->block.clear();
+        par->block.reserve(PGP_PARALLEL_DEFLATE_BLOCK);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+    /* do not keep more blocks in flight than we have threads */
+    return parallel_deflate_flush(param, last ? 0 : std::max(par->pool.size(), (size_t) 1));
+}
+
+static rnp_result_t
+parallel_deflate_write(pgp_dest_compressed_param_t *param, const void *buf, size_t len)
+{
+    pgp_parallel_deflate_t *par = param->par;
+    const uint8_t *         ptr = (const uint8_t *) buf;
+
+    while (len > 0) {
+        size_t part = std::min(len, PGP_PARALLEL_DEFLATE_BLOCK - par->block.size());
+        par->block.insert(par->block.end(), ptr, ptr + part);
+        ptr += part;
+        len -= part;
+        if (par->block.size() < PGP_PARALLEL_DEFLATE_BLOCK) {
+            break;
+        }
+        rnp_result_t ret = parallel_deflate_submit(param, false);
+        if (ret) {
+            return ret;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
 static rnp_result_t
 compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -1372,6 +1737,10 @@ compressed_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    if (param->par) {
+        return parallel_deflate_write(param, buf, len);
+    }
+
     if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
         param->z.next_in = (unsigned char *) buf;
         param->z.avail_in = len;
@@ -1437,7 +1806,18 @@ compressed_dst_finish(pgp_dest_t *dst)
     int                          zret;
     pgp_dest_compressed_param_t *param = (pgp_dest_compressed_param_t *) dst->param;
 
-    if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
+    if (param->par) {
+        rnp_result_t ret = parallel_deflate_submit(param, true);
+        if (ret) {
+            return ret;
+        }
+        if (param->alg == PGP_C_ZLIB) {
+            /* zlib trailer: adler32 of the uncompressed data, big-endian */
+            uint8_t trailer[4];
+            STORE32BE(trailer, param->par->adler);
+            dst_write(param->pkt.writedst, trailer, sizeof(trailer));
+        }
+    } else if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
         param->z.next_in = Z_NULL;
         param->z.avail_in = 0;
         param->z.next_out = param->cache + param->len;
@@ -1506,7 +1886,7 @@ compressed_dst_close(pgp_dest_t *dst, bool discard)
     }
 
     if (param->zstarted) {
-        if ((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) {
+        if (((param->alg == PGP_C_ZIP) || (param->alg == PGP_C_ZLIB)) && !param->par) {
             deflateEnd(&param->z);
         }
 #ifdef HAVE_BZLIB_H
@@ -1516,11 +1896,39 @@ compressed_dst_close(pgp_dest_t *dst, bool discard)
 #endif
     }
 
+    /* this will wait for the outstanding blocks */
+    delete param->par;
+    param->par = NULL;
+
     close_streamed_packet(&param->pkt, discard);
     free(param);
     dst->param = NULL;
 }
 
+static rnp_result_t
+init_parallel_deflate(pgp_write_handler_t *handler, pgp_dest_compressed_param_t *param)
+{
+    try {
+        param->par = new pgp_parallel_deflate_t(handler->ctx->zthreads);
+        param->par->level = handler->ctx->zlevel;
+        param->par->adler = adler32(0, Z_NULL, 0);
+        param->par->block.reserve(PGP_PARALLEL_DEFLATE_BLOCK);
+    } catch (const std::exception &e) {
+        RNP_LOG("%s", e.what());
+        return RNP_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (param->alg == PGP_C_ZLIB) {
+        /* zlib header for 32k window, the same as deflateInit() would write */
+        int level = param->par->level == Z_DEFAULT_COMPRESSION ? 6 : param->par->level;
+        int lflags = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        uint8_t hdr[2] = {0x78, (uint8_t)(lflags << 6)};
+        hdr[1] += 31 - ((hdr[0] << 8) + hdr[1]) % 31;
+        dst_write(param->pkt.writedst, hdr, sizeof(hdr));
+    }
+    return RNP_SUCCESS;
+}
+
 static rnp_result_t
 init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writedst)
 {
@@ -1558,6 +1966,13 @@ init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *w
     switch (param->alg) {
     case PGP_C_ZIP:
     case PGP_C_ZLIB:
+        if (handler->ctx->zthreads > 1) {
+            ret = init_parallel_deflate(handler, param);
+            if (ret) {
+                goto finish;
+            }
+            break;
+        }
         (void) memset(&param->z, 0x0, sizeof(param->z));
         if (param->alg == PGP_C_ZIP) {
             zret = deflateInit2(
@@ -1589,6 +2004,7 @@ init_compressed_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *w
         goto finish;
     }
     param->zstarted = true;
+    handler->ctx->zused = param->alg;
     ret = RNP_SUCCESS;
 finish:
     if (ret != RNP_SUCCESS) {
@@ -1598,6 +2014,40 @@ finish:
     return ret;
 }
 
+static bool
+compression_enabled(pgp_write_handler_t *handler, pgp_source_t *src)
+{
+    rnp_ctx_t *ctx = handler->ctx;
+    if (ctx->zlevel <= 0) {
+        return false;
+    }
+    /* data is not available in advance if it is pushed to the stream */
+    if (!ctx->zauto || !src) {
+        return true;
+    }
+
+    /* estimate order-0 entropy of the first bytes: compressed/encrypted data is close to 8 */
+    uint8_t *sample = (uint8_t *) malloc(PGP_COMPRESS_SAMPLE_SIZE);
+    size_t   read = 0;
+    if (!sample || !src_peek(src, sample, PGP_COMPRESS_SAMPLE_SIZE, &read) || !read) {
+        free(sample);
+        return true;
+    }
+    size_t freq[256] = {0};
+    for (size_t i = 0; i < read; i++) {
+        freq[sample[i]]++;
+    }
+    free(sample);
+    double entropy = 0;
+    for (size_t i = 0; i < 256; i++) {
+        if (freq[i]) {
+            double p = (double) freq[i] / read;
+            entropy -= p * log2(p);
+        }
+    }
+    return entropy <= PGP_COMPRESS_MAX_ENTROPY;
+}
+
 static rnp_result_t
 literal_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 {
@@ -1608,6 +2058,11 @@ literal_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
         return RNP_ERROR_BAD_PARAMETERS;
     }
 
+    param->written += len;
+    if (!param->partial && (param->written > param->len)) {
+        RNP_LOG("literal data is larger than expected");
+        return RNP_ERROR_WRITE;
+    }
     dst_write(param->writedst, buf, len);
     return RNP_SUCCESS;
 }
@@ -1615,7 +2070,12 @@ literal_dst_write(pgp_dest_t *dst, const void *buf, size_t len)
 static rnp_result_t
 literal_dst_finish(pgp_dest_t *dst)
 {
-    return finish_streamed_packet((pgp_dest_packet_param_t *) dst->param);
+    pgp_dest_packet_param_t *param = (pgp_dest_packet_param_t *) dst->param;
+    if (!param->partial && (param->written != param->len)) {
+        RNP_LOG("literal data is shorter than expected");
+        return RNP_ERROR_WRITE;
+    }
+    return finish_streamed_packet(param);
 }
 
 static void
@@ -1632,8 +2092,28 @@ literal_dst_close(pgp_dest_t *dst, bool discard)
     dst->param = NULL;
 }
 
+/** @brief get the literal packet body length, if source size is known in advance */
+static bool
+literal_packet_body_len(pgp_write_handler_t *handler, pgp_source_t *src, uint64_t *len)
+{
+    if (!src || !src->knownsize || (src->readb > src->size)) {
+        return false;
+    }
+    /* format, filename length, filename, timestamp and data */
+    size_t flen = std::min(handler->ctx->filename.size(), (size_t) 255);
+    *len = 1 + 1 + flen + 4 + (src->size - src->readb);
+    return *len <= PGP_MAX_DEFINITE_LEN;
+}
+
+/** @brief initialize literal data stream
+ *  @param src source of the data, if its size is known then definite-length packet is written
+ *         instead of the partial one. May be NULL.
+ **/
 static rnp_result_t
-init_literal_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writedst)
+init_literal_dst(pgp_write_handler_t *handler,
+                 pgp_dest_t *         dst,
+                 pgp_dest_t *         writedst,
+                 pgp_source_t *       src)
 {
     pgp_dest_packet_param_t *param;
     rnp_result_t             ret = RNP_ERROR_GENERIC;
@@ -1649,7 +2129,7 @@ init_literal_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writ
     dst->finish = literal_dst_finish;
     dst->close = literal_dst_close;
     dst->type = PGP_STREAM_LITERAL;
-    param->partial = true;
+    param->partial = !literal_packet_body_len(handler, src, &param->len);
     param->indeterminate = false;
     param->tag = PGP_PKT_LITDATA;
 
@@ -1675,6 +2155,7 @@ init_literal_dst(pgp_write_handler_t *handler, pgp_dest_t *dst, pgp_dest_t *writ
     /* timestamp */
     STORE32BE(buf, handler->ctx->filemtime);
     dst_write(param->writedst, buf, 4);
+    param->written = 1 + 1 + flen + 4;
     ret = RNP_SUCCESS;
 finish:
     if (ret != RNP_SUCCESS) {
@@ -1684,30 +2165,71 @@ finish:
     return ret;
 }
 
+rnp_result_t
+rnp_write_stream_feed(pgp_write_stream_t *stream, const void *buf, size_t len)
+{
+    if (!len) {
+        return RNP_SUCCESS;
+    }
+    if (stream->sstream) {
+        signed_dst_update(stream->sstream, buf, len);
+    }
+    if (!stream->wstream) {
+        return RNP_SUCCESS;
+    }
+    dst_write(stream->wstream, buf, len);
+    for (int i = stream->destc - 1; i >= 0; i--) {
+        if (stream->dests[i].werr != RNP_SUCCESS) {
+            RNP_LOG("failed to process data");
+            return RNP_ERROR_WRITE;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
+rnp_result_t
+rnp_write_stream_finish(pgp_write_stream_t *stream)
+{
+    for (int i = stream->destc - 1; i >= 0; i--) {
+        rnp_result_t ret = dst_finish(&stream->dests[i]);
+        if (ret != RNP_SUCCESS) {
+            RNP_LOG("failed to finish stream");
+            return ret;
+        }
+    }
+    return RNP_SUCCESS;
+}
+
+void
+rnp_write_stream_close(pgp_write_stream_t *stream, bool discard)
+{
+    for (int i = stream->destc - 1; i >= 0; i--) {
+        dst_close(&stream->dests[i], discard);
+    }
+    stream->destc = 0;
+}
+
+static void
+write_stream_set_stats(pgp_write_stream_t *stream)
+{
+    for (int i = 0; i < stream->destc; i++) {
+        stream->dests[i].stats = stream->stats;
+    }
+}
+
 static rnp_result_t
-process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count)
+process_stream_sequence(pgp_source_t *src, pgp_write_stream_t *stream)
 {
     uint8_t *    readbuf = NULL;
-    pgp_dest_t * sstream = NULL; /* signed stream if any, to call signed_dst_update on it */
-    pgp_dest_t * wstream = NULL; /* stream to dst_write() source data, may be empty */
     rnp_result_t ret = RNP_ERROR_GENERIC;
 
+    write_stream_set_stats(stream);
     if (!(readbuf = (uint8_t *) calloc(1, PGP_INPUT_CACHE_SIZE))) {
         RNP_LOG("allocation failure");
         ret = RNP_ERROR_OUT_OF_MEMORY;
         goto finish;
     }
 
-    /* check whether we have signed stream and stream for data output */
-    for (int i = count - 1; i >= 0; i--) {
-        if (streams[i].type == PGP_STREAM_SIGNED) {
-            sstream = &streams[i];
-        } else if ((streams[i].type == PGP_STREAM_CLEARTEXT) ||
-                   (streams[i].type == PGP_STREAM_LITERAL)) {
-            wstream = &streams[i];
-        }
-    }
-
     /* processing source stream */
     while (!src->eof) {
         size_t read = 0;
@@ -1715,95 +2237,94 @@ process_stream_sequence(pgp_source_t *src, pgp_dest_t *streams, unsigned count)
             RNP_LOG("failed to read from source");
             ret = RNP_ERROR_READ;
             goto finish;
-        } else if (!read) {
-            continue;
-        }
-
-        if (sstream) {
-            signed_dst_update(sstream, readbuf, read);
         }
-
-        if (wstream) {
-            dst_write(wstream, readbuf, read);
-
-            for (int i = count - 1; i >= 0; i--) {
-                if (streams[i].werr != RNP_SUCCESS) {
-                    RNP_LOG("failed to process data");
-                    ret = RNP_ERROR_WRITE;
-                    goto finish;
-                }
-            }
-        }
-    }
-
-    /* finalizing destinations */
-    for (int i = count - 1; i >= 0; i--) {
-        ret = dst_finish(&streams[i]);
-        if (ret != RNP_SUCCESS) {
-            RNP_LOG("failed to finish stream");
+        if ((ret = rnp_write_stream_feed(stream, readbuf, read))) {
             goto finish;
         }
     }
 
-    ret = RNP_SUCCESS;
+    /* finalizing destinations */
+    ret = rnp_write_stream_finish(stream);
 finish:
     free(readbuf);
     return ret;
 }
 
-rnp_result_t
-rnp_encrypt_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+/* push the next stream to the stack, writing to the previous one or to the output */
+static pgp_dest_t *
+write_stream_top(pgp_write_stream_t *stream, pgp_dest_t *dst)
+{
+    if (!stream->destc) {
+        return dst;
+    }
+    /* set stats before the next stream is pushed, so its internal writers may inherit them */
+    pgp_dest_t *top = &stream->dests[stream->destc - 1];
+    top->stats = stream->stats;
+    return top;
+}
+
+static rnp_result_t
+init_encrypt_streams(pgp_write_handler_t *handler,
+                     pgp_write_stream_t * stream,
+                     pgp_source_t *       src,
+                     pgp_dest_t *         dst)
 {
     /* stack of the streams would be as following:
        [armoring stream] - if armoring is enabled
        encrypting stream, partial writing stream
        [compressing stream, partial writing stream] - if compression is enabled
        literal data stream, partial writing stream
+       If source size is known and compression is not used then definite-length packets are
+       written instead of the partial ones.
     */
-    pgp_dest_t   dests[4];
-    int          destc = 0;
     rnp_result_t ret = RNP_ERROR_GENERIC;
+    bool         compress = compression_enabled(handler, src);
+    uint64_t     litlen = 0;
+    uint64_t     enclen = 0;
+
+    if (!compress && literal_packet_body_len(handler, src, &litlen)) {
+        enclen = definite_packet_len(litlen);
+    }
 
     /* pushing armoring stream, which will write to the output */
     if (handler->ctx->armor) {
-        if ((ret = init_armored_dst(&dests[destc], dst, PGP_ARMORED_MESSAGE))) {
-            goto finish;
+        ret = init_armored_dst(&stream->dests[stream->destc], dst, PGP_ARMORED_MESSAGE);
+        if (ret) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* pushing encrypting stream, which will write to the output or armoring stream */
-    if ((ret = init_encrypted_dst(handler, &dests[destc], destc ? &dests[destc - 1] : dst))) {
-        goto finish;
+    if ((ret = init_encrypted_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst), enclen))) {
+        return ret;
     }
-    destc++;
+    stream->destc++;
 
     /* if compression is enabled then pushing compressing stream */
-    if (handler->ctx->zlevel > 0) {
-        if ((ret = init_compressed_dst(handler, &dests[destc], &dests[destc - 1]))) {
-            goto finish;
+    if (compress) {
+        if ((ret = init_compressed_dst(
+               handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* pushing literal data stream */
-    if ((ret = init_literal_dst(handler, &dests[destc], &dests[destc - 1]))) {
-        goto finish;
-    }
-    destc++;
-
-    /* processing stream sequence */
-    ret = process_stream_sequence(src, dests, destc);
-finish:
-    for (int i = destc - 1; i >= 0; i--) {
-        dst_close(&dests[i], ret != RNP_SUCCESS);
+    if ((ret = init_literal_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst), src))) {
+        return ret;
     }
-
-    return ret;
+    stream->wstream = &stream->dests[stream->destc++];
+    return RNP_SUCCESS;
 }
 
-rnp_result_t
-rnp_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+static rnp_result_t
+init_sign_streams(pgp_write_handler_t *handler,
+                  pgp_write_stream_t * stream,
+                  pgp_source_t *       src,
+                  pgp_dest_t *         dst)
 {
     /* stack of the streams would be as following:
        [armoring stream] - if armoring is enabled
@@ -1811,56 +2332,57 @@ rnp_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
        signing stream
        literal data stream, partial writing stream - if not detached or cleartext signature
     */
-    pgp_dest_t   dests[4];
-    unsigned     destc = 0;
     rnp_result_t ret = RNP_ERROR_GENERIC;
 
     /* pushing armoring stream, which will write to the output */
     if (handler->ctx->armor && !handler->ctx->clearsign) {
         pgp_armored_msg_t msgt =
           handler->ctx->detached ? PGP_ARMORED_SIGNATURE : PGP_ARMORED_MESSAGE;
-        ret = init_armored_dst(&dests[destc], dst, msgt);
-        if (ret != RNP_SUCCESS) {
-            goto finish;
+        if ((ret = init_armored_dst(&stream->dests[stream->destc], dst, msgt))) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* if compression is enabled then pushing compressing stream */
-    if (!handler->ctx->detached && !handler->ctx->clearsign && (handler->ctx->zlevel > 0)) {
-        if ((ret =
-               init_compressed_dst(handler, &dests[destc], destc ? &dests[destc - 1] : dst))) {
-            goto finish;
+    if (!handler->ctx->detached && !handler->ctx->clearsign &&
+        compression_enabled(handler, src)) {
+        if ((ret = init_compressed_dst(
+               handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* pushing signing stream, which will use handler->ctx to distinguish between
      * attached/detached/cleartext signature */
-    if ((ret = init_signed_dst(handler, &dests[destc], destc ? &dests[destc - 1] : dst))) {
-        goto finish;
+    if ((ret = init_signed_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+        return ret;
+    }
+    if (handler->ctx->clearsign) {
+        /* cleartext stream hashes data by itself */
+        stream->wstream = &stream->dests[stream->destc++];
+    } else {
+        stream->sstream = &stream->dests[stream->destc++];
     }
-    destc++;
 
     /* pushing literal data stream, if not detached/cleartext signature */
     if (!handler->ctx->detached && !handler->ctx->clearsign) {
-        if ((ret = init_literal_dst(handler, &dests[destc], &dests[destc - 1]))) {
-            goto finish;
+        if ((ret = init_literal_dst(
+               handler, &stream->dests[stream->destc], write_stream_top(stream, dst), src))) {
+            return ret;
         }
-        destc++;
-    }
-
-    /* process source with streams stack */
-    ret = process_stream_sequence(src, dests, destc);
-finish:
-    for (int i = destc - 1; i >= 0; i--) {
-        dst_close(&dests[i], ret != RNP_SUCCESS);
+        stream->wstream = &stream->dests[stream->destc++];
     }
-    return ret;
+    return RNP_SUCCESS;
 }
 
-rnp_result_t
-rnp_encrypt_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+static rnp_result_t
+init_encrypt_sign_streams(pgp_write_handler_t *handler,
+                          pgp_write_stream_t * stream,
+                          pgp_source_t *       src,
+                          pgp_dest_t *         dst)
 {
     /* stack of the streams would be as following:
        [armoring stream] - if armoring is enabled
@@ -1869,8 +2391,6 @@ rnp_encrypt_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t
        signing stream
        literal data stream, partial writing stream
     */
-    pgp_dest_t   dests[5];
-    unsigned     destc = 0;
     rnp_result_t ret = RNP_SUCCESS;
 
     /* we may use only attached signatures here */
@@ -1881,48 +2401,120 @@ rnp_encrypt_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t
 
     /* pushing armoring stream, which will write to the output */
     if (handler->ctx->armor) {
-        ret = init_armored_dst(&dests[destc], dst, PGP_ARMORED_MESSAGE);
-        if (ret != RNP_SUCCESS) {
-            goto finish;
+        ret = init_armored_dst(&stream->dests[stream->destc], dst, PGP_ARMORED_MESSAGE);
+        if (ret) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* pushing encrypting stream, which will write to the output or armoring stream */
-    if ((ret = init_encrypted_dst(handler, &dests[destc], destc ? &dests[destc - 1] : dst))) {
-        goto finish;
+    if ((ret = init_encrypted_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+        return ret;
     }
-    destc++;
+    stream->destc++;
 
     /* if compression is enabled then pushing compressing stream */
-    if (handler->ctx->zlevel > 0) {
-        if ((ret = init_compressed_dst(handler, &dests[destc], &dests[destc - 1]))) {
-            goto finish;
+    if (compression_enabled(handler, src)) {
+        if ((ret = init_compressed_dst(
+               handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+            return ret;
         }
-        destc++;
+        stream->destc++;
     }
 
     /* pushing signing stream */
-    if ((ret = init_signed_dst(handler, &dests[destc], &dests[destc - 1]))) {
-        goto finish;
+    if ((ret = init_signed_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst)))) {
+        return ret;
     }
-    destc++;
+    stream->sstream = &stream->dests[stream->destc++];
 
     /* pushing literal data stream */
-    if ((ret = init_literal_dst(handler, &dests[destc], &dests[destc - 1]))) {
-        goto finish;
+    if ((ret = init_literal_dst(
+           handler, &stream->dests[stream->destc], write_stream_top(stream, dst), src))) {
+        return ret;
     }
-    destc++;
+    stream->wstream = &stream->dests[stream->destc++];
+    return RNP_SUCCESS;
+}
 
-    /* process source with streams stack */
-    ret = process_stream_sequence(src, dests, destc);
-finish:
-    for (int i = destc - 1; i >= 0; i--) {
-        dst_close(&dests[i], ret != RNP_SUCCESS);
+rnp_result_t
+rnp_write_stream_init(pgp_write_handler_t *handler,
+                      pgp_write_stream_t * stream,
+                      pgp_dest_t *         dst,
+                      bool                 encrypt,
+                      bool                 sign)
+{
+    rnp_result_t ret = RNP_ERROR_BAD_PARAMETERS;
+    memset(stream, 0, sizeof(*stream));
+    stream->stats = handler->ctx->stats;
+    handler->ctx->zused = PGP_C_NONE;
+    if (encrypt && sign) {
+        ret = init_encrypt_sign_streams(handler, stream, NULL, dst);
+    } else if (encrypt) {
+        ret = init_encrypt_streams(handler, stream, NULL, dst);
+    } else if (sign) {
+        ret = init_sign_streams(handler, stream, NULL, dst);
+    }
+    if (ret) {
+        rnp_write_stream_close(stream, true);
+    } else {
+        write_stream_set_stats(stream);
     }
     return ret;
 }
 
+typedef rnp_result_t init_streams_func_t(pgp_write_handler_t *handler,
+                                         pgp_write_stream_t * stream,
+                                         pgp_source_t *       src,
+                                         pgp_dest_t *         dst);
+
+static rnp_result_t
+process_write_streams(pgp_write_handler_t *handler,
+                      pgp_source_t *       src,
+                      pgp_dest_t *         dst,
+                      init_streams_func_t *init_streams)
+{
+    pgp_write_stream_t  stream = {};
+    pgp_stream_stats_t *srcstats = src->stats;
+    pgp_stream_stats_t *dststats = dst->stats;
+
+    stream.stats = src->stats = dst->stats = handler->ctx->stats;
+    handler->ctx->zused = PGP_C_NONE;
+    rnp_result_t ret = init_streams(handler, &stream, src, dst);
+    if (!ret) {
+        ret = process_stream_sequence(src, &stream);
+    }
+    rnp_write_stream_close(&stream, ret != RNP_SUCCESS);
+    if (dst->stats) {
+        /* account cached output data as well */
+        dst_flush(dst);
+    }
+    src->stats = srcstats;
+    dst->stats = dststats;
+    return ret;
+}
+
+rnp_result_t
+rnp_encrypt_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+{
+    return process_write_streams(handler, src, dst, init_encrypt_streams);
+}
+
+rnp_result_t
+rnp_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+{
+    return process_write_streams(handler, src, dst, init_sign_streams);
+}
+
+rnp_result_t
+rnp_encrypt_sign_src(pgp_write_handler_t *handler, pgp_source_t *src, pgp_dest_t *dst)
+{
+    return process_write_streams(handler, src, dst, init_encrypt_sign_streams);
+}
+
 rnp_result_t
 rnp_compress_src(pgp_source_t &src, pgp_dest_t &dst, pgp_compression_type_t zalg, int zlevel)
 {
@@ -1953,7 +2545,7 @@ rnp_wrap_src(pgp_source_t &src, pgp_dest_t &dst, const std::string &filename, ui
     handler.ctx = &ctx;
 
     pgp_dest_t   literal = {};
-    rnp_result_t ret = init_literal_dst(&handler, &literal, &dst);
+    rnp_result_t ret = init_literal_dst(&handler, &literal, &dst, &src);
     if (ret) {
         goto done;
     }
@@ -69,6 +69,40 @@ rnp_result_t rnp_encrypt_sign_src(pgp_write_handler_t *handler,
                                   pgp_source_t *       src,
                                   pgp_dest_t *         dst);
 
+/* stack of the writing streams, which may be fed with data incrementally */
+typedef struct pgp_write_stream_t {
+    pgp_dest_t          dests[5];
+    int                 destc;
+    pgp_dest_t *        sstream; /* signing stream for signed_dst_update(), may be NULL */
+    pgp_dest_t *        wstream; /* stream to dst_write() source data, may be NULL */
+    pgp_stream_stats_t *stats;   /* per-layer counters for the streams, may be NULL */
+} pgp_write_stream_t;
+
+/** @brief initialize stack of the streams to encrypt and/or sign data, which will be pushed
+ *         later via rnp_write_stream_feed(). Since source size is not known in advance,
+ *         partial-length packets are used, and automatic compression bypass is not applied.
+ *  @param handler handler with the processing parameters, including rnp_ctx_t
+ *  @param stream stream stack to initialize. Must be closed via rnp_write_stream_close().
+ *  @param dst output destination
+ *  @param encrypt whether data should be encrypted
+ *  @param sign whether data should be signed, signature type is controlled by rnp_ctx_t
+ **/
+rnp_result_t rnp_write_stream_init(pgp_write_handler_t *handler,
+                                   pgp_write_stream_t * stream,
+                                   pgp_dest_t *         dst,
+                                   bool                 encrypt,
+                                   bool                 sign);
+
+/** @brief process the next portion of the data. Output is written to the destination
+ *         as soon as it is produced by the streams.
+ **/
+rnp_result_t rnp_write_stream_feed(pgp_write_stream_t *stream, const void *buf, size_t len);
+
+/** @brief finalize the streams: flush the cached data and write signatures/trailers */
+rnp_result_t rnp_write_stream_finish(pgp_write_stream_t *stream);
+
+void rnp_write_stream_close(pgp_write_stream_t *stream, bool discard);
+
 /* Following functions are used only in tests currently. Later could be used in CLI for debug
  * commands like --wrap-literal, --encrypt-raw, --compress-raw, etc. */
 
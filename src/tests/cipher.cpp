@@ -34,6 +34,8 @@
 #include "rnp_tests.h"
 #include "support.h"
 #include "fingerprint.h"
+#include <botan/ffi.h>
+#include <chrono>
 
 extern rng_t global_rng;
 
@@ -638,6 +640,68 @@ TEST_F(rnp_tests, s2k_iteration_tuning)
     /// TODO test that hashing iters_xx data takes roughly requested time
 }
 
+TEST_F(rnp_tests, s2k_iteration_tuning_cache)
+{
+    const size_t TRIAL_MSEC = 100;
+    const size_t iters = pgp_s2k_compute_iters(PGP_HASH_SHA256, 100, TRIAL_MSEC);
+    assert_true(iters > 0);
+
+    /* subsequent calls reuse the measurement instead of hashing for trial_msec */
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 10; i++) {
+        assert_int_equal(pgp_s2k_compute_iters(PGP_HASH_SHA256, 100, TRIAL_MSEC), iters);
+        assert_int_equal(pgp_s2k_compute_iters(PGP_HASH_SHA256, 100, 1), iters);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+    assert_true(elapsed.count() < (long) TRIAL_MSEC);
+}
+
+TEST_F(rnp_tests, s2k_iterated_compat)
+{
+    const pgp_hash_alg_t halgs[] = {
+      PGP_HASH_MD5, PGP_HASH_SHA1, PGP_HASH_SHA256, PGP_HASH_SHA512};
+    const char *  passwords[] = {"", "p", "password", "a much longer password with spaces"};
+    const size_t  iterations[] = {1, 9, 1024, 65536, 65537, 262147};
+    const size_t  keylens[] = {16, 32, 64, 100};
+    const uint8_t salt[PGP_SALT_SIZE] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    for (auto halg : halgs) {
+        char botan_alg[128];
+        snprintf(botan_alg, sizeof(botan_alg), "OpenPGP-S2K(%s)", pgp_hash_name_botan(halg));
+        for (auto password : passwords) {
+            for (auto iter : iterations) {
+                for (auto keylen : keylens) {
+                    for (int salted = 0; salted < 2; salted++) {
+                        if (!salted && !strlen(password)) {
+                            continue;
+                        }
+                        const uint8_t *s = salted ? salt : NULL;
+                        uint8_t        key[100] = {0};
+                        uint8_t        expected[100] = {0};
+                        assert_int_equal(
+                          pgp_s2k_iterated(halg, key, keylen, password, s, iter), 0);
+                        assert_int_equal(botan_pwdhash(botan_alg,
+                                                       iter,
+                                                       0,
+                                                       0,
+                                                       expected,
+                                                       keylen,
+                                                       password,
+                                                       0,
+                                                       s,
+                                                       s ? PGP_SALT_SIZE : 0),
+                                         0);
+                        assert_int_equal(memcmp(key, expected, keylen), 0);
+                    }
+                }
+            }
+        }
+    }
+    assert_int_not_equal(
+      pgp_s2k_iterated(PGP_HASH_UNKNOWN, NULL, 16, "password", salt, 1024), 0);
+}
+
 TEST_F(rnp_tests, s2k_iteration_encode_decode)
 {
     const size_t MAX_ITER = 0x3e00000; // 0x1F << (0xF + 6);
@@ -810,3 +874,61 @@ TEST_F(rnp_tests, test_validate_key_material)
 
     rng_destroy(&rng);
 }
+
+TEST_F(rnp_tests, rng_buffered)
+{
+    rng_t rng = {};
+    assert_false(rng_init(&rng, 10));
+    assert_true(rng_init(&rng, RNG_BUFFERED));
+    assert_null(rng.buffer);
+
+    /* small request is served from the buffer, used bytes are wiped */
+    uint8_t zeroes[64] = {0};
+    uint8_t data1[16] = {0};
+    uint8_t data2[16] = {0};
+    assert_true(rng_get_data(&rng, data1, sizeof(data1)));
+    assert_non_null(rng.buffer);
+    assert_int_equal(rng.available, RNG_BUFFER_SIZE - sizeof(data1));
+    assert_int_equal(memcmp(rng.buffer, zeroes, sizeof(data1)), 0);
+    assert_true(rng_get_data(&rng, data2, sizeof(data2)));
+    assert_int_equal(rng.available, RNG_BUFFER_SIZE - sizeof(data1) - sizeof(data2));
+    assert_int_equal(memcmp(rng.buffer, zeroes, sizeof(data1) + sizeof(data2)), 0);
+    assert_int_not_equal(memcmp(data1, data2, sizeof(data1)), 0);
+    assert_int_not_equal(memcmp(data1, zeroes, sizeof(data1)), 0);
+
+    /* large request bypasses the buffer */
+    std::vector<uint8_t> large(RNG_BUFFER_SIZE, 0);
+    size_t               avail = rng.available;
+    assert_true(rng_get_data(&rng, large.data(), large.size()));
+    assert_int_equal(rng.available, avail);
+    assert_int_not_equal(memcmp(large.data(), zeroes, sizeof(zeroes)), 0);
+
+    /* buffer is refilled once exhausted */
+    for (size_t i = 0; i < 2 * RNG_BUFFER_SIZE / sizeof(data1); i++) {
+        assert_true(rng_get_data(&rng, data1, sizeof(data1)));
+        assert_true(rng.available < RNG_BUFFER_SIZE);
+    }
+    /* request, larger than left in the buffer */
+    uint8_t data3[RNG_BUFFER_SIZE / 4] = {0};
+    rng.available = sizeof(data3) - 1;
+    assert_true(rng_get_data(&rng, data3, sizeof(data3)));
+    assert_int_equal(rng.available, RNG_BUFFER_SIZE - sizeof(data3));
+
+    /* reseed when limit is reached */
+    rng.reseed = 10;
+    rng.available = 0;
+    assert_true(rng_get_data(&rng, data1, sizeof(data1)));
+    assert_int_equal(rng.reseed, RNG_RESEED_BYTES - RNG_BUFFER_SIZE);
+
+    /* buffer is dropped in the other process */
+    rng.pid = -1;
+    assert_true(rng_get_data(&rng, data1, sizeof(data1)));
+    assert_int_equal(rng.available, RNG_BUFFER_SIZE - sizeof(data1));
+    assert_int_not_equal(rng.pid, -1);
+
+    /* Botan handle is still available */
+    assert_non_null(rng_handle(&rng));
+    rng_destroy(&rng);
+    assert_null(rng.buffer);
+    assert_int_equal(rng.available, 0);
+}
@@ -25,6 +25,8 @@
  */
 
 #include <fstream>
+#include <thread>
+#include <chrono>
 #include <vector>
 #include <string>
 
@@ -34,6 +36,7 @@
 #include "librepgp/stream-common.h"
 #include "librepgp/stream-packet.h"
 #include "librepgp/stream-sig.h"
+#include "librepgp/stream-parse.h"
 #include <json.h>
 #include <vector>
 #include <string>
@@ -856,3 +859,1174 @@ TEST_F(rnp_tests, test_ffi_encrypt_pk_subkey_selection)
 
     rnp_ffi_destroy(ffi);
 }
+
+static bool
+encrypt_to_many(rnp_ffi_t ffi, size_t count, size_t threads, std::string &enc)
+{
+    const char *     plaintext = "data for many recipients";
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) plaintext, strlen(plaintext), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_set_recipient_threads(op, threads)) {
+        goto done;
+    }
+    for (size_t i = 0; i < count; i++) {
+        rnp_key_handle_t key = NULL;
+        if (rnp_locate_key(ffi, "userid", i % 3 ? "key0-uid2" : "key1-uid1", &key)) {
+            goto done;
+        }
+        rnp_result_t ret = rnp_op_encrypt_add_recipient(op, key);
+        rnp_key_handle_destroy(key);
+        if (ret) {
+            goto done;
+        }
+    }
+    if (rnp_op_encrypt_execute(op) || rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    enc.assign((char *) buf, len);
+    res = true;
+done:
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static std::vector<std::string>
+decrypt_recipients(rnp_ffi_t ffi, const std::string &enc)
+{
+    std::vector<std::string> keyids;
+    rnp_input_t              input = NULL;
+    rnp_output_t             output = NULL;
+    rnp_op_verify_t          verify = NULL;
+    size_t                   count = 0;
+
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) enc.data(), enc.size(), false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, output));
+    assert_rnp_success(rnp_op_verify_execute(verify));
+    assert_rnp_success(rnp_op_verify_get_recipient_count(verify, &count));
+    for (size_t i = 0; i < count; i++) {
+        rnp_recipient_handle_t recipient = NULL;
+        char *                 keyid = NULL;
+        assert_rnp_success(rnp_op_verify_get_recipient_at(verify, i, &recipient));
+        assert_rnp_success(rnp_recipient_get_keyid(recipient, &keyid));
+        keyids.push_back(keyid);
+        rnp_buffer_destroy(keyid);
+    }
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return keyids;
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_recipient_threads)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* bad parameters */
+    assert_rnp_failure(rnp_op_encrypt_set_recipient_threads(NULL, 4));
+
+    /* session key packets must be written in the same order as on the single thread */
+    std::string enc;
+    assert_true(encrypt_to_many(ffi, 12, 0, enc));
+    auto expected = decrypt_recipients(ffi, enc);
+    assert_int_equal(expected.size(), 12);
+    assert_true(expected[0] != expected[1]);
+    assert_string_equal(expected[1].c_str(), expected[2].c_str());
+
+    size_t threads[] = {1, 2, 4, 32};
+    for (auto thr : threads) {
+        assert_true(encrypt_to_many(ffi, 12, thr, enc));
+        auto keyids = decrypt_recipients(ffi, enc);
+        assert_true(keyids == expected);
+    }
+    /* less recipients than threads and than the parallel threshold */
+    assert_true(encrypt_to_many(ffi, 2, 8, enc));
+    auto keyids = decrypt_recipients(ffi, enc);
+    assert_int_equal(keyids.size(), 2);
+    assert_string_equal(keyids[0].c_str(), expected[0].c_str());
+    assert_string_equal(keyids[1].c_str(), expected[1].c_str());
+
+    rnp_ffi_destroy(ffi);
+}
+
+static std::string
+decrypt_cipher(rnp_ffi_t ffi, const std::string &enc)
+{
+    rnp_input_t     input = NULL;
+    rnp_output_t    output = NULL;
+    rnp_op_verify_t verify = NULL;
+    char *          cipher = NULL;
+
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) enc.data(), enc.size(), false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, output));
+    assert_rnp_success(rnp_op_verify_execute(verify));
+    assert_rnp_success(rnp_op_verify_get_protection_info(verify, NULL, &cipher, NULL));
+    std::string res = cipher;
+    rnp_buffer_destroy(cipher);
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static rnp_result_t
+encrypt_to_set(rnp_ffi_t ffi, rnp_recipient_set_t set, const char *cipher, std::string &enc)
+{
+    const char *     plaintext = "data for the recipient set";
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) plaintext, strlen(plaintext), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+    if (cipher) {
+        assert_rnp_success(rnp_op_encrypt_set_cipher(op, cipher));
+    }
+    rnp_result_t ret = rnp_op_encrypt_add_recipient_set(op, set);
+    if (!ret) {
+        ret = rnp_op_encrypt_execute(op);
+    }
+    if (!ret) {
+        uint8_t *buf = NULL;
+        size_t   len = 0;
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        enc.assign((char *) buf, len);
+    }
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return ret;
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_recipient_set)
+{
+    rnp_ffi_t ffi = NULL;
+    rnp_ffi_t ffi2 = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_create(&ffi2, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* bad parameters */
+    rnp_recipient_set_t set = NULL;
+    assert_rnp_failure(rnp_recipient_set_create(NULL, &set));
+    assert_rnp_failure(rnp_recipient_set_create(ffi, NULL));
+    assert_rnp_success(rnp_recipient_set_create(ffi, &set));
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key0-uid2", &key));
+    assert_rnp_failure(rnp_recipient_set_add(NULL, key));
+    assert_rnp_failure(rnp_recipient_set_add(set, NULL));
+    assert_rnp_success(rnp_recipient_set_add(set, key));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid1", &key));
+    assert_rnp_success(rnp_recipient_set_add(set, key));
+    rnp_key_handle_destroy(key);
+    /* key of the other FFI object cannot be used */
+    assert_true(load_keys_gpg(ffi2, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_success(rnp_locate_key(ffi2, "userid", "key0-uid2", &key));
+    assert_rnp_failure(rnp_recipient_set_add(set, key));
+    rnp_key_handle_destroy(key);
+    size_t count = 0;
+    assert_rnp_failure(rnp_recipient_set_get_count(NULL, &count));
+    assert_rnp_failure(rnp_recipient_set_get_count(set, NULL));
+    assert_rnp_success(rnp_recipient_set_get_count(set, &count));
+    assert_int_equal(count, 2);
+
+    /* the same set is used for a number of messages, each with own session key */
+    const char *plaintext = "data for the recipient set";
+    std::string encs[3];
+    for (auto &enc : encs) {
+        rnp_input_t      input = NULL;
+        rnp_output_t     output = NULL;
+        rnp_op_encrypt_t op = NULL;
+        assert_rnp_success(
+          rnp_input_from_memory(&input, (uint8_t *) plaintext, strlen(plaintext), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+        assert_rnp_failure(rnp_op_encrypt_add_recipient_set(NULL, set));
+        assert_rnp_failure(rnp_op_encrypt_add_recipient_set(op, NULL));
+        assert_rnp_success(rnp_op_encrypt_add_recipient_set(op, set));
+        assert_rnp_success(rnp_op_encrypt_execute(op));
+        uint8_t *buf = NULL;
+        size_t   len = 0;
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        enc.assign((char *) buf, len);
+        rnp_op_encrypt_destroy(op);
+        rnp_input_destroy(input);
+        rnp_output_destroy(output);
+    }
+    assert_true(encs[0] != encs[1]);
+    assert_true(encs[1] != encs[2]);
+
+    /* session keys must be encrypted to the same subkeys as with separate recipients */
+    std::string enc;
+    assert_true(encrypt_to_many(ffi, 2, 0, enc));
+    auto expected = decrypt_recipients(ffi, enc);
+    for (auto &setenc : encs) {
+        auto keyids = decrypt_recipients(ffi, setenc);
+        assert_true(keyids.size() == 2);
+        assert_string_equal(keyids[0].c_str(), expected[1].c_str());
+        assert_string_equal(keyids[1].c_str(), expected[0].c_str());
+        /* AES256 is not listed in the latest self-signature of key1 */
+        assert_string_equal(decrypt_cipher(ffi, setenc).c_str(), "AES192");
+    }
+    /* explicitly set cipher is not overridden */
+    assert_rnp_success(encrypt_to_set(ffi, set, "AES128", enc));
+    assert_string_equal(decrypt_cipher(ffi, enc).c_str(), "AES128");
+
+    /* set may not be attached to operation of the other FFI object */
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) plaintext, strlen(plaintext), false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi2, input, output));
+    assert_rnp_failure(rnp_op_encrypt_add_recipient_set(op, set));
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    /* keys are looked up by fingerprints, so unloaded keys are reported */
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_PUBLIC | RNP_KEY_UNLOAD_SECRET));
+    assert_int_equal(encrypt_to_set(ffi, set, NULL, enc), RNP_ERROR_KEY_NOT_FOUND);
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(encrypt_to_set(ffi, set, NULL, enc));
+    assert_true(decrypt_recipients(ffi, enc).size() == 2);
+
+    assert_rnp_success(rnp_recipient_set_destroy(set));
+    assert_rnp_success(rnp_recipient_set_destroy(NULL));
+    rnp_ffi_destroy(ffi);
+    rnp_ffi_destroy(ffi2);
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_buffered_rng)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    assert_rnp_failure(rnp_ffi_set_rng_buffered(NULL, true));
+    assert_rnp_success(rnp_ffi_set_rng_buffered(ffi, true));
+    assert_rnp_success(rnp_ffi_set_rng_buffered(ffi, true));
+
+    /* each message must get own session key */
+    std::string enc1;
+    std::string enc2;
+    assert_true(encrypt_to_many(ffi, 3, 1, enc1));
+    assert_true(encrypt_to_many(ffi, 3, 1, enc2));
+    assert_true(enc1 != enc2);
+    assert_int_equal(decrypt_recipients(ffi, enc1).size(), 3);
+    assert_int_equal(decrypt_recipients(ffi, enc2).size(), 3);
+
+    /* switch back to the non-buffered generator */
+    assert_rnp_success(rnp_ffi_set_rng_buffered(ffi, false));
+    assert_true(encrypt_to_many(ffi, 3, 1, enc1));
+    assert_int_equal(decrypt_recipients(ffi, enc1).size(), 3);
+
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_parallel_compression)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* a few megabytes of compressible data, not aligned to the compression block size */
+    std::string data;
+    for (size_t i = 0; data.size() < 3 * 1024 * 1024 + 1234; i++) {
+        data += "line " + std::to_string(i) + ": " + std::to_string(i * 7919 % 1000003) + "\n";
+    }
+
+    const char *algs[] = {"ZIP", "ZLIB", "BZip2"};
+    for (auto alg : algs) {
+        for (size_t threads : {0, 1, 4}) {
+            rnp_input_t      input = NULL;
+            rnp_output_t     output = NULL;
+            rnp_op_encrypt_t op = NULL;
+            assert_rnp_success(
+              rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false));
+            assert_rnp_success(rnp_output_to_memory(&output, 0));
+            assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+            assert_rnp_success(rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL));
+            assert_rnp_success(rnp_op_encrypt_set_compression(op, alg, 6));
+            assert_rnp_failure(rnp_op_encrypt_set_compression_threads(NULL, threads));
+            assert_rnp_success(rnp_op_encrypt_set_compression_threads(op, threads));
+            assert_rnp_success(rnp_op_encrypt_execute(op));
+            uint8_t *buf = NULL;
+            size_t   len = 0;
+            assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+            assert_true(len < data.size() / 2);
+            rnp_op_encrypt_destroy(op);
+            rnp_input_destroy(input);
+            rnp_output_destroy(output);
+
+            /* decrypt and compare */
+            assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+            assert_rnp_success(rnp_output_to_memory(&output, 0));
+            assert_rnp_success(rnp_decrypt(ffi, input, output));
+            uint8_t *dec = NULL;
+            size_t   declen = 0;
+            assert_rnp_success(rnp_output_memory_get_buf(output, &dec, &declen, false));
+            assert_int_equal(declen, data.size());
+            assert_int_equal(memcmp(dec, data.data(), declen), 0);
+            rnp_input_destroy(input);
+            rnp_output_destroy(output);
+            rnp_buffer_destroy(buf);
+        }
+    }
+
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+encrypt_with_compression(rnp_ffi_t ffi, const std::string &data, bool zauto, std::string &used)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    char *           zalg = NULL;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false) ||
+        rnp_output_to_null(&output) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL) ||
+        rnp_op_encrypt_set_compression(op, "ZLIB", 6) ||
+        rnp_op_encrypt_set_compression_auto(op, zauto) || rnp_op_encrypt_execute(op) ||
+        rnp_op_encrypt_get_used_compression(op, &zalg)) {
+        goto done;
+    }
+    used = zalg;
+    res = true;
+done:
+    rnp_buffer_destroy(zalg);
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_compression_auto)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+
+    std::string text;
+    for (size_t i = 0; text.size() < 100000; i++) {
+        text += "This is line number " + std::to_string(i) + " of the text document.\n";
+    }
+    std::string random(100000, '\0');
+    uint32_t    seed = 0x12345678;
+    for (auto &ch : random) {
+        seed = seed * 1103515245 + 12345;
+        ch = (char) (seed >> 24);
+    }
+
+    /* by default everything is compressed */
+    std::string used;
+    assert_true(encrypt_with_compression(ffi, text, false, used));
+    assert_string_equal(used.c_str(), "ZLIB");
+    assert_true(encrypt_with_compression(ffi, random, false, used));
+    assert_string_equal(used.c_str(), "ZLIB");
+    /* with automatic bypass incompressible data is not compressed */
+    assert_true(encrypt_with_compression(ffi, text, true, used));
+    assert_string_equal(used.c_str(), "ZLIB");
+    assert_true(encrypt_with_compression(ffi, random, true, used));
+    assert_string_equal(used.c_str(), "Uncompressed");
+    assert_true(encrypt_with_compression(ffi, "short", true, used));
+    assert_string_equal(used.c_str(), "ZLIB");
+
+    /* bad parameters */
+    char *zalg = NULL;
+    assert_rnp_failure(rnp_op_encrypt_set_compression_auto(NULL, true));
+    assert_rnp_failure(rnp_op_encrypt_get_used_compression(NULL, &zalg));
+
+    rnp_ffi_destroy(ffi);
+}
+
+/* decrypt password-encrypted message and get algorithm of the packet inside */
+static bool
+encrypted_zalg(const std::string &enc, int &zalg)
+{
+    pgp_source_t            src = {};
+    pgp_source_t            encsrc = {};
+    pgp_source_t            zsrc = {};
+    pgp_password_provider_t prov = {.callback = string_copy_password_callback,
+                                    .userdata = (void *) "password"};
+    pgp_parse_handler_t     handler = {};
+    rnp_ctx_t               ctx;
+    uint8_t                 alg = 0;
+    bool                    res = false;
+
+    handler.password_provider = &prov;
+    handler.ctx = &ctx;
+    if (init_mem_src(&src, enc.data(), enc.size(), false) ||
+        init_encrypted_src(&handler, &encsrc, &src)) {
+        goto done;
+    }
+    if (stream_pkt_type(&encsrc) != PGP_PKT_COMPRESSED) {
+        zalg = PGP_C_NONE;
+        res = stream_pkt_type(&encsrc) == PGP_PKT_LITDATA;
+        goto done;
+    }
+    if (init_compressed_src(&zsrc, &encsrc) || !get_compressed_src_alg(&zsrc, &alg)) {
+        goto done;
+    }
+    zalg = alg;
+    res = true;
+done:
+    src_close(&zsrc);
+    src_close(&encsrc);
+    src_close(&src);
+    return res;
+}
+
+static bool
+encrypt_check_compression(rnp_ffi_t              ffi,
+                          const std::string &    data,
+                          const char *           zname,
+                          bool                   zauto,
+                          pgp_compression_type_t expected)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    char *           used = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    int              zalg = -1;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL) ||
+        rnp_op_encrypt_set_compression(op, zname, 6) ||
+        rnp_op_encrypt_set_compression_auto(op, zauto)) {
+        goto done;
+    }
+    /* nothing is known before the operation starts */
+    if (rnp_op_encrypt_get_used_compression(op, &used) != RNP_ERROR_BAD_STATE) {
+        goto done;
+    }
+    if (rnp_op_encrypt_execute(op) || rnp_op_encrypt_get_used_compression(op, &used) ||
+        rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    /* reported algorithm must match the one of the decrypted packet */
+    if (!encrypted_zalg(std::string((char *) buf, len), zalg) || (zalg != expected)) {
+        goto done;
+    }
+    res = !strcmp(used, zalg == PGP_C_NONE ? "Uncompressed" : zname);
+done:
+    rnp_buffer_destroy(used);
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static bool
+sign_used_compression(rnp_ffi_t ffi, bool detached, bool cleartext, std::string &used)
+{
+    const char *     data = "data to sign";
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_sign_t    op = NULL;
+    rnp_key_handle_t key = NULL;
+    char *           zalg = NULL;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data, strlen(data), false) ||
+        rnp_output_to_null(&output)) {
+        goto done;
+    }
+    if (detached ? rnp_op_sign_detached_create(&op, ffi, input, output) :
+        cleartext ? rnp_op_sign_cleartext_create(&op, ffi, input, output) :
+                    rnp_op_sign_create(&op, ffi, input, output)) {
+        goto done;
+    }
+    if (rnp_locate_key(ffi, "userid", "key0-uid2", &key) ||
+        rnp_op_sign_add_signature(op, key, NULL) ||
+        rnp_op_sign_set_compression(op, "ZLIB", 6) || rnp_op_sign_execute(op) ||
+        rnp_op_sign_get_used_compression(op, &zalg)) {
+        goto done;
+    }
+    used = zalg;
+    res = true;
+done:
+    rnp_buffer_destroy(zalg);
+    rnp_key_handle_destroy(key);
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_used_compression_roundtrip)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::string text;
+    for (size_t i = 0; text.size() < 10000; i++) {
+        text += "Line " + std::to_string(i) + "\n";
+    }
+    std::string random(10000, '\0');
+    uint32_t    seed = 0x87654321;
+    for (auto &ch : random) {
+        seed = seed * 1103515245 + 12345;
+        ch = (char) (seed >> 24);
+    }
+
+    assert_true(encrypt_check_compression(ffi, text, "ZIP", false, PGP_C_ZIP));
+    assert_true(encrypt_check_compression(ffi, text, "ZLIB", false, PGP_C_ZLIB));
+    assert_true(encrypt_check_compression(ffi, text, "Uncompressed", false, PGP_C_NONE));
+    assert_true(encrypt_check_compression(ffi, random, "ZLIB", false, PGP_C_ZLIB));
+    assert_true(encrypt_check_compression(ffi, random, "ZLIB", true, PGP_C_NONE));
+
+    /* detached and cleartext signatures are never compressed */
+    std::string used;
+    assert_true(sign_used_compression(ffi, false, false, used));
+    assert_string_equal(used.c_str(), "ZLIB");
+    assert_true(sign_used_compression(ffi, true, false, used));
+    assert_string_equal(used.c_str(), "Uncompressed");
+    assert_true(sign_used_compression(ffi, false, true, used));
+    assert_string_equal(used.c_str(), "Uncompressed");
+
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+encrypt_for_range(
+  rnp_ffi_t ffi, const std::string &data, const char *aead, const char *zalg, std::string &enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL) ||
+        rnp_op_encrypt_set_aead(op, aead) || rnp_op_encrypt_set_aead_bits(op, 4) ||
+        rnp_op_encrypt_set_compression(op, zalg, 6) || rnp_op_encrypt_execute(op) ||
+        rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    enc.assign((char *) buf, len);
+    res = true;
+done:
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static rnp_result_t
+decrypt_range(
+  rnp_ffi_t ffi, const std::string &enc, uint64_t offset, uint64_t length, std::string &dec)
+{
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    uint8_t *    buf = NULL;
+    size_t       len = 0;
+
+    rnp_result_t ret =
+      rnp_input_from_memory(&input, (uint8_t *) enc.data(), enc.size(), false);
+    if (!ret) {
+        ret = rnp_output_to_memory(&output, 0);
+    }
+    if (!ret) {
+        ret = rnp_decrypt_range(ffi, input, offset, length, output);
+    }
+    if (!ret) {
+        ret = rnp_output_memory_get_buf(output, &buf, &len, false);
+    }
+    if (!ret) {
+        dec.assign((char *) buf, len);
+    }
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return ret;
+}
+
+TEST_F(rnp_tests, test_ffi_decrypt_range)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::string data;
+    for (size_t i = 0; data.size() < 20000; i++) {
+        data += std::to_string(i * 7919 % 1000003) + " ";
+    }
+
+    std::string enc;
+    std::string dec;
+    for (auto aead : {"EAX", "OCB"}) {
+        /* chunk size is 1024 bytes, so ranges below cover one or several chunks */
+        assert_true(encrypt_for_range(ffi, data, aead, "Uncompressed", enc));
+        const std::pair<uint64_t, uint64_t> ranges[] = {
+          {0, 10}, {1000, 100}, {5000, 3000}, {0, data.size()}, {data.size() - 10, 100}};
+        for (auto &range : ranges) {
+            assert_rnp_success(decrypt_range(ffi, enc, range.first, range.second, dec));
+            assert_true(dec == data.substr(range.first, range.second));
+        }
+        assert_rnp_success(decrypt_range(ffi, enc, data.size(), 10, dec));
+        assert_true(dec.empty());
+        assert_int_equal(decrypt_range(ffi, enc, data.size() + 1, 10, dec),
+                         RNP_ERROR_BAD_PARAMETERS);
+        /* corrupted chunk must not be released */
+        std::string bad = enc;
+        bad[bad.size() - 5000] ^= 0x01;
+        assert_rnp_failure(decrypt_range(ffi, bad, 0, data.size(), dec));
+        assert_rnp_success(decrypt_range(ffi, bad, 0, 100, dec));
+        assert_true(dec == data.substr(0, 100));
+        /* compressed data doesn't allow random access */
+        assert_true(encrypt_for_range(ffi, data, aead, "ZLIB", enc));
+        assert_int_equal(decrypt_range(ffi, enc, 0, 10, dec), RNP_ERROR_NOT_SUPPORTED);
+    }
+    /* non-AEAD message */
+    assert_true(encrypt_for_range(ffi, data, "None", "Uncompressed", enc));
+    assert_int_equal(decrypt_range(ffi, enc, 0, 10, dec), RNP_ERROR_NOT_SUPPORTED);
+
+    /* bad parameters */
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) "data", 4, false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_failure(rnp_decrypt_range(NULL, input, 0, 1, output));
+    assert_rnp_failure(rnp_decrypt_range(ffi, NULL, 0, 1, output));
+    assert_rnp_failure(rnp_decrypt_range(ffi, input, 0, 1, NULL));
+    assert_rnp_failure(rnp_decrypt_range(ffi, input, 0, 1, output));
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+verify_pushed(rnp_ffi_t ffi, const std::string &msg, const std::string &data, bool signed_)
+{
+    rnp_input_t     input = NULL;
+    rnp_output_t    output = NULL;
+    rnp_op_verify_t verify = NULL;
+    uint8_t *       buf = NULL;
+    size_t          len = 0;
+    size_t          sigs = 0;
+    bool            res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) msg.data(), msg.size(), false) ||
+        rnp_output_to_memory(&output, 0) ||
+        rnp_op_verify_create(&verify, ffi, input, output) || rnp_op_verify_execute(verify) ||
+        rnp_op_verify_get_signature_count(verify, &sigs) ||
+        rnp_output_memory_drain(output, &buf, &len)) {
+        goto done;
+    }
+    if (signed_) {
+        rnp_op_verify_signature_t sig = NULL;
+        if ((sigs != 1) || rnp_op_verify_get_signature_at(verify, 0, &sig) ||
+            rnp_op_verify_signature_get_status(sig)) {
+            goto done;
+        }
+    }
+    res = (len == data.size()) && (!len || !memcmp(buf, data.data(), len));
+done:
+    rnp_buffer_destroy(buf);
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_push_operations)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::string data;
+    for (size_t i = 0; data.size() < 100000; i++) {
+        data += "line " + std::to_string(i) + "\n";
+    }
+    /* portions of data as they would arrive from the network */
+    const size_t portions[] = {1, 7, 100, 4096, 10000, 65536};
+
+    /* encrypt and sign, draining output after each portion */
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, NULL, output));
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key0-uid2", &key));
+    assert_rnp_success(rnp_op_encrypt_add_recipient(op, key));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid1", &key));
+    assert_rnp_success(rnp_op_encrypt_add_signature(op, key, NULL));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_op_encrypt_set_compression(op, "Uncompressed", 0));
+    assert_rnp_failure(rnp_op_encrypt_execute(op));
+    std::string msg;
+    size_t      pos = 0;
+    size_t      drained = 0;
+    for (size_t i = 0; pos < data.size(); i++) {
+        size_t len = std::min(portions[i % ARRAY_SIZE(portions)], data.size() - pos);
+        assert_rnp_success(rnp_op_encrypt_feed(op, (uint8_t *) data.data() + pos, len));
+        pos += len;
+        uint8_t *buf = NULL;
+        size_t   blen = 0;
+        assert_rnp_success(rnp_output_memory_drain(output, &buf, &blen));
+        msg.append((char *) buf, blen);
+        drained += blen;
+        rnp_buffer_destroy(buf);
+    }
+    /* output must be produced before the operation is finished */
+    assert_true(drained > 0);
+    /* settings may not be changed once data is pushed */
+    assert_int_equal(rnp_op_encrypt_set_cipher(op, "AES128"), RNP_ERROR_BAD_STATE);
+    assert_int_equal(rnp_op_encrypt_set_armor(op, true), RNP_ERROR_BAD_STATE);
+    assert_int_equal(rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL),
+                     RNP_ERROR_BAD_STATE);
+    assert_rnp_success(rnp_op_encrypt_finish(op));
+    assert_int_equal(rnp_op_encrypt_feed(op, (uint8_t *) "data", 4), RNP_ERROR_BAD_STATE);
+    assert_int_equal(rnp_op_encrypt_finish(op), RNP_ERROR_BAD_STATE);
+    /* finished operation doesn't lock the settings, as after rnp_op_encrypt_execute() */
+    assert_rnp_success(rnp_op_encrypt_set_armor(op, false));
+    uint8_t *buf = NULL;
+    size_t   blen = 0;
+    assert_rnp_success(rnp_output_memory_drain(output, &buf, &blen));
+    msg.append((char *) buf, blen);
+    rnp_buffer_destroy(buf);
+    rnp_op_encrypt_destroy(op);
+    rnp_output_destroy(output);
+    assert_true(verify_pushed(ffi, msg, data, true));
+
+    /* cleartext signing */
+    rnp_op_sign_t sign = NULL;
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_sign_cleartext_create(&sign, ffi, NULL, output));
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key1-uid1", &key));
+    assert_rnp_success(rnp_op_sign_add_signature(sign, key, NULL));
+    rnp_key_handle_destroy(key);
+    msg.clear();
+    for (pos = 0; pos < data.size(); pos += 1000) {
+        size_t len = std::min((size_t) 1000, data.size() - pos);
+        assert_rnp_success(rnp_op_sign_feed(sign, (uint8_t *) data.data() + pos, len));
+    }
+    assert_int_equal(rnp_op_sign_set_hash(sign, "SHA512"), RNP_ERROR_BAD_STATE);
+    assert_rnp_success(rnp_op_sign_finish(sign));
+    assert_rnp_success(rnp_output_memory_drain(output, &buf, &blen));
+    msg.assign((char *) buf, blen);
+    rnp_buffer_destroy(buf);
+    rnp_op_sign_destroy(sign);
+    rnp_output_destroy(output);
+    assert_true(verify_pushed(ffi, msg, data, true));
+
+    /* password encryption without any data, and destroying unfinished operation */
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, NULL, output));
+    assert_rnp_success(rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL));
+    assert_rnp_success(rnp_op_encrypt_finish(op));
+    assert_rnp_success(rnp_output_memory_drain(output, &buf, &blen));
+    msg.assign((char *) buf, blen);
+    rnp_buffer_destroy(buf);
+    rnp_op_encrypt_destroy(op);
+    assert_true(verify_pushed(ffi, msg, "", false));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, NULL, output));
+    assert_rnp_success(rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL));
+    assert_rnp_success(rnp_op_encrypt_feed(op, (uint8_t *) data.data(), data.size()));
+    rnp_op_encrypt_destroy(op);
+    rnp_output_destroy(output);
+
+    /* bad parameters */
+    assert_rnp_failure(rnp_op_encrypt_feed(NULL, (uint8_t *) "data", 4));
+    assert_rnp_failure(rnp_op_encrypt_finish(NULL));
+    assert_rnp_failure(rnp_op_sign_feed(NULL, (uint8_t *) "data", 4));
+    assert_rnp_failure(rnp_op_sign_finish(NULL));
+    assert_rnp_failure(rnp_output_memory_drain(NULL, &buf, &blen));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_failure(rnp_output_memory_drain(output, &buf, &blen));
+    /* no recipients */
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, NULL, output));
+    assert_rnp_failure(rnp_op_encrypt_feed(op, (uint8_t *) "data", 4));
+    assert_int_equal(rnp_op_encrypt_finish(op), RNP_ERROR_BAD_STATE);
+    rnp_op_encrypt_destroy(op);
+    rnp_output_destroy(output);
+
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_encrypt_file_async_io)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* a few I/O blocks, not aligned to the block size */
+    std::string data;
+    for (size_t i = 0; data.size() < 3 * 1024 * 1024 + 4321; i++) {
+        data += std::to_string(i * 7919 % 1000003) + "\n";
+    }
+    FILE *fp = fopen("plaintext", "wb");
+    assert_non_null(fp);
+    assert_int_equal(1, fwrite(data.data(), data.size(), 1, fp));
+    assert_int_equal(0, fclose(fp));
+
+    /* encrypt with read-ahead input and write-behind output */
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    assert_rnp_failure(rnp_input_from_file(NULL, "plaintext", 0));
+    assert_rnp_failure(rnp_input_from_file(&input, "plaintext", 0xff));
+    assert_rnp_failure(rnp_input_from_file(&input, "nonexisting", RNP_INPUT_FILE_READ_AHEAD));
+    assert_rnp_success(rnp_input_from_file(&input, "plaintext", RNP_INPUT_FILE_READ_AHEAD));
+    assert_rnp_success(rnp_output_to_file(
+      &output, "encrypted", RNP_OUTPUT_FILE_OVERWRITE | RNP_OUTPUT_FILE_WRITE_BEHIND));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL));
+    assert_rnp_success(rnp_op_encrypt_set_aead(op, "OCB"));
+    assert_rnp_success(rnp_op_encrypt_set_compression(op, "Uncompressed", 0));
+    assert_rnp_success(rnp_op_encrypt_execute(op));
+    assert_rnp_success(rnp_output_finish(output));
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    /* decrypt with random temporary file name */
+    assert_rnp_success(rnp_input_from_file(&input, "encrypted", RNP_INPUT_FILE_READ_AHEAD));
+    assert_rnp_success(rnp_output_to_file(&output,
+                                          "decrypted",
+                                          RNP_OUTPUT_FILE_OVERWRITE | RNP_OUTPUT_FILE_RANDOM |
+                                            RNP_OUTPUT_FILE_WRITE_BEHIND));
+    assert_rnp_success(rnp_decrypt(ffi, input, output));
+    assert_rnp_success(rnp_output_finish(output));
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    assert_true(file_to_str("decrypted") == data);
+
+    /* seek in the read-ahead input */
+    assert_rnp_success(rnp_input_from_file(&input, "encrypted", RNP_INPUT_FILE_READ_AHEAD));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_decrypt_range(ffi, input, 1000000, 500000, output));
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    assert_true(std::string((char *) buf, len) == data.substr(1000000, 500000));
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    unlink("plaintext");
+    unlink("encrypted");
+    unlink("decrypted");
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+counting_password_provider(rnp_ffi_t        ffi,
+                           void *           app_ctx,
+                           rnp_key_handle_t key,
+                           const char *     pgp_context,
+                           char *           buf,
+                           size_t           buf_len)
+{
+    (*(size_t *) app_ctx)++;
+    return ffi_string_password_provider(
+      ffi, (void *) "password", key, pgp_context, buf, buf_len);
+}
+
+static bool
+cached_sign(rnp_ffi_t ffi)
+{
+    const char *     data = "data to sign";
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_sign_t    op = NULL;
+    rnp_key_handle_t key = NULL;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data, strlen(data), false) ||
+        rnp_output_to_null(&output) || rnp_op_sign_detached_create(&op, ffi, input, output) ||
+        rnp_locate_key(ffi, "userid", "key0-uid2", &key) ||
+        rnp_op_sign_add_signature(op, key, NULL)) {
+        goto done;
+    }
+    res = !rnp_op_sign_execute(op);
+done:
+    rnp_key_handle_destroy(key);
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static bool
+cached_decrypt(rnp_ffi_t ffi, const std::string &enc)
+{
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    bool         res = false;
+
+    if (!rnp_input_from_memory(&input, (uint8_t *) enc.data(), enc.size(), false) &&
+        !rnp_output_to_null(&output)) {
+        res = !rnp_decrypt(ffi, input, output);
+    }
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_secret_key_cache)
+{
+    rnp_ffi_t ffi = NULL;
+    size_t    calls = 0;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, counting_password_provider, &calls));
+
+    /* bad parameters */
+    assert_rnp_failure(rnp_ffi_set_key_cache(NULL, 60, 0));
+    assert_rnp_failure(rnp_ffi_flush_key_cache(NULL, NULL));
+
+    /* encrypt data to the key0 subkey */
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    rnp_key_handle_t key = NULL;
+    const char *     plaintext = "data1";
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) plaintext, strlen(plaintext), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_encrypt_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_locate_key(ffi, "userid", "key0-uid2", &key));
+    assert_rnp_success(rnp_op_encrypt_add_recipient(op, key));
+    assert_rnp_success(rnp_op_encrypt_execute(op));
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    std::string enc((char *) buf, len);
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    /* cache is disabled by default */
+    assert_true(cached_sign(ffi));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 2);
+    assert_true(cached_decrypt(ffi, enc));
+    assert_true(cached_decrypt(ffi, enc));
+    assert_int_equal(calls, 4);
+
+    /* enable cache without use limit */
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 3600, 0));
+    for (size_t i = 0; i < 5; i++) {
+        assert_true(cached_sign(ffi));
+        assert_true(cached_decrypt(ffi, enc));
+    }
+    assert_int_equal(calls, 2);
+    /* flushing primary key flushes subkeys as well */
+    assert_rnp_success(rnp_ffi_flush_key_cache(ffi, key));
+    assert_true(cached_sign(ffi));
+    assert_true(cached_decrypt(ffi, enc));
+    assert_true(cached_sign(ffi));
+    assert_true(cached_decrypt(ffi, enc));
+    assert_int_equal(calls, 4);
+    assert_rnp_success(rnp_ffi_flush_key_cache(ffi, NULL));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 5);
+    /* unloading secret keys flushes cache */
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_SECRET));
+    assert_false(cached_sign(ffi));
+    assert_true(load_keys_gpg(ffi, "", "data/keyrings/1/secring.gpg"));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 6);
+
+    /* limit number of uses */
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 3600, 3));
+    for (size_t i = 0; i < 6; i++) {
+        assert_true(cached_sign(ffi));
+    }
+    assert_int_equal(calls, 2);
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 3600, 1));
+    assert_true(cached_sign(ffi));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 2);
+
+    /* wrong password is not cached */
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 3600, 0));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "wrong"));
+    assert_false(cached_sign(ffi));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, counting_password_provider, &calls));
+    assert_true(cached_sign(ffi));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 1);
+    /* locking the key flushes its cached copy */
+    assert_rnp_success(rnp_key_lock(key));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 2);
+
+    /* expired key is wiped on the next cache access */
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 1, 0));
+    assert_true(cached_sign(ffi));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 2);
+
+    /* disable cache */
+    calls = 0;
+    assert_rnp_success(rnp_ffi_set_key_cache(ffi, 0, 0));
+    assert_true(cached_sign(ffi));
+    assert_true(cached_sign(ffi));
+    assert_int_equal(calls, 2);
+
+    rnp_key_handle_destroy(key);
+    rnp_ffi_destroy(ffi);
+}
+
+static bool
+encrypt_armored(rnp_ffi_t ffi, const std::string &data, std::string &enc)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_encrypt_t op = NULL;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+    bool             res = false;
+
+    if (rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false) ||
+        rnp_output_to_memory(&output, 0) || rnp_op_encrypt_create(&op, ffi, input, output) ||
+        rnp_op_encrypt_add_password(op, "password", NULL, 0, NULL) ||
+        rnp_op_encrypt_set_armor(op, true) || rnp_op_encrypt_execute(op) ||
+        rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        goto done;
+    }
+    enc.assign((char *) buf, len);
+    res = true;
+done:
+    rnp_op_encrypt_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+static uint64_t
+stream_stat(const char *json, const char *dir, const char *layer, const char *field)
+{
+    json_object *jso = json_tokener_parse(json);
+    json_object *jsodir = NULL;
+    json_object *jsolayer = NULL;
+    json_object *jsofield = NULL;
+    uint64_t     res = 0;
+    if (json_object_object_get_ex(jso, dir, &jsodir) &&
+        json_object_object_get_ex(jsodir, layer, &jsolayer) &&
+        json_object_object_get_ex(jsolayer, field, &jsofield)) {
+        res = json_object_get_int64(jsofield);
+    }
+    json_object_put(jso);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_stream_stats)
+{
+    rnp_ffi_t    ffi = NULL;
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    char *       json = NULL;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_stream_stats(NULL, true));
+    assert_rnp_failure(rnp_ffi_get_stream_stats(NULL, false, &json));
+    assert_rnp_failure(rnp_ffi_get_stream_stats(ffi, false, NULL));
+    /* nothing is collected by default */
+    std::string plain(100000, 'x');
+    std::string enc;
+    assert_true(encrypt_armored(ffi, plain, enc));
+    assert_rnp_success(rnp_ffi_get_stream_stats(ffi, false, &json));
+    assert_int_equal(stream_stat(json, "write", "encrypted", "calls"), 0);
+    rnp_buffer_destroy(json);
+
+    /* encrypt with stats enabled */
+    assert_rnp_success(rnp_ffi_set_stream_stats(ffi, true));
+    assert_true(encrypt_armored(ffi, plain, enc));
+    assert_rnp_success(rnp_ffi_get_stream_stats(ffi, true, &json));
+    assert_int_equal(stream_stat(json, "write", "literal", "bytes"), plain.size());
+    assert_true(stream_stat(json, "write", "encrypted", "calls") > 0);
+    assert_true(stream_stat(json, "write", "armored", "calls") > 0);
+    assert_int_equal(stream_stat(json, "write", "memory", "bytes"), enc.size());
+    assert_true(stream_stat(json, "read", "memory", "bytes") > 0);
+    rnp_buffer_destroy(json);
+
+    /* decrypt */
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (const uint8_t *) enc.data(), enc.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_decrypt(ffi, input, output));
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    assert_rnp_success(rnp_ffi_get_stream_stats(ffi, false, &json));
+    assert_int_equal(stream_stat(json, "read", "memory", "bytes"), enc.size());
+    assert_true(stream_stat(json, "read", "armored", "calls") > 0);
+    assert_true(stream_stat(json, "read", "encrypted", "calls") > 0);
+    assert_int_equal(stream_stat(json, "read", "literal", "bytes"), plain.size());
+    assert_int_equal(stream_stat(json, "write", "memory", "bytes"), plain.size());
+    assert_int_equal(stream_stat(json, "write", "encrypted", "calls"), 0);
+    rnp_buffer_destroy(json);
+
+    /* disable stats */
+    assert_rnp_success(rnp_ffi_set_stream_stats(ffi, false));
+    assert_true(encrypt_armored(ffi, plain, enc));
+    assert_rnp_success(rnp_ffi_get_stream_stats(ffi, true, &json));
+    assert_int_equal(stream_stat(json, "read", "literal", "bytes"), plain.size());
+    assert_int_equal(stream_stat(json, "write", "encrypted", "calls"), 0);
+    rnp_buffer_destroy(json);
+    assert_rnp_success(rnp_ffi_get_stream_stats(ffi, false, &json));
+    assert_int_equal(stream_stat(json, "read", "literal", "bytes"), 0);
+    rnp_buffer_destroy(json);
+
+    rnp_ffi_destroy(ffi);
+}
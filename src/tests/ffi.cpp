@@ -25,6 +25,10 @@
  */
 
 #include <fstream>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -341,6 +345,36 @@ TEST_F(rnp_tests, test_ffi_load_keys)
     free(buf);
 }
 
+TEST_F(rnp_tests, test_ffi_load_keys_validation_threads)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_failure(rnp_ffi_set_validation_threads(NULL, 4));
+
+    /* results must not depend on the number of threads, 0 means all hardware threads */
+    for (size_t threads : {(size_t) 1, (size_t) 4, (size_t) 0}) {
+        assert_rnp_success(rnp_ffi_set_validation_threads(ffi, threads));
+        assert_true(load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg"));
+        assert_true(import_pub_keys(ffi, "data/test_forged_keys/dsa-eg-pub-forged-key.pgp"));
+        size_t count = 0;
+        assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+        assert_int_equal(count, 9);
+
+        rnp_key_handle_t key = NULL;
+        bool             valid = false;
+        assert_rnp_success(rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key));
+        assert_rnp_success(rnp_key_is_valid(key, &valid));
+        assert_true(valid);
+        rnp_key_handle_destroy(key);
+        assert_rnp_success(rnp_locate_key(ffi, "keyid", "C8A10A7D78273E10", &key));
+        assert_rnp_success(rnp_key_is_valid(key, &valid));
+        assert_false(valid);
+        rnp_key_handle_destroy(key);
+        assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_PUBLIC));
+    }
+    rnp_ffi_destroy(ffi);
+}
+
 static void
 test_ffi_init(rnp_ffi_t *ffi)
 {
@@ -783,6 +817,172 @@ TEST_F(rnp_tests, test_ffi_keygen_json_pair)
     rnp_ffi_destroy(ffi);
 }
 
+TEST_F(rnp_tests, test_ffi_keygen_json_batch)
+{
+    rnp_ffi_t ffi = NULL;
+    char *    pair = NULL;
+    char *    primary = NULL;
+    char *    sub = NULL;
+    size_t    count = 0;
+
+    // setup FFI
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_set_key_provider(ffi, unused_getkeycb, NULL));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "abc"));
+
+    // load our JSON
+    load_test_data("test_ffi_json/generate-pair.json", &pair, NULL);
+    load_test_data("test_ffi_json/generate-primary.json", &primary, NULL);
+    load_test_data("test_ffi_json/generate-sub.json", &sub, NULL);
+
+    const char *     jsons[] = {pair, primary, "{ broken", sub, pair, primary, NULL};
+    rnp_key_handle_t keys[7] = {};
+    rnp_result_t     results[7] = {};
+    // bad parameters
+    assert_rnp_failure(rnp_generate_keys_json(NULL, jsons, 7, 4, keys, results));
+    assert_rnp_failure(rnp_generate_keys_json(ffi, NULL, 7, 4, keys, results));
+    assert_rnp_failure(rnp_generate_keys_json(ffi, jsons, 7, 4, keys, NULL));
+    assert_rnp_success(rnp_generate_keys_json(ffi, jsons, 0, 4, keys, results));
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(count, 0);
+
+    // generate the keys
+    assert_rnp_success(rnp_generate_keys_json(ffi, jsons, 7, 4, keys, results));
+    assert_rnp_success(results[0]);
+    assert_rnp_success(results[1]);
+    assert_int_equal(results[2], RNP_ERROR_BAD_FORMAT);
+    assert_int_equal(results[3], RNP_ERROR_BAD_PARAMETERS);
+    assert_rnp_success(results[4]);
+    assert_rnp_success(results[5]);
+    assert_int_equal(results[6], RNP_ERROR_NULL_POINTER);
+    for (size_t i = 0; i < 7; i++) {
+        assert_true(!keys[i] == !!results[i]);
+    }
+    free(pair);
+    free(primary);
+    free(sub);
+
+    // check the key counts
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(count, 6);
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 6);
+
+    // check key properties
+    bool   prot = false;
+    size_t subkeys = 0;
+    for (size_t i : {0, 1, 4, 5}) {
+        check_key_properties(keys[i], true, true, true);
+        assert_rnp_success(rnp_key_is_protected(keys[i], &prot));
+        assert_int_equal(prot, !(i % 4));
+        assert_rnp_success(rnp_key_get_subkey_count(keys[i], &subkeys));
+        assert_int_equal(subkeys, !(i % 4));
+    }
+    // keys generated from the same description must differ
+    char *fp1 = NULL;
+    char *fp2 = NULL;
+    assert_rnp_success(rnp_key_get_fprint(keys[0], &fp1));
+    assert_rnp_success(rnp_key_get_fprint(keys[4], &fp2));
+    assert_true(strcmp(fp1, fp2));
+    rnp_buffer_destroy(fp1);
+    rnp_buffer_destroy(fp2);
+
+    // cleanup
+    for (size_t i = 0; i < 7; i++) {
+        rnp_key_handle_destroy(keys[i]);
+    }
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_keygen_pool)
+{
+    rnp_ffi_t ffi = NULL;
+    size_t    count = 0;
+
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    // bad parameters
+    assert_rnp_failure(rnp_ffi_set_key_pool(NULL, "RSA", 1024, 3));
+    assert_rnp_failure(rnp_ffi_set_key_pool(ffi, NULL, 1024, 3));
+    assert_rnp_failure(rnp_ffi_set_key_pool(ffi, "unknown", 1024, 3));
+    assert_rnp_failure(rnp_ffi_set_key_pool(ffi, "ECDSA", 256, 3));
+    assert_rnp_failure(rnp_ffi_set_key_pool(ffi, "RSA", 512, 3));
+    assert_rnp_failure(rnp_ffi_set_key_pool(ffi, "DSA", 4096, 3));
+    assert_rnp_failure(rnp_ffi_get_key_pool_size(NULL, "RSA", 1024, &count));
+    assert_rnp_failure(rnp_ffi_get_key_pool_size(ffi, "RSA", 1024, NULL));
+    assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 1024, &count));
+    assert_int_equal(count, 0);
+    // removing non-existing pool is fine
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 2048, 0));
+
+    // wait until pool is filled
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 1024, 3));
+    for (size_t i = 0; (i < 600) && (count < 3); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 1024, &count));
+    }
+    assert_int_equal(count, 3);
+
+    // generate keys, using the pool
+    std::vector<std::string> fps;
+    for (size_t i = 0; i < 4; i++) {
+        rnp_key_handle_t key = NULL;
+        assert_rnp_success(
+          rnp_generate_key_ex(ffi, "RSA", NULL, 1024, 0, NULL, NULL, "pool", NULL, &key));
+        assert_non_null(key);
+        uint32_t bits = 0;
+        assert_rnp_success(rnp_key_get_bits(key, &bits));
+        assert_int_equal(bits, 1024);
+        bool valid = false;
+        assert_rnp_success(rnp_key_is_valid(key, &valid));
+        assert_true(valid);
+        char *fp = NULL;
+        assert_rnp_success(rnp_key_get_fprint(key, &fp));
+        fps.push_back(fp);
+        rnp_buffer_destroy(fp);
+        rnp_key_handle_destroy(key);
+    }
+    // each pre-generated key is used once
+    for (size_t i = 0; i < fps.size(); i++) {
+        for (size_t j = i + 1; j < fps.size(); j++) {
+            assert_true(fps[i] != fps[j]);
+        }
+    }
+    // key with other size is generated as usual
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(
+      rnp_generate_key_ex(ffi, "RSA", NULL, 1536, 0, NULL, NULL, "nopool", NULL, &key));
+    rnp_key_handle_destroy(key);
+
+    // generation takes the key out of the pool, refill takes much longer than the check
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 2048, 1));
+    count = 0;
+    for (size_t i = 0; (i < 600) && (count < 1); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 2048, &count));
+    }
+    assert_int_equal(count, 1);
+    assert_rnp_success(
+      rnp_generate_key_ex(ffi, "RSA", NULL, 2048, 0, NULL, NULL, "pool2", NULL, &key));
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 2048, &count));
+    assert_int_equal(count, 0);
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 2048, 0));
+
+    // shrink and remove the pool
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 1024, 1));
+    assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 1024, &count));
+    assert_true(count <= 1);
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 1024, 0));
+    assert_rnp_success(rnp_ffi_get_key_pool_size(ffi, "RSA", 1024, &count));
+    assert_int_equal(count, 0);
+
+    // destroy ffi while pool is being filled
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "RSA", 1024, 2));
+    assert_rnp_success(rnp_ffi_set_key_pool(ffi, "DSA", 1024, 2));
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_keygen_json_pair_dsa_elg)
 {
     rnp_ffi_t ffi = NULL;
@@ -3063,6 +3263,433 @@ TEST_F(rnp_tests, test_ffi_signatures_detached)
     assert_rnp_success(rnp_ffi_destroy(ffi));
 }
 
+TEST_F(rnp_tests, test_ffi_verify_detached_batch)
+{
+    rnp_ffi_t ffi = NULL;
+    test_ffi_init(&ffi);
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    /* sign a number of data items */
+    const size_t             count = 24;
+    std::vector<std::string> data(count);
+    std::vector<std::string> sigs(count);
+    std::vector<std::string> keyids(count);
+    for (size_t i = 0; i < count; i++) {
+        data[i] = "data item " + std::to_string(i) + std::string(i * 100, 'x');
+        rnp_input_t      input = NULL;
+        rnp_output_t     output = NULL;
+        rnp_op_sign_t    op = NULL;
+        rnp_key_handle_t key = NULL;
+        uint8_t *        buf = NULL;
+        size_t           len = 0;
+        char *           keyid = NULL;
+        assert_rnp_success(
+          rnp_input_from_memory(&input, (uint8_t *) data[i].data(), data[i].size(), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_sign_detached_create(&op, ffi, input, output));
+        assert_rnp_success(
+          rnp_locate_key(ffi, "userid", i % 2 ? "key0-uid2" : "key1-uid1", &key));
+        assert_rnp_success(rnp_op_sign_add_signature(op, key, NULL));
+        assert_rnp_success(rnp_key_get_keyid(key, &keyid));
+        keyids[i] = keyid;
+        rnp_buffer_destroy(keyid);
+        rnp_key_handle_destroy(key);
+        assert_rnp_success(rnp_op_sign_execute(op));
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+        sigs[i].assign((char *) buf, len);
+        rnp_op_sign_destroy(op);
+        rnp_input_destroy(input);
+        rnp_output_destroy(output);
+    }
+    /* tamper some of the data items */
+    for (size_t i = 0; i < count; i += 5) {
+        data[i][0] ^= 0x20;
+    }
+
+    for (size_t threads : {0, 1, 3, 100}) {
+        std::vector<rnp_input_t>     inputs(count);
+        std::vector<rnp_input_t>     siginputs(count);
+        std::vector<rnp_op_verify_t> ops(count);
+        std::vector<rnp_result_t>    results(count, RNP_ERROR_GENERIC);
+        for (size_t i = 0; i < count; i++) {
+            assert_rnp_success(rnp_input_from_memory(
+              &inputs[i], (uint8_t *) data[i].data(), data[i].size(), false));
+            assert_rnp_success(rnp_input_from_memory(
+              &siginputs[i], (uint8_t *) sigs[i].data(), sigs[i].size(), false));
+            assert_rnp_success(
+              rnp_op_verify_detached_create(&ops[i], ffi, inputs[i], siginputs[i]));
+        }
+        assert_rnp_success(
+          rnp_op_verify_execute_batch(ops.data(), count, threads, results.data()));
+        for (size_t i = 0; i < count; i++) {
+            size_t                    sigcount = 0;
+            rnp_op_verify_signature_t sig = NULL;
+            rnp_key_handle_t          key = NULL;
+            char *                    keyid = NULL;
+            assert_rnp_success(rnp_op_verify_get_signature_count(ops[i], &sigcount));
+            assert_int_equal(sigcount, 1);
+            assert_rnp_success(rnp_op_verify_get_signature_at(ops[i], 0, &sig));
+            assert_rnp_success(rnp_op_verify_signature_get_key(sig, &key));
+            assert_rnp_success(rnp_key_get_keyid(key, &keyid));
+            assert_string_equal(keyid, keyids[i].c_str());
+            rnp_buffer_destroy(keyid);
+            rnp_key_handle_destroy(key);
+            if (i % 5) {
+                assert_rnp_success(results[i]);
+                assert_rnp_success(rnp_op_verify_signature_get_status(sig));
+            } else {
+                assert_int_equal(results[i], RNP_ERROR_SIGNATURE_INVALID);
+                assert_int_equal(rnp_op_verify_signature_get_status(sig),
+                                 RNP_ERROR_SIGNATURE_INVALID);
+            }
+            rnp_op_verify_destroy(ops[i]);
+            rnp_input_destroy(inputs[i]);
+            rnp_input_destroy(siginputs[i]);
+        }
+    }
+
+    /* bad parameters */
+    rnp_op_verify_t ops[2] = {};
+    rnp_result_t    results[2] = {};
+    assert_rnp_success(rnp_op_verify_execute_batch(ops, 0, 0, results));
+    assert_rnp_failure(rnp_op_verify_execute_batch(NULL, 2, 0, results));
+    assert_rnp_failure(rnp_op_verify_execute_batch(ops, 2, 0, NULL));
+    assert_rnp_failure(rnp_op_verify_execute_batch(ops, 2, 0, results));
+    /* operation listed twice or operations sharing the input are rejected before processing */
+    rnp_input_t input = NULL;
+    rnp_input_t sig1 = NULL;
+    rnp_input_t sig2 = NULL;
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) data[1].data(), data[1].size(), false));
+    assert_rnp_success(
+      rnp_input_from_memory(&sig1, (uint8_t *) sigs[1].data(), sigs[1].size(), false));
+    assert_rnp_success(
+      rnp_input_from_memory(&sig2, (uint8_t *) sigs[1].data(), sigs[1].size(), false));
+    assert_rnp_success(rnp_op_verify_detached_create(&ops[0], ffi, input, sig1));
+    ops[1] = ops[0];
+    results[0] = RNP_ERROR_GENERIC;
+    assert_int_equal(rnp_op_verify_execute_batch(ops, 2, 0, results),
+                     RNP_ERROR_BAD_PARAMETERS);
+    assert_int_equal(results[0], RNP_ERROR_GENERIC);
+    assert_rnp_success(rnp_op_verify_detached_create(&ops[1], ffi, input, sig2));
+    assert_int_equal(rnp_op_verify_execute_batch(ops, 2, 0, results),
+                     RNP_ERROR_BAD_PARAMETERS);
+    assert_int_equal(results[0], RNP_ERROR_GENERIC);
+    /* each operation alone is fine */
+    assert_rnp_success(rnp_op_verify_execute_batch(ops, 1, 0, results));
+    assert_rnp_success(results[0]);
+    rnp_op_verify_destroy(ops[0]);
+    rnp_op_verify_destroy(ops[1]);
+    rnp_input_destroy(input);
+    rnp_input_destroy(sig1);
+    rnp_input_destroy(sig2);
+
+    rnp_ffi_destroy(ffi);
+}
+
+TEST_F(rnp_tests, test_ffi_signer)
+{
+    rnp_ffi_t ffi = NULL;
+    rnp_ffi_t ffi2 = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_ffi_create(&ffi2, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key));
+
+    // bad parameters and wrong password
+    rnp_signer_t signer = NULL;
+    assert_rnp_failure(rnp_signer_create(NULL, key, &signer));
+    assert_rnp_failure(rnp_signer_create(ffi, NULL, &signer));
+    assert_rnp_failure(rnp_signer_create(ffi, key, NULL));
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, ffi_failing_password_provider, NULL));
+    assert_int_equal(rnp_signer_create(ffi, key, &signer), RNP_ERROR_BAD_PASSWORD);
+    assert_null(signer);
+    // key is unlocked only once, during the signer creation
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    assert_rnp_success(rnp_signer_create(ffi, key, &signer));
+    assert_non_null(signer);
+    rnp_key_handle_destroy(key);
+    assert_rnp_success(rnp_ffi_set_pass_provider(ffi, ffi_asserting_password_provider, NULL));
+
+    const char *data = "data to sign with the signer";
+    for (size_t i = 0; i < 3; i++) {
+        rnp_input_t   input = NULL;
+        rnp_output_t  output = NULL;
+        rnp_op_sign_t op = NULL;
+        assert_rnp_success(
+          rnp_input_from_memory(&input, (uint8_t *) data, strlen(data), false));
+        assert_rnp_success(rnp_output_to_memory(&output, 0));
+        assert_rnp_success(rnp_op_sign_create(&op, ffi, input, output));
+        assert_rnp_failure(rnp_op_sign_add_signer(NULL, signer, NULL));
+        assert_rnp_failure(rnp_op_sign_add_signer(op, NULL, NULL));
+        rnp_op_sign_signature_t sig = NULL;
+        assert_rnp_success(rnp_op_sign_add_signer(op, signer, &sig));
+        assert_non_null(sig);
+        assert_rnp_success(rnp_op_sign_signature_set_hash(sig, "SHA256"));
+        assert_rnp_success(rnp_op_sign_execute(op));
+        uint8_t *buf = NULL;
+        size_t   len = 0;
+        assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, true));
+        rnp_op_sign_destroy(op);
+        rnp_input_destroy(input);
+        rnp_output_destroy(output);
+
+        // verify the signature
+        rnp_op_verify_t verify = NULL;
+        assert_rnp_success(rnp_input_from_memory(&input, buf, len, false));
+        assert_rnp_success(rnp_output_to_null(&output));
+        assert_rnp_success(rnp_op_verify_create(&verify, ffi, input, output));
+        assert_rnp_success(rnp_op_verify_execute(verify));
+        size_t count = 0;
+        assert_rnp_success(rnp_op_verify_get_signature_count(verify, &count));
+        assert_int_equal(count, 1);
+        rnp_op_verify_signature_t vsig = NULL;
+        assert_rnp_success(rnp_op_verify_get_signature_at(verify, 0, &vsig));
+        assert_rnp_success(rnp_op_verify_signature_get_status(vsig));
+        char *keyid = NULL;
+        assert_rnp_success(rnp_op_verify_signature_get_key(vsig, &key));
+        assert_rnp_success(rnp_key_get_keyid(key, &keyid));
+        assert_string_equal(keyid, "7BC6709B15C23A4A");
+        rnp_buffer_destroy(keyid);
+        rnp_key_handle_destroy(key);
+        rnp_op_verify_destroy(verify);
+        rnp_input_destroy(input);
+        rnp_output_destroy(output);
+        rnp_buffer_destroy(buf);
+    }
+
+    // signer may not be used with the other FFI object
+    rnp_input_t   input = NULL;
+    rnp_output_t  output = NULL;
+    rnp_op_sign_t op = NULL;
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) data, strlen(data), false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_sign_create(&op, ffi2, input, output));
+    assert_rnp_failure(rnp_op_sign_add_signer(op, signer, NULL));
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    // as well as the key of the other FFI object
+    assert_true(
+      load_keys_gpg(ffi2, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(rnp_locate_key(ffi2, "keyid", "7BC6709B15C23A4A", &key));
+    rnp_signer_t signer2 = NULL;
+    assert_int_equal(rnp_signer_create(ffi, key, &signer2), RNP_ERROR_BAD_PARAMETERS);
+    assert_null(signer2);
+    rnp_key_handle_destroy(key);
+
+    // signing key is looked up again, so unloaded key is reported
+    assert_rnp_success(rnp_input_from_memory(&input, (uint8_t *) data, strlen(data), false));
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_sign_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_unload_keys(ffi, RNP_KEY_UNLOAD_SECRET));
+    assert_int_equal(rnp_op_sign_add_signer(op, signer, NULL), RNP_ERROR_KEY_NOT_FOUND);
+    assert_true(load_keys_gpg(ffi, "", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(rnp_op_sign_add_signer(op, signer, NULL));
+    assert_rnp_success(rnp_op_sign_execute(op));
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+
+    assert_rnp_success(rnp_signer_destroy(signer));
+    assert_rnp_success(rnp_signer_destroy(NULL));
+    rnp_ffi_destroy(ffi);
+    rnp_ffi_destroy(ffi2);
+}
+
+TEST_F(rnp_tests, test_ffi_signer_digests)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key));
+    rnp_signer_t signer = NULL;
+    rnp_signer_t signer2 = NULL;
+    assert_rnp_success(rnp_signer_create(ffi, key, &signer));
+    assert_rnp_success(rnp_signer_create(ffi, key, &signer2));
+    rnp_key_handle_destroy(key);
+
+    // bad parameters
+    rnp_digest_t digest = NULL;
+    assert_rnp_failure(rnp_signer_digest_create(NULL, "SHA256", &digest));
+    assert_rnp_failure(rnp_signer_digest_create(signer, NULL, &digest));
+    assert_rnp_failure(rnp_signer_digest_create(signer, "SHA256", NULL));
+    assert_rnp_failure(rnp_signer_digest_create(signer, "WRONG", &digest));
+    assert_rnp_success(rnp_signer_digest_create(signer, "SHA256", &digest));
+    assert_rnp_failure(rnp_digest_update(NULL, (uint8_t *) "a", 1));
+    assert_rnp_failure(rnp_digest_update(digest, NULL, 1));
+    assert_rnp_success(rnp_digest_update(digest, NULL, 0));
+    assert_rnp_success(rnp_digest_destroy(digest));
+    assert_rnp_success(rnp_digest_destroy(NULL));
+    rnp_result_t result = RNP_SUCCESS;
+    assert_rnp_failure(rnp_signer_sign_digests(NULL, &digest, 1, 1, NULL, &result));
+    assert_int_equal(rnp_signer_sign_digests(signer, NULL, 0, 1, NULL, NULL),
+                     RNP_ERROR_NULL_POINTER);
+
+    // hash data in chunks and sign all of the digests at once
+    const size_t              count = 12;
+    std::vector<std::string>  datas(count);
+    std::vector<rnp_digest_t> digests(count);
+    std::vector<rnp_output_t> outputs(count);
+    std::vector<rnp_result_t> results(count);
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = 0; j <= i * 100; j++) {
+            datas[i] += "chunk " + std::to_string(j) + " of the artifact " + std::to_string(i);
+        }
+        assert_rnp_success(rnp_signer_digest_create(
+          i == count - 1 ? signer2 : signer, i % 2 ? "SHA256" : "SHA512", &digests[i]));
+        for (size_t pos = 0; pos < datas[i].size(); pos += 1000) {
+            size_t len = std::min(datas[i].size() - pos, (size_t) 1000);
+            assert_rnp_success(
+              rnp_digest_update(digests[i], (uint8_t *) datas[i].data() + pos, len));
+        }
+        assert_rnp_success(rnp_output_to_memory(&outputs[i], 0));
+    }
+    assert_rnp_success(rnp_signer_sign_digests(
+      signer, digests.data(), count, 4, outputs.data(), results.data()));
+    // last digest belongs to the other signer
+    assert_int_equal(results[count - 1], RNP_ERROR_BAD_PARAMETERS);
+
+    for (size_t i = 0; i < count - 1; i++) {
+        assert_rnp_success(results[i]);
+        uint8_t *buf = NULL;
+        size_t   len = 0;
+        assert_rnp_success(rnp_output_memory_get_buf(outputs[i], &buf, &len, false));
+        rnp_input_t     source = NULL;
+        rnp_input_t     signature = NULL;
+        rnp_op_verify_t verify = NULL;
+        assert_rnp_success(rnp_input_from_memory(
+          &source, (uint8_t *) datas[i].data(), datas[i].size(), false));
+        assert_rnp_success(rnp_input_from_memory(&signature, buf, len, false));
+        assert_rnp_success(rnp_op_verify_detached_create(&verify, ffi, source, signature));
+        assert_rnp_success(rnp_op_verify_execute(verify));
+        rnp_op_verify_signature_t sig = NULL;
+        assert_rnp_success(rnp_op_verify_get_signature_at(verify, 0, &sig));
+        assert_rnp_success(rnp_op_verify_signature_get_status(sig));
+        char *hash = NULL;
+        assert_rnp_success(rnp_op_verify_signature_get_hash(sig, &hash));
+        assert_string_equal(hash, i % 2 ? "SHA256" : "SHA512");
+        rnp_buffer_destroy(hash);
+        rnp_op_verify_destroy(verify);
+        rnp_input_destroy(source);
+        rnp_input_destroy(signature);
+    }
+    for (size_t i = 0; i < count; i++) {
+        rnp_output_destroy(outputs[i]);
+        rnp_digest_destroy(digests[i]);
+    }
+    rnp_signer_destroy(signer);
+    rnp_signer_destroy(signer2);
+    rnp_ffi_destroy(ffi);
+}
+
+static std::string
+sign_detached_with(rnp_ffi_t ffi, const char *keyid, const std::string &data, bool armor)
+{
+    rnp_input_t      input = NULL;
+    rnp_output_t     output = NULL;
+    rnp_op_sign_t    op = NULL;
+    rnp_key_handle_t key = NULL;
+    std::string      res;
+    uint8_t *        buf = NULL;
+    size_t           len = 0;
+
+    assert_rnp_success(
+      rnp_input_from_memory(&input, (uint8_t *) data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_op_sign_detached_create(&op, ffi, input, output));
+    assert_rnp_success(rnp_op_sign_set_armor(op, armor));
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", keyid, &key));
+    assert_rnp_success(rnp_op_sign_add_signature(op, key, NULL));
+    assert_rnp_success(rnp_op_sign_execute(op));
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    res.assign((char *) buf, len);
+    rnp_key_handle_destroy(key);
+    rnp_op_sign_destroy(op);
+    rnp_input_destroy(input);
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_verify_detached_multiple)
+{
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(
+      load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg", "data/keyrings/1/secring.gpg"));
+    assert_rnp_success(
+      rnp_ffi_set_pass_provider(ffi, ffi_string_password_provider, (void *) "password"));
+
+    std::string data;
+    for (size_t i = 0; i < 10000; i++) {
+        data += "line " + std::to_string(i) + " of the large signed file\n";
+    }
+    /* first input has two signatures, third one is made over the other data */
+    std::string sigs[] = {sign_detached_with(ffi, "7BC6709B15C23A4A", data, false) +
+                            sign_detached_with(ffi, "2FCADF05FFA501BB", data, false),
+                          sign_detached_with(ffi, "2FCADF05FFA501BB", data, true),
+                          sign_detached_with(ffi, "7BC6709B15C23A4A", data + "\n", true)};
+
+    rnp_input_t     source = NULL;
+    rnp_input_t     siginputs[3] = {};
+    rnp_op_verify_t verify = NULL;
+    assert_rnp_success(
+      rnp_input_from_memory(&source, (uint8_t *) data.data(), data.size(), false));
+    for (size_t i = 0; i < 3; i++) {
+        assert_rnp_success(rnp_input_from_memory(
+          &siginputs[i], (uint8_t *) sigs[i].data(), sigs[i].size(), false));
+    }
+    assert_rnp_success(rnp_op_verify_detached_create(&verify, ffi, source, siginputs[0]));
+    assert_rnp_failure(rnp_op_verify_add_detached_signature(NULL, siginputs[1]));
+    assert_rnp_failure(rnp_op_verify_add_detached_signature(verify, NULL));
+    assert_rnp_success(rnp_op_verify_add_detached_signature(verify, siginputs[1]));
+    assert_rnp_success(rnp_op_verify_add_detached_signature(verify, siginputs[2]));
+    /* one of the signatures is invalid */
+    assert_rnp_failure(rnp_op_verify_execute(verify));
+
+    size_t count = 0;
+    assert_rnp_success(rnp_op_verify_get_signature_count(verify, &count));
+    assert_int_equal(count, 4);
+    size_t       indexes[] = {0, 0, 1, 2};
+    rnp_result_t statuses[] = {
+      RNP_SUCCESS, RNP_SUCCESS, RNP_SUCCESS, RNP_ERROR_SIGNATURE_INVALID};
+    for (size_t i = 0; i < count; i++) {
+        rnp_op_verify_signature_t sig = NULL;
+        assert_rnp_success(rnp_op_verify_get_signature_at(verify, i, &sig));
+        size_t index = 100;
+        assert_rnp_failure(rnp_op_verify_signature_get_input_index(sig, NULL));
+        assert_rnp_success(rnp_op_verify_signature_get_input_index(sig, &index));
+        assert_int_equal(index, indexes[i]);
+        assert_int_equal(rnp_op_verify_signature_get_status(sig), statuses[i]);
+    }
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(source);
+    for (auto input : siginputs) {
+        rnp_input_destroy(input);
+    }
+
+    /* additional signature input cannot be added to the non-detached verification */
+    assert_rnp_success(rnp_input_from_memory(
+      &siginputs[0], (uint8_t *) sigs[0].data(), sigs[0].size(), false));
+    rnp_output_t output = NULL;
+    assert_rnp_success(rnp_output_to_null(&output));
+    assert_rnp_success(rnp_op_verify_create(&verify, ffi, siginputs[0], output));
+    assert_rnp_failure(rnp_op_verify_add_detached_signature(verify, siginputs[0]));
+    rnp_op_verify_destroy(verify);
+    rnp_input_destroy(siginputs[0]);
+    rnp_output_destroy(output);
+
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_signatures_dump)
 {
     rnp_ffi_t       ffi = NULL;
@@ -3802,6 +4429,34 @@ TEST_F(rnp_tests, test_ffi_key_iter)
         assert_rnp_success(rnp_identifier_iterator_destroy(it));
     }
 
+    // fingerprint
+    {
+        rnp_identifier_iterator_t it = NULL;
+        assert_rnp_success(rnp_identifier_iterator_create(ffi, &it, "fingerprint"));
+        assert_non_null(it);
+        {
+            static const char *expected[] = {"E95A3CBF583AA80A2CCC53AA7BC6709B15C23A4A",
+                                             "E332B27CAF4742A11BAA677F1ED63EE56FADC34D",
+                                             "C5B15209940A7816A7AF3FB51D7E8A5393C997A8",
+                                             "5CD46D2A0BD0B8CFE0B130AE8A05B89FAD5ADED1",
+                                             "BE1C4AB951F4C2F6B604C7F82FCADF05FFA501BB",
+                                             "A3E94DE61A8CB229413D348E54505A936A4A970E",
+                                             "57F8ED6E5C197DB63C60FFAF326EF111425D14A5"};
+            size_t             i = 0;
+            const char *       ident = NULL;
+            do {
+                ident = NULL;
+                assert_rnp_success(rnp_identifier_iterator_next(it, &ident));
+                if (ident) {
+                    assert_int_equal(0, rnp_strcasecmp(expected[i], ident));
+                    i++;
+                }
+            } while (ident);
+            assert_int_equal(i, ARRAY_SIZE(expected));
+        }
+        assert_rnp_success(rnp_identifier_iterator_destroy(it));
+    }
+
     // userid
     {
         rnp_identifier_iterator_t it = NULL;
@@ -5146,6 +5801,183 @@ TEST_F(rnp_tests, test_ffi_pkt_dump)
     rnp_ffi_destroy(ffi);
 }
 
+static std::string
+reformat_json(const std::string &json)
+{
+    json_object *jso = json_tokener_parse(json.c_str());
+    std::string  res;
+    if (jso) {
+        res = json_object_to_json_string_ext(jso, JSON_C_TO_STRING_PLAIN);
+    }
+    json_object_put(jso);
+    return res;
+}
+
+static bool
+check_json_dump_output(const char *path, uint32_t flags)
+{
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    char *       json = NULL;
+    uint8_t *    buf = NULL;
+    size_t       len = 0;
+
+    assert_rnp_success(rnp_input_from_path(&input, path));
+    assert_rnp_success(rnp_dump_packets_to_json(input, flags, &json));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_input_from_path(&input, path));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_success(rnp_dump_packets_to_json_output(input, output, flags));
+    rnp_input_destroy(input);
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    std::string expected = reformat_json(json);
+    std::string streamed = reformat_json(std::string(buf, buf + len));
+    rnp_buffer_destroy(json);
+    rnp_output_destroy(output);
+    return !expected.empty() && (expected == streamed);
+}
+
+TEST_F(rnp_tests, test_ffi_pkt_dump_json_output)
+{
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+
+    // try with wrong parameters
+    assert_rnp_success(rnp_input_from_path(&input, "data/keyrings/1/pubring.gpg"));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_failure(rnp_dump_packets_to_json_output(input, NULL, 0));
+    assert_rnp_failure(rnp_dump_packets_to_json_output(NULL, output, 0));
+    assert_rnp_failure(rnp_dump_packets_to_json_output(input, output, 117));
+    rnp_output_destroy(output);
+    rnp_input_destroy(input);
+
+    // streamed dump must be the same as the one built in memory
+    uint32_t flags = RNP_JSON_DUMP_MPI | RNP_JSON_DUMP_RAW | RNP_JSON_DUMP_GRIP;
+    assert_true(check_json_dump_output("data/keyrings/1/pubring.gpg", 0));
+    assert_true(check_json_dump_output("data/keyrings/1/pubring.gpg", flags));
+    assert_true(check_json_dump_output("data/keyrings/1/secring.gpg", flags));
+    assert_true(check_json_dump_output("data/test_messages/message.txt.signed", flags));
+    assert_true(
+      check_json_dump_output("data/test_messages/message.txt.cleartext-signed", flags));
+    assert_true(check_json_dump_output("data/test_messages/message.txt.marker", flags));
+    assert_true(check_json_dump_output("data/test_messages/message.compr.128-rounds", 0));
+    assert_true(check_json_dump_output("data/keyrings/4/rsav3-p.asc", flags));
+
+    // key to json output
+    rnp_ffi_t ffi = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg"));
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    assert_rnp_failure(rnp_key_to_json_output(NULL, output, 0xff));
+    assert_rnp_failure(rnp_key_to_json_output(key, NULL, 0xff));
+    char *json = NULL;
+    assert_rnp_success(rnp_key_to_json(key, 0xff, &json));
+    assert_rnp_success(rnp_key_to_json_output(key, output, 0xff));
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &buf, &len, false));
+    assert_int_equal(len, strlen(json));
+    assert_int_equal(memcmp(buf, json, len), 0);
+    rnp_buffer_destroy(json);
+    rnp_output_destroy(output);
+    rnp_key_handle_destroy(key);
+    rnp_ffi_destroy(ffi);
+}
+
+static std::vector<std::string>
+key_list_lines(rnp_ffi_t ffi, const char *fields, uint32_t flags)
+{
+    std::vector<std::string> res;
+    rnp_output_t             output = NULL;
+    if (rnp_output_to_memory(&output, 0)) {
+        return res;
+    }
+    uint8_t *buf = NULL;
+    size_t   len = 0;
+    if (!rnp_key_list_to_output(ffi, fields, output, flags) &&
+        !rnp_output_memory_get_buf(output, &buf, &len, false)) {
+        std::istringstream stream(std::string((char *) buf, len));
+        std::string        line;
+        while (std::getline(stream, line)) {
+            res.push_back(line);
+        }
+    }
+    rnp_output_destroy(output);
+    return res;
+}
+
+TEST_F(rnp_tests, test_ffi_key_list_output)
+{
+    rnp_ffi_t    ffi = NULL;
+    rnp_output_t output = NULL;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    // try with wrong parameters
+    assert_rnp_failure(rnp_key_list_to_output(NULL, NULL, output, 0));
+    assert_rnp_failure(rnp_key_list_to_output(ffi, NULL, NULL, 0));
+    assert_rnp_failure(rnp_key_list_to_output(ffi, NULL, output, 0x80));
+    assert_rnp_failure(rnp_key_list_to_output(ffi, "keyid,unknown", output, 0));
+    assert_rnp_failure(rnp_key_list_to_output(ffi, "", output, 0));
+    rnp_output_destroy(output);
+    // empty keyrings: header only
+    auto lines = key_list_lines(ffi, "keyid,uid", 0);
+    assert_int_equal(lines.size(), 1);
+    assert_string_equal(lines[0].c_str(), "keyid\tuid");
+    assert_true(key_list_lines(ffi, "keyid", RNP_KEY_LIST_NO_HEADER).empty());
+
+    // public keys only
+    assert_true(load_keys_gpg(ffi, "data/keyrings/1/pubring.gpg"));
+    lines = key_list_lines(ffi, "keyid,primary,secret,uid", 0);
+    assert_int_equal(lines.size(), 8);
+    assert_string_equal(lines[1].c_str(), "7BC6709B15C23A4A\t1\t0\tkey0-uid0");
+    assert_string_equal(lines[2].c_str(), "1ED63EE56FADC34D\t0\t0\t");
+    // all fields must be listed by default, and each line must have the same field count
+    lines = key_list_lines(ffi, NULL, 0);
+    assert_int_equal(lines.size(), 8);
+    for (auto &line : lines) {
+        assert_int_equal(std::count(line.begin(), line.end(), '\t'), 14);
+    }
+    // secret keys are matched to the public ones
+    assert_true(load_keys_gpg(ffi, "", "data/keyrings/1/secring.gpg"));
+    lines = key_list_lines(ffi, "KeyID,Secret", RNP_KEY_LIST_NO_HEADER);
+    assert_int_equal(lines.size(), 7);
+    assert_string_equal(lines[0].c_str(), "7BC6709B15C23A4A\t1");
+
+    // JSON lines, each must be parseable and contain the same data as the key handle
+    lines = key_list_lines(ffi, NULL, RNP_KEY_LIST_JSON);
+    assert_int_equal(lines.size(), 7);
+    for (auto &line : lines) {
+        json_object *jso = json_tokener_parse(line.c_str());
+        assert_non_null(jso);
+        json_object *fld = NULL;
+        assert_true(json_object_object_get_ex(jso, "fingerprint", &fld));
+        rnp_key_handle_t key = NULL;
+        assert_rnp_success(
+          rnp_locate_key(ffi, "fingerprint", json_object_get_string(fld), &key));
+        assert_non_null(key);
+        bool primary = false;
+        assert_rnp_success(rnp_key_is_primary(key, &primary));
+        assert_true(json_object_object_get_ex(jso, "primary", &fld));
+        assert_int_equal(json_object_get_boolean(fld), primary);
+        char *alg = NULL;
+        assert_rnp_success(rnp_key_get_alg(key, &alg));
+        assert_true(json_object_object_get_ex(jso, "alg", &fld));
+        assert_string_equal(json_object_get_string(fld), alg);
+        rnp_buffer_destroy(alg);
+        uint32_t bits = 0;
+        assert_rnp_success(rnp_key_get_bits(key, &bits));
+        assert_true(json_object_object_get_ex(jso, "bits", &fld));
+        assert_int_equal(json_object_get_int(fld), bits);
+        assert_true(json_object_object_get_ex(jso, "primary_grip", &fld));
+        assert_int_equal(fld == NULL, primary);
+        rnp_key_handle_destroy(key);
+        json_object_put(jso);
+    }
+    rnp_ffi_destroy(ffi);
+}
+
 TEST_F(rnp_tests, test_ffi_rsa_v3_dump)
 {
     rnp_input_t input = NULL;
@@ -707,3 +707,81 @@ TEST_F(rnp_tests, test_key_expiry_direct_sig)
     delete secring;
     delete pubring;
 }
+
+TEST_F(rnp_tests, test_key_validate_batch)
+{
+    rnp_key_store_t *pubring = new rnp_key_store_t(PGP_KEY_STORE_GPG, "");
+    key_store_add(pubring, DATA_PATH "dsa-eg-pub-forged-key.pgp");
+    key_store_add(pubring, DATA_PATH "ecc-25519-pub-forged-key.pgp");
+    key_store_add(pubring, DATA_PATH "ecc-p256-pub-expired-key.pgp");
+    rnp_key_store_t *ring1 =
+      new rnp_key_store_t(PGP_KEY_STORE_GPG, "data/keyrings/1/pubring.gpg");
+    assert_true(rnp_key_store_load_from_path(ring1, NULL));
+
+    /* remember results of the sequential validation and reset them */
+    std::vector<pgp_validity_t> expected;
+    pgp_sig_batch_t             batch;
+    size_t                      invalid = 0;
+    for (auto *ring : {pubring, ring1}) {
+        for (auto &key : ring->keys) {
+            for (size_t idx = 0; idx < key.sig_count(); idx++) {
+                key.get_sig(idx).validity.reset();
+            }
+        }
+        for (auto &key : ring->keys) {
+            if (key.is_primary()) {
+                key.add_self_signatures(batch);
+                continue;
+            }
+            pgp_key_t *primary = rnp_key_store_get_primary_key(ring, &key);
+            assert_non_null(primary);
+            key.add_self_signatures(batch, *primary);
+        }
+    }
+    size_t count = batch.size();
+    assert_true(count > 0);
+    /* sequential run */
+    batch.validate();
+    assert_int_equal(batch.size(), 0);
+    for (auto *ring : {pubring, ring1}) {
+        for (auto &key : ring->keys) {
+            for (size_t idx = 0; idx < key.sig_count(); idx++) {
+                pgp_subsig_t &sig = key.get_sig(idx);
+                expected.push_back(sig.validity);
+                invalid += sig.validity.validated && !sig.validity.valid;
+                sig.validity.reset();
+            }
+        }
+    }
+    assert_true(invalid > 0);
+
+    /* parallel run must give the same results */
+    for (auto *ring : {pubring, ring1}) {
+        for (auto &key : ring->keys) {
+            if (key.is_primary()) {
+                key.add_self_signatures(batch);
+                continue;
+            }
+            key.add_self_signatures(batch, *rnp_key_store_get_primary_key(ring, &key));
+        }
+    }
+    assert_int_equal(batch.size(), count);
+    batch.validate(8);
+    size_t idx = 0;
+    for (auto *ring : {pubring, ring1}) {
+        for (auto &key : ring->keys) {
+            for (size_t sidx = 0; sidx < key.sig_count(); sidx++) {
+                const pgp_subsig_t &sig = key.get_sig(sidx);
+                assert_true(idx < expected.size());
+                assert_int_equal(sig.validity.validated, expected[idx].validated);
+                assert_int_equal(sig.validity.valid, expected[idx].valid);
+                assert_int_equal(sig.validity.expired, expected[idx].expired);
+                idx++;
+            }
+        }
+    }
+    assert_int_equal(idx, expected.size());
+
+    delete pubring;
+    delete ring1;
+}
@@ -0,0 +1,85 @@
+/*-
+ * Copyright (c) 2021 Ribose Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+#include "rnp_tests.h"
+#include "support.h"
+#include "../benchmarks/keyring-gen.h"
+
+TEST_F(rnp_tests, test_keyring_gen_counts)
+{
+    rnp_bench::keyring_gen_params_t params;
+    params.primaries = 4;
+    params.subkeys = 2;
+    params.userids = 3;
+    params.density = 0.5;
+    params.fast = true;
+
+    pgp_key_sequence_t keys;
+    assert_true(rnp_bench::keyring_generate(params, keys));
+    assert_int_equal(keys.keys.size(), 4);
+    char *dir = make_temp_dir();
+    assert_non_null(dir);
+    std::string path(dir);
+    free(dir);
+    assert_true(rnp_bench::keyring_write(keys, path, PGP_KEY_STORE_GPG));
+
+    /* load generated keyring back */
+    rnp_ffi_t ffi = NULL;
+    size_t    count = 0;
+    assert_rnp_success(rnp_ffi_create(&ffi, "GPG", "GPG"));
+    assert_true(load_keys_gpg(ffi, path + "/pubring.gpg", path + "/secring.gpg"));
+    assert_rnp_success(rnp_get_public_key_count(ffi, &count));
+    assert_int_equal(count, 4 * (1 + 2));
+    assert_rnp_success(rnp_get_secret_key_count(ffi, &count));
+    assert_int_equal(count, 4 * (1 + 2));
+
+    /* each userid has self-signature and round(0.5 * (4 - 1)) = 2 certifications */
+    for (size_t i = 0; i < 4; i++) {
+        std::string      id = std::to_string(i) + ".0";
+        std::string      uid = "keyring-gen " + id + " <key" + id + "@example.com>";
+        rnp_key_handle_t key = NULL;
+        assert_rnp_success(rnp_locate_key(ffi, "userid", uid.c_str(), &key));
+        assert_non_null(key);
+        assert_rnp_success(rnp_key_get_subkey_count(key, &count));
+        assert_int_equal(count, 2);
+        assert_rnp_success(rnp_key_get_uid_count(key, &count));
+        assert_int_equal(count, 3);
+        for (size_t j = 0; j < 3; j++) {
+            rnp_uid_handle_t uidh = NULL;
+            assert_rnp_success(rnp_key_get_uid_handle_at(key, j, &uidh));
+            assert_rnp_success(rnp_uid_get_signature_count(uidh, &count));
+            assert_int_equal(count, 1 + 2);
+            bool valid = false;
+            assert_rnp_success(rnp_uid_is_valid(uidh, &valid));
+            assert_true(valid);
+            rnp_uid_handle_destroy(uidh);
+        }
+        rnp_key_handle_destroy(key);
+    }
+    rnp_ffi_destroy(ffi);
+    delete_recursively(path.c_str());
+}
@@ -226,3 +226,78 @@ TEST_F(rnp_tests, test_partial_length_first_packet_length)
     assert_rnp_success(rnp_output_destroy(output));
     assert_rnp_success(rnp_ffi_destroy(ffi));
 }
+
+static void
+test_partial_length_sign(rnp_ffi_t ffi, rnp_input_t input, rnp_output_t output)
+{
+    rnp_op_sign_t    sign = NULL;
+    rnp_key_handle_t key = NULL;
+    assert_rnp_success(rnp_op_sign_create(&sign, ffi, input, output));
+    assert_rnp_success(rnp_locate_key(ffi, "keyid", "7BC6709B15C23A4A", &key));
+    assert_rnp_success(rnp_op_sign_add_signature(sign, key, NULL));
+    assert_rnp_success(rnp_key_handle_destroy(key));
+    assert_rnp_success(rnp_op_sign_execute(sign));
+    assert_rnp_success(rnp_op_sign_destroy(sign));
+}
+
+TEST_F(rnp_tests, test_partial_length_growing_parts)
+{
+    rnp_ffi_t    ffi = NULL;
+    rnp_input_t  input = NULL;
+    rnp_output_t output = NULL;
+    size_t       datalen = 5 * 1024 * 1024 + 123;
+    test_partial_length_init(&ffi, RNP_LOAD_SAVE_SECRET_KEYS);
+    // callback source, so size is not known in advance
+    dummy_reader_ctx_st reader_ctx;
+    reader_ctx.dummy = 'X';
+    reader_ctx.remaining = datalen;
+    assert_rnp_success(rnp_input_from_callback(&input, dummy_reader, NULL, &reader_ctx));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    test_partial_length_sign(ffi, input, output);
+
+    pgp_source_t src;
+    uint8_t *    mem = NULL;
+    size_t       len = 0;
+    assert_rnp_success(rnp_output_memory_get_buf(output, &mem, &len, false));
+    assert_rnp_success(init_mem_src(&src, mem, len, false));
+    pgp_packet_body_t body(PGP_PKT_ONE_PASS_SIG);
+    assert_rnp_success(body.read(src));
+    uint8_t flags = 0;
+    assert_true(src_read_eq(&src, &flags, 1));
+    assert_int_equal(flags, PGP_PTAG_ALWAYS_SET | PGP_PTAG_NEW_FORMAT | PGP_PKT_LITDATA);
+    // part sizes should double from 8k up to 1M
+    size_t expected = 8192;
+    size_t total = 0;
+    bool   last = false;
+    while (!last) {
+        assert_true(stream_read_partial_chunk_len(&src, &len, &last));
+        if (!last) {
+            assert_int_equal(len, expected);
+            expected = std::min(expected * 2, (size_t) 1024 * 1024);
+        }
+        src_skip(&src, len);
+        total += len;
+    }
+    // literal data header: format, filename length, timestamp
+    assert_int_equal(total, datalen + 6);
+    src_close(&src);
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+
+    // now the same but from memory, which should result in definite-length packet
+    std::vector<uint8_t> data(datalen, 'X');
+    assert_rnp_success(rnp_input_from_memory(&input, data.data(), data.size(), false));
+    assert_rnp_success(rnp_output_to_memory(&output, 0));
+    test_partial_length_sign(ffi, input, output);
+    assert_rnp_success(rnp_output_memory_get_buf(output, &mem, &len, false));
+    assert_rnp_success(init_mem_src(&src, mem, len, false));
+    pgp_packet_body_t onepass(PGP_PKT_ONE_PASS_SIG);
+    assert_rnp_success(onepass.read(src));
+    assert_false(stream_partial_pkt_len(&src));
+    assert_true(stream_read_pkt_len(&src, &len));
+    assert_int_equal(len, datalen + 6);
+    src_close(&src);
+    assert_rnp_success(rnp_input_destroy(input));
+    assert_rnp_success(rnp_output_destroy(output));
+    assert_rnp_success(rnp_ffi_destroy(ffi));
+}